@@ -0,0 +1,988 @@
+############################################################################################
+# Codec Helper
+############################################################################################
+# October 2026: line parsing shared between chart and headless acquisition
+# October 2026: COBS and SLIP framed binary packets
+# October 2026: packet layout with named fields and checksum
+# October 2026: raw interleaved sample stream
+# October 2026: line checksum validation
+# October 2026: sequence number gap detection
+# October 2026: device timestamps mapped to host time
+# October 2026: baud rate scoring for automatic detection
+# October 2026: incremental text decoding
+# ------------------------------------------------------------------------------------------
+# Urs Utzinger
+# University of Arizona 2026
+############################################################################################
+############################################################################################
+# This code has no QT dependencies.
+# It converts what QSerial receives (bytes or lists of bytes) into numpy arrays of samples
+# so that it can be used by the chart in the main thread as well as by the headless
+# acquisition without creating any widgets.
+#
+# Text lines need about 3 times more bytes per sample than binary data. Binary packets
+# are delimited with COBS (0x00 ends a packet, zeros in the packet are encoded) or
+# SLIP (0xC0 ends a packet, 0xC0 and 0xDB in the packet are escaped). FrameDecoder
+# decodes a batch of received bytes at once with numpy, partial packets are carried
+# over to the next batch. packets_to_array converts packets into samples.
+#
+# PacketLayout describes the fields of a packet. It is created from a text:
+#
+#   <hhhh                       struct format, fields are named f0, f1 ...
+#   >3hfB; checksum=sum8        big endian, 3 int16, float32, trailing 1 byte checksum
+#   ax:i2 ay:i2 az:i2 t:f4      named fields, numpy or struct type codes, little endian
+#   ax:i2 ay:i2 crc:>u2; channels=ay,ax; checksum=crc16
+#                               chart shows ay and ax, CRC-16 is big endian
+#
+# All packets of a batch are converted with one np.frombuffer into a structured array,
+# the checksums of all packets are computed column by column over the batch.
+# Checksums cover all bytes in front of the checksum field:
+#   sum8    sum of bytes modulo 256         xor8    exclusive or of bytes
+#   crc8    polynomial 0x07, initial 0      crc16   polynomial 0x1021, initial 0 (XMODEM)
+#
+# SampleStream interprets data without line termination or framing as interleaved samples
+# of N channels, e.g. int16 ch0 ch1 ch2 ch0 ch1 ch2 ... Bytes of an incomplete set of
+# samples at the end of a chunk are carried over to the next chunk so that alignment is
+# kept. The stream needs to start at the first byte of a sample of channel 0.
+#
+# check_block validates a checksum at the end of each line of text:
+#   $GPGLL,4916.45,N*2D     xor     exclusive or of bytes between $ and *, 2 hex digits (NMEA)
+#   12,34,56*A1             crc8    CRC-8 of bytes before *, 2 hex digits
+#   12,34,56*3F0C           crc16   CRC-16 of bytes before *, 4 hex digits
+# It works on the received block of complete lines before it is split into lines, all
+# lines are checked with a few numpy calls. The exclusive or of each line is one reduceat
+# at the line starts, the * hex digits and termination are removed with a table of digit
+# pairs. CRCs with initial value 0 are linear: the CRC of a line is the exclusive or of
+# the CRCs of each byte followed by its distance to the * in zero bytes. crc_positions
+# holds these per distance and byte, one take and one reduceat give the CRCs of all lines
+# which are compared as hex text with the received digits. When all lines pass, the digits
+# are zeroed and the block is split at * zeros termination, otherwise failed lines and
+# checksum suffixes are removed before the split. The check replaces that split, at 40k
+# lines/s (about 1100 lines per read every 28 ms) it adds 6% (xor) to 9% (CRC-16) to split
+# and parse of the lines. 200-line blocks only occur with UARTs above 4 Mbaud where the
+# read interval is 5 ms, the fixed cost of the numpy calls makes it 12-18% there.
+#
+# SequenceCounter checks a column with a counter the device increments for every line or
+# packet. The differences of consecutive counter values are computed for the whole batch:
+#   1       expected                        0       duplicate
+#   n > 1   gap, n-1 rows were lost         < 0     reset, e.g. device restarted
+# With modulo the counter wraps around, e.g. 65536 for a uint16 counter, and a jump back
+# by less than half of modulo is a reset.
+#
+# DeviceClock converts a column with timestamps of the device clock, e.g. microseconds of a
+# 32 bit counter that wraps around every 71 minutes, into host time. Each batch adds the
+# newest timestamp and the host time it arrived to a running linear fit
+#   host = offset + (1 + drift)*device
+# with exponential forgetting. Batching and scheduling delays of the host scatter around
+# the fitted line and no longer distort the time axis, the timestamps of several devices
+# are on the same host time base.
+#
+# score_baud rates bytes received at a candidate baud rate. At the wrong rate the receiver
+# samples the bits at the wrong times, text turns into bytes with the high bit set, stop
+# bits are missed (framing errors are delivered as 0x00) and line terminations disappear:
+#   printable ratio + line termination frequency - framing error ratio
+# Text received at the right rate scores close to 2, garbage about 0.5 or less.
+#
+# TextDecoder turns received bytes into text. The receiver delivers whatever arrived, a
+# multi byte character (e.g. ° or µ in UTF-8) can be split across two batches. An incremental
+# decoder keeps the incomplete tail and completes it with the next batch. Invalid bytes,
+# e.g. noise at the wrong baud rate, are replaced by U+FFFD instead of dropping the batch.
+# Most devices send ASCII, pure ASCII batches are converted without the incremental decoder
+# and its state when it holds no incomplete character. Complete lines are joined and decoded
+# with one call, decoding line by line costs about 7 times more.
+############################################################################################
+############################################################################################
+# Helpful readings:
+# ------------------------------------------------------------------------------------------
+# Consistent Overhead Byte Stuffing, Cheshire and Baker
+#      https://en.wikipedia.org/wiki/Consistent_Overhead_Byte_Stuffing
+# SLIP
+#      https://datatracker.ietf.org/doc/html/rfc1055
+############################################################################################
+
+import logging, re, codecs
+
+# Numerical Math
+import numpy as np
+
+# Constants
+########################################################################################
+TIME_UNITS = {                                                                             # device timestamp unit to seconds
+    "us": 1e-6,
+    "ms": 1e-3,
+    "s":  1.,
+}
+FIT_TIME_CONSTANT = 60.                                                                    # [s] clock fit forgets older batches
+DATA_SEPARATORS = {                                                                        # names used in UI and on command line
+    "comma (,)":     b',',
+    "semicolon (;)": b';',
+    "point (.)":     b'.',
+    "space (\\s)":   b' ',
+}
+FRAMINGS = {                                                                               # names used in UI for binary framing
+    "COBS (\\x00)":   "cobs",
+    "SLIP (\\xC0)":   "slip",
+}
+PACKET_DTYPE = np.dtype('<i2')                                                             # default sample type of binary packets
+SLIP_END, SLIP_ESC, SLIP_ESC_END, SLIP_ESC_ESC = 0xC0, 0xDB, 0xDC, 0xDD
+STRUCT_CODES = {                                                                           # struct format character to numpy type
+    'b': 'i1', 'B': 'u1', 'h': 'i2', 'H': 'u2', 'i': 'i4', 'I': 'u4',
+    'l': 'i4', 'L': 'u4', 'f': 'f4', 'd': 'f8', 'x': 'V1',
+}
+BYTE_ORDERS  = {'<': '<', '>': '>', '!': '>', '=': '=', '@': '='}                          # struct byte order to numpy, packed
+CHECKSUMS    = {"sum8": 1, "xor8": 1, "crc8": 1, "crc16": 2}                               # checksum name: size in bytes
+LINE_CHECKSUMS = {                                                                         # names used in UI for line checksums
+    "NMEA (*hh)":       "xor",
+    "CRC-8 (*hh)":      "crc8",
+    "CRC-16 (*hhhh)":   "crc16",
+}
+CRC_LINE_LENGTH      = 128                                                                 # [bytes] position tables cover lines this long, grown for longer lines
+AUTOBAUD_MIN_BYTES   = 16                                                                  # fewer bytes received at a baud rate are not scored
+AUTOBAUD_LINE_LENGTH = 80                                                                  # [bytes] lines up to this long give full line score
+AUTOBAUD_TOLERANCE   = 0.05                                                                # keep current baud rate if its score is this close to best
+PRINTABLE = np.zeros(256, dtype=bool)                                                      # text bytes
+PRINTABLE[0x20:0x7F] = True
+PRINTABLE[[0x09, 0x0A, 0x0D]] = True
+FRAMING_ERROR = np.zeros(256, dtype=bool)                                                  # bytes received when bits are sampled at wrong times
+FRAMING_ERROR[0x00] = True
+FRAMING_ERROR[0x80:] = True
+HEX_VALUES = np.full(256, -1, dtype=np.int32)                                              # ascii hex digit to value, -1 for other characters
+HEX_VALUES[np.frombuffer(b'0123456789', dtype=np.uint8)] = np.arange(10)
+HEX_VALUES[np.frombuffer(b'ABCDEF', dtype=np.uint8)] = np.arange(10, 16)
+HEX_VALUES[np.frombuffer(b'abcdef', dtype=np.uint8)] = np.arange(10, 16)
+_pair = np.arange(65536)                                                                   # two characters read as little endian uint16
+HEX_PAIRS_XOR = np.where((HEX_VALUES[_pair & 0xFF] >= 0) & (HEX_VALUES[_pair >> 8] >= 0),   # two hex digits to value xor both digits, -1 for other characters
+                         (HEX_VALUES[_pair & 0xFF]*16 + HEX_VALUES[_pair >> 8]) ^ (_pair & 0xFF) ^ (_pair >> 8), -1).astype(np.int32)
+_digits = np.frombuffer(b'0123456789abcdef', dtype=np.uint8).astype(np.uint32)
+HEX_TEXT2 = (_digits[_pair[:256] >> 4] | _digits[_pair[:256] & 15] << 8).astype(np.uint16)  # value to two lower case digits, little endian
+HEX_TEXT4 = HEX_TEXT2[_pair >> 8] | HEX_TEXT2[_pair & 0xFF].astype(np.uint32) << 16        # value to four lower case digits
+SAMPLE_TYPES = {                                                                           # names used in UI for raw samples
+    "int16":              "<i2",
+    "int16 big endian":   ">i2",
+    "uint8":              "u1",
+    "int32":              "<i4",
+    "int32 big endian":   ">i4",
+    "float32":            "<f4",
+    "float32 big endian": ">f4",
+}
+DECODE_ERRORS = "replace"                                                                  # invalid bytes become U+FFFD
+
+logger = logging.getLogger("Codec__")
+
+# Line Parsing
+########################################################################################
+
+def lines_to_array(lines: list, separator: bytes = b','):
+    """
+    Parse a list of byte lines into a 2D float array.
+
+    Each line is split at separator and each field is converted to float.
+    Lines that still contain \\r or \\n are skipped, this happens if data was lost during
+    serial transmission and only a partial end of line was received.
+    Lines with fields that are not numbers are skipped.
+    Empty fields are removed.
+    If lines have different number of values, shorter rows are padded with np.nan.
+    Returns array with shape (number of lines, max number of values in a line)
+      and the number of lines that were skipped.
+    """
+    # parse text into numbers, filter removes empty strings
+    lines = [line for line in lines if not (b'\n' in line or b'\r' in line)]
+    num_errors = len(lines)
+    try:
+        data = [list(map(float, filter(None, line.split(separator)))) for line in lines]
+    except ValueError:
+        # at least one line is corrupted, parse line by line and drop the bad ones
+        data = []
+        for line in lines:
+            try:
+                data.append(list(map(float, filter(None, line.split(separator)))))
+            except ValueError:
+                pass
+    num_errors -= len(data)
+
+    try:
+        # conversion to numpy if all lines have the same length
+        data_array = np.array(data, dtype=float)
+    except ValueError:
+        # likely we have a list of lines with different lengths
+        max_length = max(len(data_row) for data_row in data)
+        # Pad shorter lines with np.nan
+        padded_data = [data_row + [np.nan]*(max_length - len(data_row)) for data_row in data]
+        data_array = np.array(padded_data, dtype=float)
+
+    if data_array.ndim != 2:
+        # no lines or no values in any line
+        data_array = data_array.reshape(len(data), -1) if data else np.empty((0, 0))
+
+    return data_array, num_errors
+
+# Binary Framing
+########################################################################################
+
+def cobs_encode(packet: bytes) -> bytes:
+    """ COBS encode packet and append 0x00 delimiter """
+    out, block = bytearray(), bytearray()
+    for b in packet:
+        if b == 0:
+            out.append(len(block) + 1)
+            out += block
+            block.clear()
+        else:
+            block.append(b)
+            if len(block) == 254:
+                out.append(255)
+                out += block
+                block.clear()
+    out.append(len(block) + 1)
+    out += block
+    out.append(0)
+    return bytes(out)
+
+def slip_encode(packet: bytes) -> bytes:
+    """ SLIP escape packet and append END delimiter """
+    return packet.replace(b'\xdb', b'\xdb\xdd').replace(b'\xc0', b'\xdb\xdc') + b'\xc0'
+
+class FrameDecoder():
+    """
+    Decodes COBS or SLIP framed packets
+
+    decode(bytes) returns the list of complete packets and the number of packets that
+    could not be decoded. Bytes after the last delimiter are kept for the next call.
+    All packets of a batch are decoded together with numpy, for COBS the code byte chain
+    of all packets is followed in parallel, the number of iterations is the largest
+    number of zeros in a packet.
+    """
+
+    def __init__(self, framing: str = "cobs"):
+        if framing not in ("cobs", "slip"):
+            raise ValueError("unknown framing {}".format(framing))
+        self.framing   = framing
+        self.delimiter = 0 if framing == "cobs" else SLIP_END
+        self.remainder = b''
+
+    def encode(self, packet: bytes) -> bytes:
+        return cobs_encode(packet) if self.framing == "cobs" else slip_encode(packet)
+
+    def reset(self):
+        self.remainder = b''
+
+    def decode(self, byte_array: bytes):
+        data = self.remainder + byte_array
+        last = data.rfind(bytes([self.delimiter]))
+        if last < 0:
+            self.remainder = data
+            return [], 0
+        self.remainder = data[last+1:]
+        buf    = np.frombuffer(data, dtype=np.uint8, count=last+1)
+        isEnd  = buf == self.delimiter
+        ends   = np.flatnonzero(isEnd)                                                     # delimiter of each frame
+        starts = np.empty_like(ends)
+        starts[0], starts[1:] = 0, ends[:-1] + 1
+        frame  = np.cumsum(isEnd) - isEnd                                                  # frame number of each byte
+        keep   = ~isEnd
+        valid  = ends > starts                                                             # empty frames are ignored
+        if self.framing == "cobs":
+            out = buf.copy()
+            keep[starts[valid]] = False                                                    # first code byte
+            p = starts[valid]
+            e = ends[valid]
+            f = np.flatnonzero(valid)
+            while p.size:
+                q = p + buf[p]                                                             # next code byte or end of frame
+                bad = q > e
+                valid[f[bad]] = False                                                      # code points beyond end of frame
+                inside = q < e
+                zero = inside & (buf[p] != 0xFF)
+                out[q[zero]] = 0                                                           # code byte stands for a zero
+                keep[q[inside & ~zero]] = False                                            # 0xFF code byte has no zero
+                p, e, f = q[inside], e[inside], f[inside]
+        else:
+            out = buf
+            esc = np.flatnonzero(buf[:-1] == SLIP_ESC)
+            if esc.size:
+                out = buf.copy()
+                nxt = buf[esc + 1]
+                bad = (nxt != SLIP_ESC_END) & (nxt != SLIP_ESC_ESC)
+                valid[frame[esc[bad]]] = False
+                out[esc + 1] = np.where(nxt == SLIP_ESC_END, SLIP_END, SLIP_ESC)
+                keep[esc] = False
+                keep[esc[1:][esc[1:] - 1 == esc[:-1]]] = True                              # escaped escape followed by escape
+        keep &= valid[frame]
+        lengths = np.bincount(frame[keep], minlength=ends.size)
+        payload = out[keep].tobytes()
+        offsets = np.zeros(ends.size + 1, dtype=np.int64)
+        np.cumsum(lengths, out=offsets[1:])
+        packets = [payload[a:b] for a, b, v in zip(offsets[:-1].tolist(), offsets[1:].tolist(), valid.tolist()) if v]
+        return packets, int(np.count_nonzero(~valid & (ends > starts)))
+
+def packets_to_array(packets: list, dtype: np.dtype = PACKET_DTYPE):
+    """
+    Convert binary packets into a 2D float array, each packet is one row of samples.
+    If all packets have the same length they are converted at once, otherwise
+    shorter rows are padded with np.nan. Packets whose length is not a multiple of
+    the sample size are skipped.
+    Returns array with shape (number of packets, samples per packet) and number of skipped packets.
+    """
+    if not packets:
+        return np.empty((0, 0)), 0
+    size = dtype.itemsize
+    n = len(packets[0])
+    if n % size == 0 and all(len(packet) == n for packet in packets):
+        return np.frombuffer(b''.join(packets), dtype=dtype).reshape(len(packets), -1).astype(float), 0
+    good = [packet for packet in packets if len(packet) % size == 0]
+    if not good:
+        return np.empty((0, 0)), len(packets)
+    width = max(len(packet) for packet in good)//size
+    data_array = np.full((len(good), width), np.nan)
+    for row, packet in enumerate(good):
+        values = np.frombuffer(packet, dtype=dtype)
+        data_array[row, :values.size] = values
+    return data_array, len(packets) - len(good)
+
+# Packet Layout
+########################################################################################
+
+def _crc_table(poly: int, width: int) -> np.ndarray:
+    """ table of CRC remainders for each byte value, most significant bit first """
+    top, mask = 1 << (width - 1), (1 << width) - 1
+    table = np.zeros(256, dtype=np.uint16)
+    for b in range(256):
+        crc = b << (width - 8)
+        for _ in range(8):
+            crc = ((crc << 1) ^ poly) if crc & top else (crc << 1)
+        table[b] = crc & mask
+    return table
+
+CRC8_TABLE  = _crc_table(0x07, 8)
+CRC16_TABLE = _crc_table(0x1021, 16)
+_word = np.arange(65536)                                                                   # tables for two bytes per step
+CRC8_TABLE2  = CRC8_TABLE[CRC8_TABLE[_word >> 8] ^ (_word & 0xFF)].astype(np.intp)
+CRC16_TABLE2 = (((CRC16_TABLE[_word >> 8].astype(np.intp) << 8) & 0xFFFF) ^ CRC16_TABLE[(CRC16_TABLE[_word >> 8] >> 8) ^ (_word & 0xFF)]).astype(np.intp)
+
+CRC_POSITIONS = {}                                                                         # kind: table of crc_positions
+CRC_RAMP = np.arange(0, 65536 << 8, 256)                                                   # row offset of each position in a block up to 64 kB
+
+def crc_positions(kind: str, length: int) -> np.ndarray:
+    """
+    CRC of each byte value followed by 0 ... length-1 zero bytes, one row per distance from
+    the end of the line. A CRC with initial value 0 is linear, the CRC of a line is the
+    exclusive or of the rows of its bytes. The last 8 rows are zero, for bytes after the line.
+    """
+    table = CRC_POSITIONS.get(kind)
+    if table is None or table.shape[0] - 8 < length:
+        rows  = max(CRC_LINE_LENGTH, 1 << max(length - 1, 0).bit_length())
+        table = np.zeros((rows + 8, 256), dtype=np.uint8 if kind == "crc8" else np.uint16)
+        if kind == "crc8":
+            table[0] = CRC8_TABLE
+            for k in range(1, rows):
+                table[k] = CRC8_TABLE[table[k-1]]
+        else:
+            table[0] = CRC16_TABLE
+            for k in range(1, rows):
+                table[k] = ((table[k-1] << 8) & 0xFFFF) ^ CRC16_TABLE[table[k-1] >> 8]
+        CRC_POSITIONS[kind] = table
+    return table
+
+def checksum_rows(data: np.ndarray, kind: str) -> np.ndarray:
+    """
+    Checksum of each row of a 2D uint8 array
+    The loop is over the bytes of a packet, all packets are processed at once.
+    """
+    if kind == "sum8":
+        return (data.sum(axis=1, dtype=np.uint32) & 0xFF).astype(np.uint16)
+    if kind == "xor8":
+        return np.bitwise_xor.reduce(data, axis=1).astype(np.uint16)
+    if kind not in ("crc8", "crc16"):
+        raise ValueError("unknown checksum {}".format(kind))
+    # two bytes per step, a leading zero byte does not change the CRC
+    if data.shape[1] % 2:
+        data = np.hstack([np.zeros((data.shape[0], 1), dtype=np.uint8), data])
+    words = (data[:, 0::2].astype(np.intp) << 8) | data[:, 1::2]
+    crc = np.zeros(data.shape[0], dtype=np.intp)
+    if kind == "crc8":
+        for column in words.T:
+            crc = CRC8_TABLE2[(crc << 8) ^ column]
+    else:
+        for column in words.T:
+            crc = CRC16_TABLE2[crc ^ column]
+    return crc.astype(np.uint16)
+
+class PacketLayout():
+    """
+    Fields of a binary packet
+
+    dtype                             numpy structured dtype, packed
+    channels                          names of fields shown in chart
+    checksum                          name of checksum in last field or ""
+    unpack(packets)                   structured array of packets with correct size and checksum, number of errors
+    decode(packets)                   2D float array of channels, number of errors
+    """
+
+    def __init__(self, dtype, channels: list = None, checksum: str = ""):
+        self.dtype    = np.dtype(dtype)
+        if self.dtype.names is None:
+            raise ValueError("layout needs named fields")
+        names = [name for name in self.dtype.names if self.dtype[name].kind != 'V']         # pad bytes are no data
+        self.checksum = checksum
+        if checksum:
+            if checksum not in CHECKSUMS:
+                raise ValueError("unknown checksum {}".format(checksum))
+            last = self.dtype.names[-1]
+            if self.dtype[last].itemsize != CHECKSUMS[checksum] or self.dtype[last].kind not in 'ui':
+                raise ValueError("last field needs to be {} byte unsigned for {}".format(CHECKSUMS[checksum], checksum))
+            self.checksumField = last
+            names.remove(last)
+        self.channels = list(channels) if channels else names
+        for name in self.channels:
+            if name not in self.dtype.names:
+                raise ValueError("unknown field {}".format(name))
+        self.itemsize = self.dtype.itemsize
+
+    def __str__(self):
+        fields = " ".join("{}:{}".format(name, self.dtype[name].str) for name in self.dtype.names)
+        return "{}; channels={}{}".format(fields, ",".join(self.channels),
+                                         "; checksum=" + self.checksum if self.checksum else "")
+
+    def unpack(self, packets: list):
+        """ convert packets into records, drop packets with wrong size or checksum """
+        size = self.itemsize
+        good = packets if all(len(packet) == size for packet in packets) else [packet for packet in packets if len(packet) == size]
+        num_errors = len(packets) - len(good)
+        buffer  = b''.join(good)
+        records = np.frombuffer(buffer, dtype=self.dtype)
+        if self.checksum and records.size:
+            raw = np.frombuffer(buffer, dtype=np.uint8).reshape(-1, size)
+            ok  = checksum_rows(raw[:, :size - CHECKSUMS[self.checksum]], self.checksum) == records[self.checksumField]
+            if not ok.all():
+                num_errors += int(np.count_nonzero(~ok))
+                records = records[ok]
+        return records, num_errors
+
+    def decode(self, packets: list):
+        """ convert packets into one row of channel values per packet """
+        records, num_errors = self.unpack(packets)
+        data_array = np.empty((records.size, len(self.channels)))
+        for column, name in enumerate(self.channels):
+            data_array[:, column] = records[name]
+        return data_array, num_errors
+
+def parse_layout(text: str) -> PacketLayout:
+    """
+    Create packet layout from text, see top of file
+    Raises ValueError
+    """
+    parts   = [part.strip() for part in text.split(';')]
+    options = {}
+    for part in parts[1:]:
+        key, _, value = part.partition('=')
+        options[key.strip().lower()] = value.strip()
+    unknown = set(options) - {"channels", "checksum"}
+    if unknown:
+        raise ValueError("unknown option {}".format(", ".join(unknown)))
+    fields = parts[0]
+    order  = '<'
+    if fields[:1] in BYTE_ORDERS:
+        order, fields = BYTE_ORDERS[fields[0]], fields[1:].strip()
+    if not fields:
+        raise ValueError("no fields")
+    if ':' in fields:
+        # named fields
+        items = []
+        for item in re.split(r'[\s,]+', fields):
+            name, _, code = item.partition(':')
+            if not name or not code:
+                raise ValueError("field {} needs name:type".format(item))
+            code = STRUCT_CODES.get(code, code)
+            try:
+                items.append((name, np.dtype(code if code[0] in '<>=|' else order + code)))
+            except TypeError:
+                raise ValueError("unknown type {}".format(code)) from None
+    else:
+        # struct format
+        items, number = [], 0
+        for count, code in re.findall(r'\s*(\d*)\s*(\S)', fields):
+            if code not in STRUCT_CODES:
+                raise ValueError("unknown struct format character {}".format(code))
+            for _ in range(int(count) if count else 1):
+                items.append(("f{}".format(number), np.dtype(order + STRUCT_CODES[code])))
+                number += 1
+    channels = [channel.strip() for channel in options.get("channels", "").split(',') if channel.strip()]
+    names = [name for name, _ in items]
+    channels = [names[int(channel)] if channel.isdigit() and int(channel) < len(names) else channel for channel in channels]
+    try:
+        return PacketLayout(items, channels, options.get("checksum", "").lower())
+    except TypeError as e:
+        raise ValueError(str(e)) from None
+
+# Line Checksum
+########################################################################################
+
+def line_checksum(line: bytes, kind: str) -> bytes:
+    """ append *hh or *hhhh checksum to line, e.g. for a device simulator """
+    if kind == "xor":
+        value, digits = np.bitwise_xor.reduce(np.frombuffer(line[1:] if line.startswith(b'$') else line, dtype=np.uint8), initial=0), 2
+    else:
+        value = checksum_rows(np.frombuffer(line, dtype=np.uint8).reshape(1, -1), kind)[0]
+        digits = 4 if kind == "crc16" else 2
+    return line + b'*' + "{:0{}X}".format(int(value), digits).encode()
+
+def check_block(data: bytes, eol: bytes, kind: str):
+    """
+    Validate checksum suffix of all lines in a block of complete lines, each line ends with eol.
+    Returns lines that passed without checksum suffix, number of lines that passed and number
+    of lines that failed.
+    """
+    if kind not in ("xor", "crc8", "crc16"):
+        raise ValueError("unknown line checksum {}".format(kind))
+    buf = np.frombuffer(data, dtype=np.uint8)
+    le  = len(eol)
+    ends = np.flatnonzero(buf == eol[-1]) + 1                                              # end of each line including eol
+    if le > 1:
+        ends = ends[buf[ends - 2] == eol[0]]                                               # block ends with eol, ends - 2 >= 0 or wraps to eol[-1]
+    num = ends.size
+    if num == 0:
+        return [], 0, 0
+    starts = np.empty_like(ends)
+    starts[0]  = 0
+    starts[1:] = ends[:-1]
+    digits = 4 if kind == "crc16" else 2
+    stars  = np.maximum(ends - le - digits - 1, starts)                                    # position of *, digits of short lines overlap eol
+    padded = data + bytes(digits)                                                          # digits of a short last line
+    text   = np.ndarray((len(padded) - digits + 1,), dtype='<u4' if digits == 4 else '<u2', # hex digits at each position
+                        buffer=padded, strides=(1,))[stars + 1]
+    if kind == "xor":
+        # exclusive or of whole line, * hex digits and eol are removed with the table, NMEA excludes $
+        received = HEX_PAIRS_XOR[text]
+        computed = np.bitwise_xor.reduceat(buf, starts) ^ np.bitwise_xor.reduce(np.frombuffer(b'*' + eol, dtype=np.uint8))
+        computed ^= (buf[starts] == ord('$'))*np.uint8(ord('$'))
+    else:
+        # computed CRC as text, setting bit 5 turns upper case hex digits into lower case
+        received = text | (0x20202020 if digits == 4 else 0x2020)
+        # sum of rows of position table of all bytes, bytes after * are in the zero rows
+        lengths = ends - starts
+        table = crc_positions(kind, int(lengths.max()))
+        index = np.repeat((stars - 1) << 8, lengths)                                       # row of distance to * and column of byte
+        index -= CRC_RAMP[:buf.size] if buf.size <= CRC_RAMP.size else np.arange(0, buf.size << 8, 256)
+        index += buf
+        computed = (HEX_TEXT4 if digits == 4 else HEX_TEXT2)[np.bitwise_xor.reduceat(table.ravel().take(index), starts)]
+    good = (computed == received) & (buf[stars] == ord('*'))
+    num_good = int(np.count_nonzero(good))
+    if num_good == num:
+        # zero digits, * zeros and eol only occur at the end of lines
+        out = buf.copy()
+        np.ndarray((buf.size - digits + 1,), dtype='<u4' if digits == 4 else '<u2', buffer=out, strides=(1,))[stars + 1] = 0
+        return out.tobytes().split(b'*' + bytes(digits) + eol)[:-1], num, 0
+    # remove * and hex digits of good lines and all of failed lines
+    keep = np.ones(buf.size, dtype=bool)
+    keep[(stars[good, None] + np.arange(digits + 1)).ravel()] = False
+    drop = np.zeros(buf.size + 1, dtype=np.int32)
+    np.add.at(drop, starts[~good],  1)
+    np.add.at(drop, ends[~good],   -1)
+    keep &= np.cumsum(drop[:-1]) == 0
+    return buf[keep].tobytes().split(eol)[:-1], num_good, num - num_good
+
+# Sequence Numbers
+########################################################################################
+
+class SequenceCounter():
+    """
+    Counts lost, duplicated and restarted rows from a sequence number column
+
+    check(numbers) returns indices of rows that follow a gap or a reset
+    lossRate                          lost/(received + lost)
+    """
+
+    def __init__(self, modulo: int = 0):
+        self.modulo = max(int(modulo), 0)                                                  # 0 counter does not wrap around
+        self.reset()
+
+    def reset(self):
+        self.last          = None                                                          # last number of previous batch
+        self.numReceived   = 0
+        self.numLost       = 0
+        self.numGaps       = 0
+        self.numDuplicates = 0
+        self.numResets     = 0
+
+    def check(self, numbers: np.ndarray) -> np.ndarray:
+        """ account for a batch of sequence numbers, rows without number (nan) are skipped """
+        rows = np.flatnonzero(~np.isnan(numbers))
+        if rows.size == 0:
+            return rows
+        seq = numbers[rows].astype(np.int64)
+        if self.last is None:
+            diff = np.diff(seq)
+            rows = rows[1:]
+        else:
+            diff = np.diff(seq, prepend=self.last)
+        self.last = int(seq[-1])
+        self.numReceived += seq.size
+        if self.modulo:
+            diff %= self.modulo
+            resets = diff >= (self.modulo + 1)//2
+        else:
+            resets = diff < 0
+        gaps = (diff > 1) & ~resets
+        self.numLost       += int(diff[gaps].sum() - np.count_nonzero(gaps))
+        self.numGaps       += int(np.count_nonzero(gaps))
+        self.numDuplicates += int(np.count_nonzero(diff == 0))
+        self.numResets     += int(np.count_nonzero(resets))
+        return rows[gaps | resets]
+
+    @property
+    def lossRate(self) -> float:
+        total = self.numReceived + self.numLost
+        return self.numLost/total if total > 0 else 0.
+
+    def summary(self) -> str:
+        return "{} received, {} lost ({:.3f}%) in {} gaps, {} duplicates, {} resets".format(
+            self.numReceived, self.numLost, 100*self.lossRate, self.numGaps, self.numDuplicates, self.numResets)
+
+# Device Clock
+########################################################################################
+
+class DeviceClock():
+    """
+    Maps device timestamps to host time
+
+    update(ticks, host) unwraps a batch of timestamps, adds the newest one to the fit and
+                        returns host time [s] of all timestamps, nan where there is none
+    offset, drift       host = offset + (1 + drift)*device [s]
+    """
+
+    def __init__(self, unit: float = 1e-6, bits: int = 32, timeConstant: float = FIT_TIME_CONSTANT):
+        self.unit         = unit                                                           # [s] per tick
+        self.wrap         = float(2**bits) if bits > 0 else 0.                             # ticks, 0 does not wrap around
+        self.timeConstant = timeConstant
+        self.reset()
+
+    def reset(self):
+        self.last   = None                                                                 # last tick of previous batch
+        self.turns  = 0                                                                    # wrap arounds so far
+        self.origin = None                                                                 # (device, host) of first batch, fit is relative to it
+        self.sums   = np.zeros(5)                                                          # weight, x, y, xx, xy
+        self.lastX  = 0.
+        self.offset = 0.
+        self.drift  = 0.
+        self.numPoints = 0
+
+    def unwrap(self, ticks: np.ndarray) -> np.ndarray:
+        """ continuous device time [s] """
+        rows = np.flatnonzero(~np.isnan(ticks))
+        seconds = np.full(ticks.shape, np.nan)
+        if rows.size == 0:
+            return seconds
+        t = ticks[rows]
+        if self.wrap:
+            back  = np.diff(t, prepend=t[0] if self.last is None else self.last) < -self.wrap/2
+            turns = self.turns + np.cumsum(back)
+            self.turns = int(turns[-1])
+            t = t + turns*self.wrap
+        self.last = ticks[rows[-1]]
+        seconds[rows] = t*self.unit
+        return seconds
+
+    def update(self, ticks: np.ndarray, host: float) -> np.ndarray:
+        device = self.unwrap(ticks)
+        valid = device[~np.isnan(device)]
+        if valid.size > 0:
+            self.add(valid[-1], host)
+        return self.offset + (1. + self.drift)*device
+
+    def add(self, device: float, host: float):
+        """ newest timestamp arrived at host time, both [s] """
+        if self.origin is None:
+            self.origin = (device, host)
+        x, y = device - self.origin[0], host - self.origin[1]
+        forget = np.exp(-max(x - self.lastX, 0.)/self.timeConstant)
+        self.lastX = x
+        self.sums = self.sums*forget + (1., x, y, x*x, x*y)
+        n, sx, sy, sxx, sxy = self.sums
+        self.numPoints += 1
+        det = n*sxx - sx*sx
+        slope = (n*sxy - sx*sy)/det if self.numPoints > 1 and det > 0 else 1.
+        self.drift  = slope - 1.
+        self.offset = self.origin[1] + (sy - slope*sx)/n - slope*self.origin[0]
+
+    def summary(self) -> str:
+        return "offset {:.6f} s, drift {:.1f} ppm, {} wrap arounds".format(self.offset, self.drift*1e6, self.turns)
+
+def insert_breaks(data_array: np.ndarray, rows: np.ndarray) -> np.ndarray:
+    """ insert a row of nan in front of rows, a plotted line is interrupted there """
+    if rows.size == 0:
+        return data_array
+    return np.insert(data_array, rows, np.nan, axis=0)
+
+# Automatic Baud Rate
+########################################################################################
+
+def score_baud(data: bytes, eol: bytes = b'\n') -> float:
+    """
+    Score bytes received at a candidate baud rate, about 2 for text, -inf for too few bytes
+    """
+    if len(data) < AUTOBAUD_MIN_BYTES:
+        return -np.inf
+    b = np.frombuffer(data, dtype=np.uint8)
+    printable = np.count_nonzero(PRINTABLE[b])/b.size
+    errors    = np.count_nonzero(FRAMING_ERROR[b])/b.size
+    lines     = min(data.count(eol[-1:] if eol else b'\n')*AUTOBAUD_LINE_LENGTH/b.size, 1.)
+    return printable + lines - errors
+
+def best_baud(scores: dict, current: int = -1) -> int:
+    """
+    Baud rate with highest score, current baud rate if it scores as well, e.g. USB ports ignore the rate
+    Returns current if no rate received enough bytes
+    """
+    if not scores:
+        return current
+    best = max(scores, key=scores.get)
+    if scores[best] == -np.inf or (current in scores and scores[current] >= scores[best] - AUTOBAUD_TOLERANCE):
+        return current
+    return best
+
+# Raw Samples
+########################################################################################
+
+class SampleStream():
+    """
+    Interleaved samples of several channels without framing
+
+    decode(bytes) returns array with one row per complete set of channel samples
+    """
+
+    def __init__(self, dtype: str = "<i2", channels: int = 1):
+        self.dtype     = np.dtype(dtype)
+        self.channels  = max(int(channels), 1)
+        self.frameSize = self.dtype.itemsize*self.channels                                 # bytes per row
+        self.remainder = b''
+
+    def reset(self):
+        self.remainder = b''
+
+    def decode(self, byte_array: bytes) -> np.ndarray:
+        data = self.remainder + byte_array if self.remainder else byte_array
+        num_rows = len(data)//self.frameSize
+        self.remainder = data[num_rows*self.frameSize:]
+        return np.frombuffer(data, dtype=self.dtype, count=num_rows*self.channels).reshape(num_rows, self.channels).astype(float)
+
+# Text Decoding
+########################################################################################
+
+class TextDecoder():
+    """
+    Received bytes to text, characters split across batches are completed with the next batch
+
+    decode(bytes)      text of a batch, incomplete character at the end is kept
+    decodeLines(list)  text of complete lines joined with newline
+    """
+
+    def __init__(self, encoding: str = "utf-8", errors: str = DECODE_ERRORS):
+        self.encoding = encoding
+        self.errors   = errors
+        self.decoder  = codecs.getincrementaldecoder(encoding)(errors=errors)
+        self.ascii    = codecs.lookup(encoding).name in ("utf-8", "ascii", "iso8859-1", "cp1252")  # ascii bytes are ascii characters
+        self.pending  = False                                                              # decoder holds part of a character
+
+    def reset(self):
+        self.decoder.reset()
+        self.pending = False
+
+    def decode(self, byte_array: bytes) -> str:
+        if self.ascii and not self.pending and byte_array.isascii():
+            return byte_array.decode("ascii")
+        text = self.decoder.decode(byte_array)
+        self.pending = bool(self.decoder.getstate()[0])
+        return text
+
+    def decodeLines(self, lines: list) -> str:
+        return b"\n".join(lines).decode(self.encoding, self.errors)                       # one call, utf-8 codec has its own ascii fast path
+
+#####################################################################################
+# Testing
+#####################################################################################
+
+if __name__ == '__main__':
+    logging.basicConfig(level=logging.DEBUG)
+    a, e = lines_to_array([b'1,2,3', b'4,5', b'6,7,8\r'], b',')
+    assert a.shape == (2, 3) and np.isnan(a[1, 2]) and e == 0
+    a, e = lines_to_array([b'1,2', b'1,x', b'3,4'], b',')
+    assert a.shape == (2, 2) and e == 1
+    a, e = lines_to_array([], b',')
+    assert a.shape == (0, 0)
+    logger.log(logging.INFO, "line parsing ok")
+
+    import time
+    rng = np.random.default_rng(0)
+    packets = [rng.integers(0, 4, size=rng.integers(1, 600), dtype=np.uint8).tobytes() for _ in range(200)]
+    packets += [b'\xc0\xdb\xdb\xdc', b'\x00', b'\x00'*300]
+    for framing in ("cobs", "slip"):
+        decoder = FrameDecoder(framing)
+        stream = b''.join(decoder.encode(packet) for packet in packets)
+        decoded = []
+        for i in range(0, len(stream), 997):                                               # packets split across batches
+            new, errors = decoder.decode(stream[i:i+997])
+            decoded += new
+            assert errors == 0
+        assert decoded == packets, framing
+        # corrupted packet is dropped, following packets survive
+        bad = decoder.encode(b'\x01\x02')
+        bad = (b'\x05' + bad[1:]) if framing == "cobs" else b'\xdb\x01\xc0'
+        new, errors = decoder.decode(bad + decoder.encode(b'\x03\x04'))
+        assert new == [b'\x03\x04'] and errors == 1, framing
+        # throughput with 8 byte packets of 4 int16
+        samples = rng.integers(-32768, 32767, size=(100000, 4), dtype=np.int16)
+        stream = b''.join(decoder.encode(row.tobytes()) for row in samples)
+        tic = time.perf_counter()
+        new, errors = decoder.decode(stream)
+        data_array, errors = packets_to_array(new)
+        toc = time.perf_counter()
+        assert np.array_equal(data_array, samples) and errors == 0
+        logger.log(logging.INFO, "{} ok, {:.0f} k packets/s".format(framing, len(new)/(toc - tic)/1000))
+
+    import struct, binascii
+    layout = parse_layout(">3hfB; channels=2,f0; checksum=sum8")
+    assert layout.itemsize == 11 and layout.channels == ["f2", "f0"]
+    packet = struct.pack(">3hf", 1, -2, 3, 0.5)
+    packets = [packet + bytes([sum(packet) & 0xFF]), packet + b'\x00', packet]
+    data_array, errors = layout.decode(packets)
+    assert data_array.tolist() == [[3., 1.]] and errors == 2
+    layout = parse_layout("ax:i2 ay:i2 t:f4 crc:>u2; channels=ay,t; checksum=crc16")
+    samples = np.zeros(100000, dtype=layout.dtype)
+    samples['ay'] = np.arange(100000) % 30000
+    samples['t']  = np.arange(100000)/8
+    raw = samples.view(np.uint8).reshape(100000, -1)
+    samples['crc'] = checksum_rows(raw[:, :-2], "crc16")
+    assert int(samples['crc'][7]) == binascii.crc_hqx(raw[7, :-2].tobytes(), 0)
+    assert int(checksum_rows(np.frombuffer(b'123456789', dtype=np.uint8).reshape(1, -1), "crc8")[0]) == 0xF4
+    packets = [row.tobytes() for row in samples]
+    tic = time.perf_counter()
+    data_array, errors = layout.decode(packets)
+    toc = time.perf_counter()
+    assert errors == 0 and np.array_equal(data_array[:, 1], samples['t'])
+    logger.log(logging.INFO, "layout {} ok, {:.0f} k packets/s".format(layout, len(packets)/(toc - tic)/1000))
+    # line checksums, 40k lines/s arrive in blocks of about 1100 lines every 28 ms
+    assert line_checksum(b'$GPGLL,5057.970,N,00146.110,E,142451,A', "xor") == b'$GPGLL,5057.970,N,00146.110,E,142451,A*27'
+    assert line_checksum(b'123456789', "crc16") == b'123456789*31C3'
+    for kind in ("xor", "crc8", "crc16"):
+        lines = [line_checksum(b"%d,%d,%d" % (i, -2*i, i % 97), kind) for i in range(200)]
+        lines[5]  = lines[5].replace(b',', b';', 1)                                        # corrupted data
+        lines[9]  = lines[9][:-1] + (b'0' if lines[9][-1:] != b'0' else b'1')              # corrupted checksum
+        lines[11] = lines[11][:3]                                                          # partial line
+        lines[12] = b''
+        lines[13] = lines[13].lower()                                                      # lower case digits
+        lines[14] = line_checksum(b','.join([b'1234567']*40), kind)                         # longer than CRC_LINE_LENGTH
+        for eol in (b'\r\n', b'\n'):
+            good, num_good, errors = check_block(eol.join(lines) + eol, eol, kind)
+            assert errors == 4 and num_good == len(good) == 196 and good[0] == b'0,0,0' and good[-1] == b'199,-398,5', kind
+            assert good[9:11] == [b'13,-26,13', b','.join([b'1234567']*40)], kind
+        payload = [b"%d,%d,%d" % (i, -2*i, i % 97) for i in range(1120)]
+        block = b'\r\n'.join(line_checksum(line, kind) for line in payload) + b'\r\n'
+        good, num_good, errors = check_block(block, b'\r\n', kind)
+        assert good == payload and num_good == 1120 and errors == 0, kind
+        # check replaces the split of the lines, compare the difference with split and parse
+        check, split, parse = 1., 1., 1.
+        for _ in range(20):
+            tic = time.perf_counter()
+            for _ in range(10): check_block(block, b'\r\n', kind)
+            toc = time.perf_counter()
+            for _ in range(10): block.split(b'\r\n')[:-1]
+            tac = time.perf_counter()
+            for _ in range(10): lines_to_array(good)
+            check, split, parse = min(check, toc - tic), min(split, tac - toc), min(parse, time.perf_counter() - tac)
+        logger.log(logging.INFO, "line checksum {} ok, adds {:.1f}% to split and parse of 1120 lines".format(kind, 100*(check - split)/(split + parse)))
+    samples = rng.integers(-2**31, 2**31, size=(100000, 3)).astype('>i4')
+    stream, decoded = samples.tobytes(), []
+    raw = SampleStream(SAMPLE_TYPES["int32 big endian"], 3)
+    tic = time.perf_counter()
+    for i in range(0, len(stream), 4093):                                                  # chunks split samples
+        decoded.append(raw.decode(stream[i:i+4093]))
+    toc = time.perf_counter()
+    assert np.array_equal(np.vstack(decoded), samples) and raw.remainder == b''
+    logger.log(logging.INFO, "raw samples ok, {:.0f} M samples/s".format(samples.size/(toc - tic)/1e6))
+    seq = SequenceCounter()
+    assert seq.check(np.array([5., 6., 7.])).size == 0
+    breaks = seq.check(np.array([8., 11., 11., np.nan, 12., 0., 1.]))                       # 9 and 10 lost, 11 twice, restart
+    assert list(breaks) == [1, 5] and seq.numLost == 2 and seq.numDuplicates == 1 and seq.numResets == 1
+    assert np.flatnonzero(np.isnan(insert_breaks(np.arange(7.).reshape(-1, 1), breaks))).tolist() == [1, 6]
+    seq = SequenceCounter(modulo=256)
+    seq.check(np.array([254., 255., 0., 3.]))                                              # wraps, 1 and 2 lost
+    assert seq.numLost == 2 and seq.numResets == 0 and abs(seq.lossRate - 2/6) < 1e-12
+    counter = np.arange(200000.)
+    counter = np.delete(counter, rng.choice(200000, 100, replace=False))
+    seq = SequenceCounter()
+    tic = time.perf_counter()
+    for block in np.array_split(counter, 1000):
+        seq.check(block)
+    toc = time.perf_counter()
+    assert seq.numLost == 100 - int(counter[0]) and seq.numResets == 0                    # first number might have been removed
+    logger.log(logging.INFO, "sequence ok, {}, {:.1f} us per batch of 200".format(seq.summary(), (toc - tic)/1000*1e6))
+    # device clock 3 s ahead, 50 ppm fast (drift -50 ppm), 22 bit microsecond counter wraps every 4.2 s,
+    # 200 samples arrive every 5 ms with up to 3 ms host delay
+    clock = DeviceClock(TIME_UNITS["us"], bits=22)
+    true_device = 3. + np.arange(200*2000)*25e-6*(1 + 50e-6)
+    ticks = np.round(true_device/1e-6) % 2**22
+    errors = []
+    for i, block in enumerate(np.array_split(np.arange(ticks.size), 2000)):
+        host = (block[-1] + 1)*25e-6 + rng.uniform(0., 3e-3)
+        mapped = clock.update(ticks[block], host)
+        errors.append(mapped[-1] - block[-1]*25e-6)
+    assert clock.turns == int(true_device[-1]/(2**22*1e-6)) - int(true_device[0]/(2**22*1e-6)) and abs(clock.drift*1e6 + 50.) < 20.
+    assert np.ptp(errors[-200:]) < 1e-3                                                    # mapped time no longer jitters with delay
+    logger.log(logging.INFO, "device clock ok, {}".format(clock.summary()))
+    # text sent at 115200 and 9600 baud received at each candidate rate, uart samples 16 times per bit
+    def uart(data: bytes, ratio: float) -> bytes:
+        """ transmit 8N1 with 1 idle bit between bytes, receive with bit time ratio*transmit bit time """
+        line = np.ones(16*11*len(data) + 64, dtype=np.uint8)
+        for i, byte in enumerate(data):
+            bits = [0] + [(byte >> k) & 1 for k in range(8)] + [1]
+            line[16*11*i:16*11*i + 160] = np.repeat(bits, 16)
+        out, i, bit = bytearray(), 1, 16*ratio
+        while i < line.size - 10*bit:
+            if line[i] == 0 and line[i - 1] == 1:
+                value = sum(int(line[int(i + bit*(k + 1.5))]) << k for k in range(8))
+                out.append(value if line[int(i + bit*9.5)] == 1 else 0)                    # framing error is delivered as 0
+                i = int(i + bit*9.5)
+            i += 1
+        return bytes(out)
+    text = b''.join(b"%d,%d,%d\r\n" % (i, 17*i, -3*i) for i in range(40))
+    candidates = (1200, 2400, 4800, 9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600)
+    for true_baud in (115200, 9600):
+        scores = {baud: score_baud(uart(text, true_baud/baud), b'\r\n') for baud in candidates}
+        assert best_baud(scores, 57600) == true_baud and scores[true_baud] > 1.9, scores
+        runner_up = sorted(scores.values())[-2]
+        logger.log(logging.INFO, "autobaud {} ok, score {:.2f}, next best {:.2f}".format(true_baud, scores[true_baud], runner_up))
+    assert best_baud({9600: 1.98, 115200: 1.99}, 9600) == 9600 and best_baud({9600: -np.inf}, 9600) == 9600
+    tic = time.perf_counter()
+    for _ in range(100):
+        score_baud(text, b'\r\n')
+    logger.log(logging.INFO, "score {:.1f} us per {} bytes".format((time.perf_counter() - tic)/100*1e6, len(text)))
+    for bad in ("<hq", "a:i2; checksum=sum8", "a:i2 b:u1; checksum=crc16", "a:i2; channels=b", "a:zz", "<h; scale=2"):
+        try:
+            parse_layout(bad)
+            assert False, bad
+        except ValueError as e:
+            logger.log(logging.INFO, "expected error {}".format(e))
+
+    text = "Temperatur 21.5 °C, Druck 1013 hPa, µ-Sensor ✓\n"*50
+    data = text.encode("utf-8")
+    decoder = TextDecoder()
+    for size in (1, 2, 3, 7, 64):                                                          # characters split across batches
+        decoder.reset()
+        assert "".join(decoder.decode(data[i:i+size]) for i in range(0, len(data), size)) == text, size
+    assert decoder.decode(b'ok \xff\xfe\n') == "ok \ufffd\ufffd\n"                        # noise is replaced, batch survives
+    assert decoder.decode(b'\xc2') == "" and decoder.decode(b'\xb0C') == "°C"
+    assert decoder.decodeLines([b'1,2', "°".encode(), b'\x80']) == "1,2\n°\n\ufffd"
+    lines = [b"%d,%d,%d" % (i, -2*i, i % 97) for i in range(200)]
+    batch = b'\n'.join(lines)
+    tic = time.perf_counter()
+    for _ in range(1000):
+        decoder.decodeLines(lines)
+    toc = time.perf_counter()
+    for _ in range(1000):
+        "\n".join(line.decode("utf-8") for line in lines)
+    tac = time.perf_counter()
+    for _ in range(1000):
+        decoder.decode(batch)
+    tuc = time.perf_counter()
+    logger.log(logging.INFO, "text decoding ok, lines {:.0f} MB/s (line by line {:.0f} MB/s), batch {:.0f} MB/s".format(
+        len(batch)/(toc - tic)*1000/1e6, len(batch)/(tac - toc)*1000/1e6, len(batch)/(tuc - tac)*1000/1e6))
@@ -0,0 +1,291 @@
+############################################################################################
+# Hotplug Helper
+############################################################################################
+# October 2026: serial adapter hot plug detection
+# ------------------------------------------------------------------------------------------
+# Urs Utzinger
+# University of Arizona 2026
+############################################################################################
+############################################################################################
+# This code has no QT dependencies.
+#
+# A USB serial adapter that is unplugged, or resets together with its board, removes its
+# device file and creates it again when it enumerates, often under a different name
+# (ttyUSB0 becomes ttyUSB1 while the old file is still open). DeviceMonitor watches the
+# device directory and recognizes the adapter by its serial number:
+#
+#   follow(device)          remember serial number of the device that was opened
+#   check(now)              ("lost", device)  followed device was removed
+#                           ("back", device)  device with same serial number appeared
+#                           ("", "")          nothing changed
+#   lost(now)               the caller noticed first, e.g. read failed
+#   reconnected(now)        device was reopened, returns seconds since it was lost
+#   failed(now)             device could not be reopened, try again after next change
+#                           or after REOPEN_RETRY
+#
+# On Linux the directory is watched with inotify. The kernel queues an event on a file
+# descriptor when a file is created or removed, the descriptor can be handed to a
+# QSocketNotifier so that nothing is polled, neither while the adapter is connected nor
+# while it is lost: udev changes the permissions of a new device file after creating it,
+# which is another event, a reopen that failed is retried then. Without inotify
+# (other systems, or the watch limit is reached) check() compares the directory listing.
+# The events also show a device removed and created again under the same name between
+# two checks, the listing alone does not.
+# Devices without serial number, e.g. built in ports, are recognized by their name.
+############################################################################################
+
+import logging, os, ctypes, ctypes.util, struct
+from math import inf
+from fnmatch import fnmatch
+
+from serial.tools import list_ports
+
+# Constants
+########################################################################################
+DEVICE_DIRECTORY = "/dev"
+DEVICE_PATTERNS  = ("ttyUSB*", "ttyACM*", "ttyAMA*", "rfcomm*", "cu.*")                    # serial devices that can come and go
+IN_ATTRIB, IN_MOVED_FROM, IN_MOVED_TO, IN_CREATE, IN_DELETE = 0x004, 0x040, 0x080, 0x100, 0x200
+INOTIFY_MASK     = IN_ATTRIB | IN_MOVED_FROM | IN_MOVED_TO | IN_CREATE | IN_DELETE         # attrib: udev sets permissions after create
+INOTIFY_EVENT    = struct.Struct("iIII")                                                   # wd, mask, cookie, length of name
+REOPEN_RETRY     = 0.5                                                                     # [s] retry reopening unchanged device, e.g. busy
+
+logger = logging.getLogger("Hotplug")
+
+def serial_numbers(devices) -> dict:
+    """
+    device: serial number of USB adapter, vid:pid and USB location if it has none, "" for other ports
+    """
+    ids = {}
+    for port in list_ports.comports():
+        if port.device in devices:
+            if port.serial_number:
+                ids[port.device] = port.serial_number
+            elif port.vid is not None:
+                ids[port.device] = "{:04x}:{:04x} {}".format(port.vid, port.pid, port.location)
+            else:
+                ids[port.device] = ""
+    return ids
+
+############################################################################################
+# Inotify
+############################################################################################
+
+class Inotify():
+    """
+    Non blocking inotify descriptor watching one directory
+    Raises OSError or AttributeError (no inotify in C library)
+    """
+
+    def __init__(self, directory: str):
+        libc = ctypes.CDLL(ctypes.util.find_library("c"), use_errno=True)
+        self.fd = libc.inotify_init1(os.O_NONBLOCK | os.O_CLOEXEC)
+        if self.fd < 0:
+            raise OSError(ctypes.get_errno(), "inotify_init1 failed")
+        if libc.inotify_add_watch(self.fd, os.fsencode(directory), INOTIFY_MASK) < 0:
+            errno = ctypes.get_errno()
+            os.close(self.fd)
+            raise OSError(errno, "inotify_add_watch {} failed".format(directory))
+
+    def drain(self) -> list:
+        """ read all queued events, returns list of (mask, file name) """
+        events = []
+        while True:
+            try:
+                data = os.read(self.fd, 4096)
+            except BlockingIOError:
+                return events
+            if not data:
+                return events
+            pos = 0
+            while pos + INOTIFY_EVENT.size <= len(data):
+                _, mask, _, length = INOTIFY_EVENT.unpack_from(data, pos)
+                pos += INOTIFY_EVENT.size
+                events.append((mask, os.fsdecode(data[pos:pos + length].rstrip(b'\0'))))
+                pos += length
+
+    def close(self):
+        if self.fd >= 0:
+            os.close(self.fd)
+            self.fd = -1
+
+############################################################################################
+# Device Monitor
+############################################################################################
+
+class DeviceMonitor():
+    """
+    Notices a followed serial device vanishing and reappearing
+
+    fileno                                inotify descriptor to wait on, -1 when check() needs to be polled
+    enabled                               device directory exists
+    """
+
+    def __init__(self, directory: str = DEVICE_DIRECTORY, patterns: tuple = DEVICE_PATTERNS, identify=None, inotify: bool = True):
+        self.directory = directory
+        self.patterns  = patterns
+        self.identify  = identify if identify is not None else serial_numbers                # list of devices to {device: serial number}
+        self.enabled   = os.path.isdir(directory)
+        self.watch     = None
+        if inotify and self.enabled:
+            try:
+                self.watch = Inotify(directory)
+            except (OSError, AttributeError) as e:
+                logger.log(logging.INFO, "No inotify, polling {}: {}".format(directory, e))
+        self.devices   = self.scan()
+        self.device    = ""                                                                # followed device
+        self.serial    = ""                                                                # its serial number
+        self.lostTime  = None                                                              # [s] when device was lost
+        self.found     = ""                                                                # reappeared device not yet reopened
+        self.recheck   = False                                                             # look for device once without directory change
+        self.retryTime = inf                                                               # [s] look for device again after failed reopen
+        self.latency   = 0.                                                                # [s] lost to reopened
+        self.numReconnects = 0
+
+    @property
+    def fileno(self) -> int:
+        return self.watch.fd if self.watch is not None else -1
+
+    @property
+    def isLost(self) -> bool:
+        return self.lostTime is not None
+
+    def scan(self) -> set:
+        """ serial devices in directory """
+        try:
+            names = os.listdir(self.directory)
+        except OSError:
+            return set()
+        return {os.path.join(self.directory, name) for name in names if any(fnmatch(name, p) for p in self.patterns)}
+
+    def follow(self, device: str) -> bool:
+        """ remember device that was opened, False if it is not in the watched directory """
+        self.forget()
+        if not self.enabled or device not in self.scan():
+            return False
+        self.device = device
+        self.serial = self.identify([device]).get(device, "")
+        return True
+
+    def forget(self):
+        self.device, self.serial, self.found, self.lostTime = "", "", "", None
+
+    def lost(self, now: float):
+        if self.device and self.lostTime is None:
+            self.lostTime = now
+            self.recheck  = True                                                           # read failed, device file might not change
+
+    def failed(self, now: float):
+        self.found     = ""
+        self.retryTime = now + REOPEN_RETRY
+
+    def reconnected(self, now: float) -> float:
+        """ device was reopened, follow it under its new name """
+        self.latency = now - self.lostTime if self.lostTime is not None else 0.
+        self.numReconnects += 1
+        self.device, self.found, self.lostTime = self.found, "", None
+        return self.latency
+
+    def check(self, now: float) -> tuple:
+        """ compare device directory with previous check """
+        removed = False                                                                    # followed device removed, maybe created again
+        if self.watch is None:
+            devices = self.scan()
+            changed = devices != self.devices
+        else:
+            events  = self.watch.drain()
+            changed = bool(events)
+            name    = os.path.basename(self.device)
+            removed = any(mask & (IN_DELETE | IN_MOVED_FROM) and event_name == name for mask, event_name in events)
+        if changed:
+            self.devices = devices if self.watch is None else self.scan()
+        if not self.device:
+            return ("", "")
+        if self.lostTime is None:
+            if self.device in self.devices and not removed:
+                return ("", "")
+            self.lostTime, self.recheck = now, True                                        # might be back already
+            return ("lost", self.device)
+        if changed or self.recheck or now >= self.retryTime:
+            self.recheck, self.found, self.retryTime = False, "", inf
+            candidates = sorted(self.devices)
+            ids = self.identify(candidates) if candidates else {}
+            for device in candidates:
+                if ids.get(device, "") == self.serial and (self.serial or device == self.device):
+                    self.found = device
+                    break
+        elif self.found not in self.devices:
+            self.found = ""
+        return ("back", self.found) if self.found else ("", "")
+
+    def close(self):
+        if self.watch is not None:
+            self.watch.close()
+            self.watch = None
+
+#####################################################################################
+# Testing
+#####################################################################################
+
+if __name__ == '__main__':
+    import tempfile, shutil, time
+    logging.basicConfig(level=logging.DEBUG)
+
+    # fake device directory, each device file holds its serial number
+    def read_serial(devices):
+        ids = {}
+        for device in devices:
+            try:
+                with open(device) as f: ids[device] = f.read().strip()
+            except OSError:
+                pass
+        return ids
+    def plug(directory, name, serial):
+        with open(os.path.join(directory, name), 'w') as f: f.write(serial)
+
+    for use_inotify in (True, False):
+        directory = tempfile.mkdtemp()
+        try:
+            plug(directory, "ttyUSB0", "A5028")
+            plug(directory, "ttyS0", "")
+            monitor = DeviceMonitor(directory, identify=read_serial, inotify=use_inotify)
+            assert (monitor.fileno >= 0) == use_inotify
+            assert monitor.follow(os.path.join(directory, "ttyUSB0")) and monitor.serial == "A5028"
+            assert not monitor.follow(os.path.join(directory, "ttyS0"))                   # not a hot plug device
+            monitor.follow(os.path.join(directory, "ttyUSB0"))
+            assert monitor.check(0.) == ("", "")
+            os.remove(os.path.join(directory, "ttyUSB0"))
+            assert monitor.check(1.) == ("lost", os.path.join(directory, "ttyUSB0"))
+            plug(directory, "ttyUSB1", "FFFF")                                             # other adapter
+            assert monitor.check(1.1) == ("", "")
+            plug(directory, "ttyUSB2", "A5028")
+            event = monitor.check(1.2)
+            assert event == ("back", os.path.join(directory, "ttyUSB2")), event
+            assert monitor.check(1.25) == event                                            # reported until reopened
+            monitor.failed(1.25)                                                           # e.g. permissions not yet set
+            assert monitor.check(1.26) == ("", "")
+            if use_inotify:
+                os.chmod(os.path.join(directory, "ttyUSB2"), 0o644)
+                assert monitor.check(1.27) == event
+                monitor.failed(1.27)
+            assert monitor.check(1.28 + REOPEN_RETRY) == event
+            assert abs(monitor.reconnected(1.3) - 0.3) < 1e-12 and monitor.device.endswith("ttyUSB2")
+            assert monitor.check(1.4) == ("", "")
+            if use_inotify:
+                os.remove(os.path.join(directory, "ttyUSB2"))                              # reset faster than checked
+                plug(directory, "ttyUSB2", "A5028")
+                assert monitor.check(1.5) == ("lost", os.path.join(directory, "ttyUSB2"))
+                assert monitor.check(1.6)[0] == "back"
+                monitor.reconnected(1.6)
+            monitor.lost(2.)                                                               # read failed, file still there
+            assert monitor.check(2.1) == ("back", os.path.join(directory, "ttyUSB2"))
+            monitor.close()
+        finally:
+            shutil.rmtree(directory)
+        logger.log(logging.INFO, "{} ok".format("inotify" if use_inotify else "polling"))
+
+    monitor = DeviceMonitor()
+    tic = time.perf_counter()
+    for _ in range(1000):
+        monitor.check(0.)
+    logger.log(logging.INFO, "check {:.1f} us idle with {}, {} devices".format(
+        (time.perf_counter() - tic)*1000, "inotify" if monitor.fileno >= 0 else "polling", len(monitor.devices)))
@@ -0,0 +1,285 @@
+############################################################################################
+# Macro Helper
+############################################################################################
+# October 2026: command sequences with drift free scheduling
+# October 2026: periodic sender with jitter statistics
+# ------------------------------------------------------------------------------------------
+# Urs Utzinger
+# University of Arizona 2026
+############################################################################################
+############################################################################################
+# This code has no QT dependencies.
+#
+# A macro is a text with one step per line:
+#
+#   # comment
+#   send mode 2            transmit text followed by line termination
+#   sendraw \x02go\r       transmit text without line termination, \r \n \t \xhh are escaped
+#   wait 0.5               wait 0.5 milliseconds
+#   waitfor ^OK 1000       wait until a received line matches regular expression, timeout 1000 ms
+#   loop 100               repeat until matching end 100 times, loop 0 repeats until stopped
+#   end
+#
+# Waits are added to the time the previous step was due, not to the time it actually
+# executed, so delays do not accumulate and a loop with "wait 1" runs at exactly 1000/s
+# on average even if individual sends are late. The runner does not sleep, it returns
+# when the next step is due and the caller schedules it (see QSerial.on_macroTimer).
+#
+# PeriodicSchedule: absolute deadlines start + k*period for a command that is sent
+# every period, e.g. polling a sensor. The deviation of each actual period from the
+# nominal period is recorded as jitter.
+############################################################################################
+
+import logging, re, codecs, time
+from math import inf, floor
+
+from helpers.Profiler_helper import LatencyHistogram
+
+# Constants
+########################################################################################
+MAX_STEPS_PER_RUN = 10000                                                                  # return to event loop after this many steps
+DEFAULT_TIMEOUT   = 1000.                                                                  # [ms] waitfor timeout if none given
+
+logger = logging.getLogger("Macro__")
+
+############################################################################################
+# Parser
+############################################################################################
+
+def parse_macro(text: str) -> list:
+    """
+    Convert macro text into a list of steps (op, argument, argument, line number)
+    Loops are resolved into jumps: loop holds the index of its end, end the index of its loop.
+    Raises ValueError with line number on syntax errors.
+    """
+    steps, loops = [], []
+    for num, line in enumerate(text.splitlines(), start=1):
+        line = line.strip()
+        if not line or line.startswith('#'):
+            continue
+        op, _, arg = line.partition(' ')
+        op = op.lower()
+        try:
+            if op == 'send' or op == 'sendraw':
+                steps.append([op, codecs.escape_decode(arg.encode('utf-8'))[0], None, num])
+            elif op == 'wait':
+                steps.append([op, float(arg)/1000., None, num])
+            elif op == 'waitfor':
+                pattern, _, timeout = arg.rpartition(' ')
+                try:
+                    timeout = float(timeout)
+                except ValueError:
+                    pattern, timeout = arg, DEFAULT_TIMEOUT
+                steps.append([op, re.compile(pattern.encode('utf-8')), timeout/1000., num])
+            elif op == 'loop':
+                loops.append(len(steps))
+                steps.append([op, int(arg) if arg else 0, None, num])
+            elif op == 'end':
+                if not loops:
+                    raise ValueError("end without loop")
+                start = loops.pop()
+                steps[start][2] = len(steps)
+                steps.append([op, start, None, num])
+            else:
+                raise ValueError("unknown step")
+        except (ValueError, IndexError, re.error) as e:
+            raise ValueError("line {}: {} ({})".format(num, line, e)) from None
+    if loops:
+        raise ValueError("line {}: loop without end".format(steps[loops[-1]][3]))
+    return steps
+
+############################################################################################
+# Runner
+############################################################################################
+
+class MacroRunner():
+    """
+    Executes a parsed macro
+
+    run(now) executes all steps that are due and returns the time the next step is due
+    (or the timeout of a waitfor step), None when the macro finished.
+    feed(lines) provides received lines for waitfor steps.
+    send(bytes, bool) is called for each send step, bool requests line termination.
+    """
+
+    def __init__(self, text: str, send=None):
+        self.steps    = parse_macro(text)
+        self.send     = send
+        self.pc       = 0                                                                  # current step
+        self.counters = {}                                                                 # loop index: remaining iterations
+        self.deadline = 0.                                                                 # [s] perf_counter when current step is due
+        self.timeout  = inf                                                                # [s] perf_counter when waitfor fails
+        self.matched  = False
+        self.error    = ""
+        self.numSent  = 0
+
+    def start(self, now: float = None):
+        self.pc, self.counters, self.numSent, self.error = 0, {}, 0, ""
+        self.deadline = time.perf_counter() if now is None else now
+        self.timeout  = inf
+
+    @property
+    def finished(self) -> bool:
+        return self.pc >= len(self.steps)
+
+    @property
+    def waitingFor(self):
+        """ pattern of current waitfor step or None """
+        if not self.finished and self.steps[self.pc][0] == 'waitfor':
+            return self.steps[self.pc][1]
+        return None
+
+    def feed(self, lines: list, now: float = None):
+        """ check received lines for pattern of current waitfor step """
+        pattern = self.waitingFor
+        if pattern is not None and not self.matched:
+            for line in lines:
+                if pattern.search(line):
+                    self.matched  = True
+                    if now is None: now = time.perf_counter()
+                    self.deadline = max(self.deadline, now)                                # following waits count from match
+                    break
+
+    def stop(self, error: str = ""):
+        self.pc    = len(self.steps)
+        self.error = error
+
+    def run(self, now: float):
+        """ execute due steps, return when next step is due """
+        for _ in range(MAX_STEPS_PER_RUN):
+            if self.finished:
+                return None
+            op, arg, arg2, num = self.steps[self.pc]
+            if op == 'send' or op == 'sendraw':
+                if now < self.deadline:
+                    return self.deadline
+                self.send(arg, op == 'send')
+                self.numSent += 1
+            elif op == 'wait':
+                self.deadline += arg
+            elif op == 'waitfor':
+                if not self.matched:
+                    if self.timeout == inf:
+                        self.timeout = self.deadline + arg2                                # pattern has arg2 to show up
+                    if now >= self.timeout:
+                        self.stop("line {}: no response matching {} within {:.0f} ms".format(num, arg.pattern, arg2*1000))
+                        return None
+                    return self.timeout
+                self.matched = False
+                self.timeout = inf
+            elif op == 'loop':
+                if arg > 0:
+                    self.counters[self.pc] = arg
+            elif op == 'end':
+                if arg in self.counters:
+                    self.counters[arg] -= 1
+                    if self.counters[arg] <= 0:
+                        del self.counters[arg]
+                        self.pc += 1
+                        continue
+                self.pc = arg + 1                                                          # back to first step in loop
+                continue
+            self.pc += 1
+        return now                                                                         # many steps without waiting, continue after event loop
+
+############################################################################################
+# Periodic Schedule
+############################################################################################
+
+class PeriodicSchedule():
+    """
+    Absolute deadlines for periodic events
+
+    start(now, period)                first event is due now
+    due                               [s] perf_counter of next event
+    fire(now)                         account for event that occurred now, advance deadline
+    jitter                            histogram of |actual period - period| [ns]
+    numMissed                         deadlines skipped because event was more than a period late
+    """
+
+    def __init__(self):
+        self.period    = 0.
+        self.jitter    = LatencyHistogram()
+        self.start(0., 1.)
+
+    def start(self, now: float, period: float):
+        self.period    = period
+        self.t0        = now
+        self.k         = 0
+        self.due       = now
+        self.last      = None
+        self.numFired  = 0
+        self.numMissed = 0
+        self.sumPeriod = 0.
+        self.jitter.reset()
+
+    def fire(self, now: float):
+        """ event occurred, next deadline is t0 + k*period, never now + period """
+        if self.last is not None:
+            actual = now - self.last
+            self.sumPeriod += actual
+            self.jitter.record(int(abs(actual - self.period)*1e9))
+        self.last = now
+        self.numFired += 1
+        self.k += 1
+        if now - self.t0 >= self.k*self.period:
+            # more than one period late, skip deadlines instead of sending a burst
+            k = floor((now - self.t0)/self.period) + 1
+            self.numMissed += k - self.k
+            self.k = k
+        self.due = self.t0 + self.k*self.period
+
+    def stats(self):
+        """ mean period, p99 and max jitter [s], missed since last call """
+        mean = self.sumPeriod/self.jitter.count if self.jitter.count > 0 else 0.
+        result = (mean, self.jitter.percentile(99)/1e9, self.jitter.max/1e9, self.numMissed)
+        self.sumPeriod, self.numMissed = 0., 0
+        self.jitter.reset()
+        return result
+
+#####################################################################################
+# Testing
+#####################################################################################
+
+if __name__ == '__main__':
+    logging.basicConfig(level=logging.DEBUG)
+
+    sent = []
+    runner = MacroRunner("""
+        # comment
+        send mode 2
+        loop 3
+          sendraw \\x02
+          wait 10
+        end
+        waitfor ^OK 50
+        send done
+    """, send=lambda data, eol: sent.append((data, eol)))
+    runner.start(0.)
+    assert runner.run(0.) == 0.01 and sent == [(b'mode 2', True), (b'\x02', False)]
+    assert runner.run(0.0105) == 0.02 and len(sent) == 3
+    assert runner.run(0.02) == 0.08                                                        # waitfor timeout due 50 ms after last wait
+    runner.feed([b'ERR', b'OK 1'], now=0.035)
+    assert runner.run(0.035) is None and sent[-1] == (b'done', True) and runner.numSent == 5
+    logger.log(logging.INFO, "macro ok")
+
+    runner = MacroRunner("waitfor ^OK 5\nsend x", send=lambda data, eol: None)
+    runner.start(0.)
+    assert runner.run(0.) == 0.005 and runner.run(0.006) is None and "no response" in runner.error
+    p = PeriodicSchedule()
+    p.start(0., 0.01)
+    p.fire(0.)
+    p.fire(0.0102)                                                                         # late, next deadline is still 0.02
+    assert abs(p.due - 0.02) < 1e-12
+    p.fire(0.0451)                                                                         # 0.03 and 0.04 missed
+    assert p.numMissed == 2 and abs(p.due - 0.05) < 1e-12
+    mean, p99, mx, missed = p.stats()
+    assert abs(mx - 0.0249) < 0.0005 and missed == 2
+    logger.log(logging.INFO, "periodic ok")
+
+    for bad in ("loop 2\nsend x", "end", "jump 3", "wait x"):
+        try:
+            parse_macro(bad)
+            assert False
+        except ValueError as e:
+            logger.log(logging.INFO, "expected error {}".format(e))
@@ -0,0 +1,127 @@
+############################################################################################
+# Monitor Helper
+############################################################################################
+# October 2026: ring of received lines for the line monitor
+# ------------------------------------------------------------------------------------------
+# Urs Utzinger
+# University of Arizona 2026
+############################################################################################
+############################################################################################
+# This code has no QT dependencies.
+#
+# LineRing keeps the newest capacity lines of text in a list that is allocated once. New
+# lines overwrite the oldest ones, memory does not grow with the time the monitor runs and
+# nothing is copied when old lines are dropped:
+#
+#   extend(lines)         add lines, returns number of oldest lines dropped
+#   ring[row]             row 0 is the oldest line retained
+#   rows(first, last)     lines shown in the window, cost depends on the window only
+#   first                 number of lines dropped since clear(), row 0 is line first+1
+#
+# Absolute line numbers (first + row) do not change when old lines are dropped, a selection
+# stored with them stays on the same lines while new lines arrive.
+############################################################################################
+
+import logging
+
+# Constants
+########################################################################################
+MONITOR_LINES = 1000000                                                                    # lines retained by the line monitor
+
+logger = logging.getLogger("Monitor")
+
+class LineRing():
+    """
+    Fixed capacity ring of lines, oldest lines are overwritten
+    """
+
+    def __init__(self, capacity: int = MONITOR_LINES):
+        self.capacity = max(int(capacity), 1)
+        self.lines    = [""]*self.capacity
+        self.head     = 0                                                                  # slot of row 0
+        self.count    = 0                                                                  # lines retained
+        self.first    = 0                                                                  # lines dropped since clear
+
+    def __len__(self) -> int:
+        return self.count
+
+    def __getitem__(self, row: int) -> str:
+        return self.lines[(self.head + row) % self.capacity]
+
+    def clear(self):
+        self.lines[:] = [""]*self.capacity                                                 # release the strings
+        self.head, self.count, self.first = 0, 0, 0
+
+    def extend(self, lines: list) -> int:
+        """ add lines, returns number of oldest lines that were overwritten """
+        n = len(lines)
+        if n > self.capacity:
+            self.first += n - self.capacity                                                # never retained
+            lines, n = lines[-self.capacity:], self.capacity
+        end   = (self.head + self.count) % self.capacity
+        part  = min(n, self.capacity - end)                                                # before wrapping around
+        self.lines[end:end+part] = lines[:part]
+        self.lines[:n-part]      = lines[part:]
+        dropped = max(self.count + n - self.capacity, 0)
+        self.head   = (self.head + dropped) % self.capacity
+        self.count  = min(self.count + n, self.capacity)
+        self.first += dropped
+        return dropped
+
+    def rows(self, first: int, last: int) -> list:
+        """ lines of rows first..last-1 """
+        first, last = max(first, 0), min(last, self.count)
+        if first >= last:
+            return []
+        start = (self.head + first) % self.capacity
+        stop  = start + last - first
+        if stop <= self.capacity:
+            return self.lines[start:stop]
+        return self.lines[start:] + self.lines[:stop - self.capacity]
+
+    def text(self) -> str:
+        """ all retained lines, e.g. to save them """
+        return "\n".join(self.rows(0, self.count))
+
+#####################################################################################
+# Testing
+#####################################################################################
+
+if __name__ == '__main__':
+    import time, tracemalloc
+    logging.basicConfig(level=logging.DEBUG)
+
+    ring = LineRing(5)
+    assert ring.extend(["a", "b", "c"]) == 0 and ring.rows(0, 10) == ["a", "b", "c"]
+    assert ring.extend(["d", "e", "f", "g"]) == 2 and ring.rows(0, 5) == ["c", "d", "e", "f", "g"]
+    assert ring[0] == "c" and ring.first == 2 and ring.rows(3, 9) == ["f", "g"]
+    assert ring.extend([str(i) for i in range(12)]) == 5 and ring.first == 14 and ring.text() == "7\n8\n9\n10\n11"
+    ring.clear()
+    assert len(ring) == 0 and ring.rows(0, 5) == [] and ring.first == 0
+    logger.log(logging.INFO, "ring ok")
+
+    # 40k lines/s in batches of 200, memory stays constant once the ring is full
+    def add(ring, batch):
+        ring.extend(["{},{},{}".format(i, -2*i, i % 97) for i in range(batch*200, batch*200 + 200)])
+    capacity = 100000
+    tracemalloc.start()
+    ring = LineRing(capacity)
+    for batch in range(capacity//200):
+        add(ring, batch)
+    full = tracemalloc.get_traced_memory()[0]
+    for batch in range(capacity//200, 4*capacity//200):
+        add(ring, batch)
+    grown = tracemalloc.get_traced_memory()[0] - full
+    tracemalloc.stop()
+    assert len(ring) == capacity and ring[0] == "{},{},{}".format(ring.first, -2*ring.first, ring.first % 97)
+    assert abs(grown) < 0.05*full, (grown, full)
+    ring = LineRing(MONITOR_LINES)
+    tic = time.perf_counter()
+    for batch in range(2*MONITOR_LINES//200):
+        add(ring, batch)
+    toc = time.perf_counter()
+    for row in range(0, MONITOR_LINES, 1000):
+        ring.rows(row, row + 50)                                                           # one window of visible rows
+    tac = time.perf_counter()
+    logger.log(logging.INFO, "{} lines in {:.1f} MB, grows {} bytes when full; {} lines: extend {:.0f} k lines/s, window of 50 rows {:.1f} us".format(
+        capacity, full/1e6, grown, len(ring), 2*MONITOR_LINES/(toc - tic)/1000, (tac - toc)/(MONITOR_LINES//1000)*1e6))
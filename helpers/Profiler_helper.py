@@ -0,0 +1,422 @@
+############################################################################################
+# Profiler Helper
+############################################################################################
+# October 2026: tracing of the receiver and display pipeline
+# October 2026: pipeline metrics with latency histograms
+# ------------------------------------------------------------------------------------------
+# Urs Utzinger
+# University of Arizona 2026
+############################################################################################
+############################################################################################
+# This code has no QT dependencies and can be used from any thread.
+#
+# Tracer: records timed events into a preallocated ring buffer.
+#   When tracing is off the only cost at a call site is checking tracer.enabled.
+#   When tracing is on each event is one row in a numpy structured array
+#   (start, duration, event, thread, value), no strings are formatted.
+#   The buffer can be saved as compact numpy file or in Chrome trace format,
+#   which can be opened with chrome://tracing or https://ui.perfetto.dev
+#
+# Usage:
+#   EV_READ = tracer.register("PSerial.read")
+#   ...
+#   tracing = tracer.enabled                    read once, the user can start tracing meanwhile
+#   if tracing: tic = time.perf_counter_ns()
+#   ...
+#   if tracing: tracer.record(EV_READ, tic, time.perf_counter_ns(), num_bytes)
+#
+# start() replaces buffer and event counter with one assignment, a thread that is recording
+# while tracing is restarted writes into the buffer it started with.
+#
+# Metrics: counters and latency histograms for each stage of the pipeline
+#   read, frame, parse, push, plot, text ...
+#   Updated once per batch of data, not per line, so it remains enabled all the time.
+#   A snapshot converts the counters into rates (lines/s, samples/s, bytes/s)
+#   and latency percentiles since the previous snapshot.
+#   MetricsWriter appends snapshots to a CSV or JSON lines file.
+############################################################################################
+############################################################################################
+# Helpful readings:
+# ------------------------------------------------------------------------------------------
+# Chrome trace event format
+#      https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU
+# HDR histogram
+#      http://hdrhistogram.org/
+############################################################################################
+
+import logging, threading, json, itertools, time
+
+# Numerical Math
+import numpy as np
+
+# Constants
+########################################################################################
+TRACE_CAPACITY = 1 << 20                                                                   # [events] ring buffer length, oldest events are overwritten
+TRACE_DTYPE = np.dtype([                                                                   # 26 bytes per event
+    ('ts',  '<i8'),                                                                        # [ns] start, time.perf_counter_ns
+    ('dur', '<i8'),                                                                        # [ns] duration
+    ('ev',  '<u2'),                                                                        # event id from register()
+    ('tid', '<u4'),                                                                        # thread index
+    ('val', '<i8'),                                                                        # e.g. number of bytes or lines
+])
+HISTOGRAM_SUB_BITS   = 7                                                                   # 64 linear sub buckets per power of 2, 1.6% resolution
+HISTOGRAM_MAX_BITS   = 40                                                                  # [ns] largest value 2**40 ns = 18 minutes
+METRICS_COLUMNS      = ["time", "stage", "events/s", "lines/s", "samples/s", "bytes/s",
+                        "p50 ms", "p99 ms", "max ms", "queue", "errors"]
+
+# Tracer
+########################################################################################
+
+class Tracer():
+    """
+    Low overhead event tracer
+
+    register(name)                    obtain event id for a name, call once at import
+    start(capacity)                   allocate ring buffer and enable tracing
+    stop()                            disable tracing, keeps recorded events
+    record(ev, tic, toc, val)         add event with perf_counter_ns start and end
+    events                            recorded events in chronological order
+    save(fname)                       save events as numpy file (.npy)
+    save_chrome(fname)                save events as Chrome trace (.json)
+    """
+
+    def __init__(self):
+        self.logger    = logging.getLogger("Tracer_")
+        self.enabled   = False                                                             # check this before collecting trace data
+        self._names    = []                                                                # event names, index is event id
+        self._threads  = {}                                                                # thread ident to thread index
+        self._threadNames = []                                                             # thread names, index is thread index
+        self._ring     = (np.zeros(0, dtype=TRACE_DTYPE), itertools.count())              # buffer and event counter, next() is atomic with the GIL
+        self._lock     = threading.Lock()                                                  # thread registration
+
+    def register(self, name: str) -> int:
+        """ obtain id for event name """
+        if name in self._names:
+            return self._names.index(name)
+        self._names.append(name)
+        return len(self._names) - 1
+
+    def start(self, capacity: int = TRACE_CAPACITY):
+        """ allocate buffer and start recording """
+        self._ring   = (np.zeros(capacity, dtype=TRACE_DTYPE), itertools.count())          # unused rows have ts == 0
+        self.enabled = True
+        self.logger.log(logging.INFO, "[{}]: Tracing started with {} events capacity.".format(threading.get_ident(), capacity))
+
+    def stop(self):
+        """ stop recording, events remain available """
+        self.enabled = False
+        self.logger.log(logging.INFO, "[{}]: Tracing stopped.".format(threading.get_ident()))
+
+    def record(self, ev: int, tic: int, toc: int, val: int = 0):
+        """ add one event, tic and toc are from time.perf_counter_ns() """
+        ident = threading.get_ident()
+        tid = self._threads.get(ident)
+        if tid is None:
+            tid = self._addThread(ident)
+        events, counter = self._ring                                                       # consistent pair even if start() runs meanwhile
+        events[next(counter) % len(events)] = (tic, toc - tic, ev, tid, val)
+
+    def _addThread(self, ident: int) -> int:
+        with self._lock:
+            tid = len(self._threadNames)
+            self._threadNames.append(threading.current_thread().name)
+            self._threads[ident] = tid
+        return tid
+
+    @property
+    def numEvents(self) -> int:
+        """ number of events currently held in the buffer """
+        return int(np.count_nonzero(self._ring[0]['ts']))
+
+    @property
+    def events(self) -> np.ndarray:
+        """ recorded events sorted by start time """
+        events = self._ring[0]
+        events = events[events['ts'] != 0]
+        return np.sort(events, order='ts')
+
+    def save(self, fname: str):
+        """ save binary events and names """
+        np.save(fname, self.events)
+        with open(fname + ".names.json", 'w') as f:
+            json.dump({"events": self._names, "threads": self._threadNames}, f)
+
+    def save_chrome(self, fname: str):
+        """ save events in Chrome trace format """
+        events = self.events
+        names  = self._names
+        traceEvents = [
+            {"name": names[ev], "ph": "X", "pid": 1, "tid": tid, "ts": ts/1000., "dur": dur/1000., "args": {"n": val}}
+            for ts, dur, ev, tid, val in events.tolist()
+        ]
+        traceEvents += [
+            {"name": "thread_name", "ph": "M", "pid": 1, "tid": tid, "args": {"name": name}}
+            for tid, name in enumerate(self._threadNames)
+        ]
+        with open(fname, 'w') as f:
+            json.dump({"traceEvents": traceEvents, "displayTimeUnit": "ms"}, f)
+        self.logger.log(logging.INFO, "[{}]: Saved {} trace events to {}.".format(threading.get_ident(), len(events), fname))
+
+# Process wide tracer, modules register their events at import
+tracer = Tracer()
+
+# Latency Histogram
+########################################################################################
+
+class LatencyHistogram():
+    """
+    HDR style histogram of durations in nanoseconds
+
+    Values below 2**HISTOGRAM_SUB_BITS are counted exactly, larger values are counted
+    in buckets that are equally spaced within each power of 2, so the relative error 
+    is constant over the whole range.
+
+    record(ns)                        count one value
+    percentile(p)                     value [ns] below which p percent of values are
+    max                               largest value [ns]
+    count                             number of values
+    reset()                           clear all counts
+    """
+
+    def __init__(self, sub_bits: int = HISTOGRAM_SUB_BITS, max_bits: int = HISTOGRAM_MAX_BITS):
+        self._subBits  = sub_bits
+        self._half     = 1 << (sub_bits - 1)
+        self._maxValue = (1 << max_bits) - 1
+        self._counts   = np.zeros(self._index(self._maxValue) + 1, dtype=np.int64)
+        self.count     = 0
+        self.max       = 0
+
+    def _index(self, v: int) -> int:
+        """ bucket of value """
+        shift = v.bit_length() - self._subBits
+        if shift <= 0:
+            return v
+        return shift*self._half + (v >> shift)
+
+    def _value(self, idx: int) -> int:
+        """ lowest value in bucket """
+        if idx < 2*self._half:
+            return idx
+        shift = idx // self._half - 1
+        return (idx - shift*self._half) << shift
+
+    def record(self, ns: int):
+        """ count one value """
+        v = min(max(int(ns), 0), self._maxValue)
+        self._counts[self._index(v)] += 1
+        self.count += 1
+        if v > self.max: self.max = v
+
+    def percentile(self, p: float) -> int:
+        """ value [ns] at percentile p (0..100) """
+        if self.count == 0:
+            return 0
+        # first bucket that reaches the requested fraction of counts, report its upper edge
+        idx = int(np.searchsorted(np.cumsum(self._counts), max(p/100.*self.count, 1)))
+        if idx + 1 >= len(self._counts):
+            return self.max
+        return min(self._value(idx + 1) - 1, self.max)
+
+    def reset(self):
+        """ clear all counts """
+        self._counts[:] = 0
+        self.count = 0
+        self.max = 0
+
+# Pipeline Metrics
+########################################################################################
+
+class Stage():
+    """
+    Counters of one pipeline stage
+
+    add(...)                          account for one processed batch
+    queue                             current queue depth in front of this stage
+    """
+
+    def __init__(self, name: str):
+        self.name      = name
+        self.events    = 0
+        self.lines     = 0
+        self.samples   = 0
+        self.bytes     = 0
+        self.errors    = 0
+        self.queue     = 0
+        self.latency   = LatencyHistogram()
+        self._last     = (0, 0, 0, 0)                                                      # events, lines, samples, bytes at last snapshot
+
+    def add(self, lines: int = 0, samples: int = 0, nbytes: int = 0, ns: int = -1, errors: int = 0):
+        """ account for one batch, ns is the time it took to process it """
+        self.events  += 1
+        self.lines   += lines
+        self.samples += samples
+        self.bytes   += nbytes
+        self.errors  += errors
+        if ns >= 0: self.latency.record(ns)
+
+    def snapshot(self, dt: float) -> dict:
+        """ rates since previous snapshot, dt in seconds """
+        now = (self.events, self.lines, self.samples, self.bytes)
+        rates = [(n - l)/dt if dt > 0 else 0. for n, l in zip(now, self._last)]
+        self._last = now
+        result = {
+            "stage":     self.name,
+            "events/s":  rates[0],
+            "lines/s":   rates[1],
+            "samples/s": rates[2],
+            "bytes/s":   rates[3],
+            "p50 ms":    self.latency.percentile(50)/1e6,
+            "p99 ms":    self.latency.percentile(99)/1e6,
+            "max ms":    self.latency.max/1e6,
+            "queue":     self.queue,
+            "errors":    self.errors,
+        }
+        self.latency.reset()
+        return result
+
+class QueueCounter():
+    """
+    Batches handed from one thread to another that were not yet processed
+
+    One counter for each signal and consumer slot. The producer calls put() before
+    emitting the signal, the consumer calls get() for each batch it handles. This
+    measures the length of the QT event queue in front of that consumer.
+    Only the producer thread writes puts and only the consumer thread writes gets,
+    no lock is needed. A consumer that reconnects gets a new counter.
+    """
+
+    def __init__(self):
+        self.puts = 0
+        self.gets = 0
+
+    def put(self):
+        self.puts += 1
+
+    def get(self) -> int:
+        """ mark one batch as processed, returns queue depth when it was picked up """
+        depth = self.puts - self.gets
+        self.gets += 1
+        return depth
+
+    @property
+    def depth(self) -> int:
+        return self.puts - self.gets
+
+class Metrics():
+    """
+    Registry of pipeline stages
+
+    stage(name)                       obtain stage, created on first use
+    snapshot()                        list of stage rates since last snapshot
+    """
+
+    def __init__(self):
+        self.stages   = {}
+        self._lastTime = time.perf_counter()
+
+    def stage(self, name: str) -> Stage:
+        """ obtain stage by name """
+        s = self.stages.get(name)
+        if s is None:
+            s = self.stages.setdefault(name, Stage(name))
+        return s
+
+    def snapshot(self) -> list:
+        """ rates and latencies of all stages since the previous snapshot """
+        now = time.perf_counter()
+        dt = now - self._lastTime
+        self._lastTime = now
+        return [s.snapshot(dt) for s in list(self.stages.values())]
+
+class MetricsWriter():
+    """
+    Appends metrics snapshots to a file
+
+    Files ending with .json are written as one JSON object per line,
+    all other files as comma separated values with a header.
+    """
+
+    def __init__(self, fname: str):
+        self.fname = fname
+        self.json  = fname.lower().endswith(".json")
+        self.fh    = open(fname, 'w')
+        if not self.json:
+            self.fh.write(",".join(METRICS_COLUMNS) + "\n")
+
+    def write(self, snapshot: list):
+        """ append one snapshot """
+        t = time.time()
+        if self.json:
+            self.fh.write(json.dumps({"time": t, "stages": snapshot}) + "\n")
+        else:
+            for row in snapshot:
+                row = dict(row, time=t)
+                self.fh.write(",".join(str(row.get(c, "")) for c in METRICS_COLUMNS) + "\n")
+        self.fh.flush()
+
+    def close(self):
+        self.fh.close()
+
+# Process wide metrics, stages are created by the modules that process data
+metrics = Metrics()
+
+#####################################################################################
+# Testing
+#####################################################################################
+
+if __name__ == '__main__':
+    import tempfile, os
+    logging.basicConfig(level=logging.DEBUG)
+    EV_TEST = tracer.register("test")
+    tracer.start(capacity=8)
+    for i in range(10):
+        tic = time.perf_counter_ns()
+        tracer.record(EV_TEST, tic, time.perf_counter_ns(), i)
+    assert tracer.numEvents == 8
+    assert list(tracer.events['val']) == list(range(2, 10))
+    fname = os.path.join(tempfile.gettempdir(), "trace.json")
+    tracer.save_chrome(fname)
+    with open(fname) as f: assert len(json.load(f)["traceEvents"]) == 9
+    tracer.stop()
+    n = 100000
+    tic = time.perf_counter()
+    for i in range(n):
+        if tracer.enabled: tracer.record(EV_TEST, 1, 1, i)
+    toc = time.perf_counter()
+    tracer.logger.log(logging.INFO, "disabled call site {:.3f} us".format(1e6*(toc-tic)/n))
+    tracer.start(capacity=n)
+    tic = time.perf_counter()
+    for i in range(n):
+        if tracer.enabled: tracer.record(EV_TEST, 1, 1, i)
+    toc = time.perf_counter()
+    tracer.logger.log(logging.INFO, "enabled call site {:.3f} us".format(1e6*(toc-tic)/n))
+    # restart with other capacity while threads record
+    failures = []
+    def recorder():
+        try:
+            for i in range(20000):
+                tracing = tracer.enabled
+                if tracing: tic = time.perf_counter_ns()
+                if tracing: tracer.record(EV_TEST, tic, time.perf_counter_ns(), i)
+        except Exception as e:
+            failures.append(e)
+    threads = [threading.Thread(target=recorder) for _ in range(4)]
+    for t in threads: t.start()
+    for i in range(200):
+        tracer.start(capacity=16 + i % 7)
+    for t in threads: t.join()
+    assert not failures, failures
+    tracer.logger.log(logging.INFO, "restart while recording ok")
+
+    h = LatencyHistogram()
+    values = np.random.default_rng(0).integers(1, 10_000_000, 100000)
+    for v in values.tolist(): h.record(v)
+    for p in (50, 99):
+        exact = np.percentile(values, p)
+        assert abs(h.percentile(p) - exact) / exact < 0.02, (p, h.percentile(p), exact)
+    assert h.max == values.max()
+    m = Metrics()
+    m.stage("read").add(lines=10, nbytes=100, ns=1000)
+    snap = m.snapshot()
+    assert snap[0]["stage"] == "read" and snap[0]["bytes/s"] > 0
+    tracer.logger.log(logging.INFO, "metrics ok")
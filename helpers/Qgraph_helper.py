@@ -2,6 +2,12 @@
 # QT Chart Helper
 ############################################################################################
 # December 2023: added chart plotting
+# October 2026: COBS and SLIP framed binary packets
+# October 2026: packet layout selects chart channels
+# October 2026: plotting of raw samples without line termination
+# October 2026: sequence number column, gaps interrupt the plotted lines
+# October 2026: device timestamp column as horizontal axis
+# October 2026: one trace per port of a multi port session
 # ------------------------------------------------------------------------------------------
 # Urs Utzinger
 # University of Arizona 2023
@@ -24,7 +30,7 @@
 import logging, time
 
 from PyQt5.QtCore import QObject, QTimer, QThread, pyqtSlot, QStandardPaths
-from PyQt5.QtWidgets import QFileDialog, QLineEdit, QSlider, QTabWidget, QGraphicsView, QVBoxLayout
+from PyQt5.QtWidgets import QFileDialog, QLineEdit, QSlider, QTabWidget, QGraphicsView, QVBoxLayout, QInputDialog
 
 # QT Graphing for chart plotting
 import pyqtgraph as pg
@@ -32,6 +38,12 @@ import pyqtgraph as pg
 # Numerical Math
 import numpy as np
 
+# Parsing of received lines
+from helpers.Codec_helper import lines_to_array, packets_to_array, parse_layout, SampleStream, SequenceCounter, insert_breaks, DeviceClock, DATA_SEPARATORS, SAMPLE_TYPES, TIME_UNITS
+
+# Tracing of display pipeline
+from helpers.Profiler_helper import tracer, metrics, QueueCounter
+
 # Constants
 ########################################################################################
 MAX_ROWS = 44100 # data history length
@@ -39,6 +51,18 @@ MAX_COLUMNS = 4 # max number of signal traces
 UPDATE_INTERVAL = 100 # milliseconds, visualization does not improve with updates faster than 10 Hz
 COLORS = ['green', 'red', 'blue', 'black'] # need to have MAX_COLUMNS colors
 
+# Trace events
+EV_PLOT  = tracer.register("QChartUI.updatePlot")
+EV_LINES = tracer.register("QChartUI.on_newLinesReceived")
+EV_PACKETS = tracer.register("QChartUI.on_newPacketsReceived")
+EV_BYTES = tracer.register("QChartUI.on_newBytesReceived")
+
+# Pipeline stages
+STAGE_PARSE = metrics.stage("parse")
+STAGE_PUSH  = metrics.stage("push")
+STAGE_PLOT  = metrics.stage("plot")
+STAGE_SEQUENCE = metrics.stage("sequence")                                                 # lines are checked rows, errors are lost rows
+
 # Support Functions and Classes
 ########################################################################################
 
@@ -100,7 +124,8 @@ class QChartUI(QObject):
     The chart displays up MAX_COLUMNS (4) signals in a plot.
     The data is received from the serial port and organized into columns of a numpy array.
     The plot can be zoomed in by selecting how far back in time to display it.
-    The horizontal axis is the sample number.
+    The horizontal axis is the sample number, or the time of a device timestamp column
+    converted to host time since the chart was created.
     The vertical axis is auto scaled to the max and minimum values of the data.
 
     Slots (functions available to respond to external signals)
@@ -111,10 +136,20 @@ class QChartUI(QObject):
         on_HorizontalSliderChanged(int)
         on_HorizontalLineEditChanged
         on_newLineReceived(bytes)
-        on_newLinesReceived(list)
+        on_newLinesReceived(list, float)
+        on_newPacketsReceived(list, float)
+        on_newBytesReceived(bytes, float)
+        on_actionPacketLayout
+        on_actionRawSamples
+        on_actionSequenceColumn
+        on_actionTimeColumn
+        on_sessionDataReceived(time, array)
         
     Functions
         updatePlot()
+        pushData(array, x)
+        startSession(port names)
+        stopSession()
     """
     
     # Signals
@@ -164,6 +199,15 @@ class QChartUI(QObject):
         self.buffer = CircularBuffer()
         
         self.textDataSeparator = b',' # comma
+        self.packetLayout = None # binary packet fields, None for int16 samples
+        self.sampleStream = SampleStream() # raw samples without line termination, int16 one channel
+        self.sequenceColumn = -1 # column with sequence number, not plotted, -1 for none
+        self.sequence = SequenceCounter() # lost, duplicated and restarted rows
+        self.timeColumn = -1 # column with device timestamp used as horizontal axis, -1 for sample number
+        self.deviceClock = DeviceClock() # device timestamps to host time
+        self.timeOrigin = time.perf_counter() # host time at zero of horizontal axis
+        self.sessionRunning = False # multi port session provides time and one column per port
+        self.rxQueues = {kind: QueueCounter() for kind in ("lines", "text", "packets")} # replaced by worker when connecting
         
         # Initialize the plot axis ranges
         self.chartWidget.setXRange(0, self.maxPoints)
@@ -199,11 +243,13 @@ class QChartUI(QObject):
         Set vertical range to min and max of data.
         """
         
-        tic = time.perf_counter()
+        tic = time.perf_counter_ns()
         data = self.buffer.data
 
         # where do we have valid data?
         have_data = ~np.isnan(data)
+        # rows inserted at sequence gaps have a sample number but no data
+        breaks = have_data[:,0] & ~have_data[:,1:].any(axis=1) if self.sequenceColumn >= 0 else None
         max_y = -np.inf
         min_y =  np.inf
         max_x = -np.inf
@@ -219,72 +265,248 @@ class QChartUI(QObject):
             if y.size > 0: # avoid empty numpy array
                 max_y = max([np.max(y), max_y]) # update max and min
                 min_y = min([np.min(y), min_y])
-            self.data_line[i].setData(x, y) # update the plot
+            if breaks is not None and y.size > 0:
+                show = have_column_data | breaks
+                self.data_line[i].setData(data[show,0], data[show,i+1]/1000., connect="finite") # nan interrupts the line
+            else:
+                self.data_line[i].setData(x, y) # update the plot
 
         if min_x <= max_x: # we found valid data
-            self.chartWidget.setXRange(max_x - self.maxPoints, max_x) # set the horizontal range
+            if self.timeColumn >= 0 or self.sessionRunning:
+                # time axis, show the newest maxPoints samples
+                recent = data[-self.maxPoints:,0]
+                recent = recent[~np.isnan(recent)]
+                self.chartWidget.setXRange(recent.min() if recent.size > 0 else min_x, max_x)
+            else:
+                self.chartWidget.setXRange(max_x - self.maxPoints, max_x) # set the horizontal range
         if min_y <= max_y: 
             self.chartWidget.setYRange(min_y, max_y) # set the vertical range
         self.chartWidget.addLegend() # add a legend
 
-        toc = time.perf_counter()            
-        self.logger.log(logging.DEBUG, "[{}]: Plot updated in {} ms".format(int(QThread.currentThreadId()), 1000*(toc-tic)))
+        toc = time.perf_counter_ns()
+        STAGE_PLOT.add(samples=self.maxPoints, ns=toc-tic)                                 # GUI frame time
+        if tracer.enabled: tracer.record(EV_PLOT, tic, toc, MAX_COLUMNS)
 
     @pyqtSlot()
     def on_changeDataSeparator(self):
         ''' user wants to change the data separator '''
         _tmp = self.ui.comboBoxDropDown_DataSeparator.currentText()
-        if _tmp == "comma (,)":
-            self.textDataSeparator = b','
-        elif _tmp == "semicolon (;)":
-            self.textDataSeparator = b';'
-        elif _tmp == "point (.)":
-            self.textDataSeparator = b'.'
-        elif _tmp == "space (\\s)":
-            self.textDataSeparator = b' '
-        else:
-            self.textDataSeparator = b','            
+        self.textDataSeparator = DATA_SEPARATORS.get(_tmp, b',')
         self.logger.log(logging.INFO, "[{}]: Data separator {}".format(int(QThread.currentThreadId()), repr(self.textDataSeparator)))
         self.ui.statusBar().showMessage('Data Separator changed.', 2000)            
 
-    @pyqtSlot(list)
-    def on_newLinesReceived(self, lines: list):
+    @pyqtSlot(list, float)
+    def on_newLinesReceived(self, lines: list, arrival: float):
         """
         Decode a received list of bytes lines and add data to the circular buffer
+        arrival is the perf_counter time the serial worker read the lines
         """
-        tic = time.perf_counter()
-        # parse text into numbers, textDataSeparator is a byte string, filter removes empty strings and \n and \r
-        # the filter is necessary if data is lost during serial tranmission and a partial end of line is received
-        data = [list(map(float, filter(None, line.split(self.textDataSeparator)))) for line in lines if not (b'\n' in line or b'\r' in line)]
-        #toc = time.perf_counter()
-        #self.logger.log(logging.DEBUG, "[{}]: Lines to Data: took {} ms".format(int(QThread.currentThreadId()), 1000*(toc-tic))) # 200 microseconds
+        tic = time.perf_counter_ns()
+        # parse text into numbers, textDataSeparator is a byte string
+        data_array, num_errors = lines_to_array(lines, self.textDataSeparator) # 200 microseconds
+        toc = time.perf_counter_ns()
+        STAGE_PARSE.queue = self.rxQueues["lines"].get()
+        STAGE_PARSE.add(lines=len(lines), samples=data_array.size, ns=toc-tic, errors=num_errors)
+        num_rows = self.pushData(data_array, arrival=arrival)
+        if tracer.enabled: tracer.record(EV_LINES, tic, time.perf_counter_ns(), num_rows) # 300 microseconds
 
+    @pyqtSlot()
+    def on_actionPacketLayout(self):
+        """
+        User describes the fields of binary packets and which fields are plotted
+        """
+        text, ok = QInputDialog.getText(self.ui, "Packet Layout",
+                                        "struct format or name:type fields; channels=...; checksum=sum8|xor8|crc8|crc16\n"
+                                        "e.g. <hhhh  or  ax:i2 ay:i2 t:f4 crc:u1; channels=ax,ay; checksum=crc8\n"
+                                        "empty for int16 samples",
+                                        text=str(self.packetLayout) if self.packetLayout is not None else "")
+        if not ok:
+            return
+        if not text.strip():
+            self.packetLayout = None
+            self.ui.statusBar().showMessage('Packets are int16 samples.', 2000)
+            return
         try:
-            # conversion to numpy if all lines have the same length
-            data_array = np.array(data, dtype=float)
-        except:
-            # likely we have a list of lines with different lengths
-            row_len = [len(data_rows) for data_rows in data]
-            max_length = max(row_len)
-            # Pad shorter lines with np.nan
-            padded_data = [data_row + [np.nan]*(max_length - len(data_row)) for data_row in data]
-            data_array = np.array(padded_data, dtype=float)
+            self.packetLayout = parse_layout(text)
+        except ValueError as e:
+            self.ui.statusBar().showMessage('Packet layout error: {}'.format(e), 5000)
+            return
+        for i, line in enumerate(self.data_line):
+            line.opts['name'] = self.packetLayout.channels[i] if i < len(self.packetLayout.channels) else str(i)
+        self.logger.log(logging.INFO, "[{}]: Packet layout {}".format(int(QThread.currentThreadId()), self.packetLayout))
+        self.ui.statusBar().showMessage('Packet layout {} bytes, {} channels.'.format(
+            self.packetLayout.itemsize, len(self.packetLayout.channels)), 2000)
+
+    @pyqtSlot()
+    def on_actionRawSamples(self):
+        """
+        User selects sample type and number of channels of data without line termination
+        """
+        types = list(SAMPLE_TYPES)
+        current = [name for name, code in SAMPLE_TYPES.items() if np.dtype(code) == self.sampleStream.dtype]
+        name, ok = QInputDialog.getItem(self.ui, "Raw Samples", "Sample type", types,
+                                        types.index(current[0]) if current else 0, False)
+        if not ok:
+            return
+        channels, ok = QInputDialog.getInt(self.ui, "Raw Samples", "Interleaved channels", self.sampleStream.channels, 1, 64)
+        if not ok:
+            return
+        self.sampleStream = SampleStream(SAMPLE_TYPES[name], channels)
+        self.logger.log(logging.INFO, "[{}]: Raw samples {} x {}".format(int(QThread.currentThreadId()), channels, name))
+        self.ui.statusBar().showMessage('Raw samples {} channels {}.'.format(channels, name), 2000)
+
+    @pyqtSlot()
+    def on_actionSequenceColumn(self):
+        """
+        User selects the column with a sequence number, gaps are counted and interrupt the plot
+        """
+        column, ok = QInputDialog.getInt(self.ui, "Sequence Column",
+                                         "Column with a number incremented for every line or packet, 0 for none",
+                                         self.sequenceColumn + 1, 0, 64)
+        if not ok:
+            return
+        modulo = 0
+        if column > 0:
+            modulo, ok = QInputDialog.getInt(self.ui, "Sequence Column",
+                                             "Counter wraps around at, e.g. 65536 for uint16, 0 for no wrap around",
+                                             self.sequence.modulo, 0, 2147483647)
+            if not ok:
+                return
+        self.sequenceColumn = column - 1
+        self.sequence = SequenceCounter(modulo)
+        self.logger.log(logging.INFO, "[{}]: Sequence column {} modulo {}".format(int(QThread.currentThreadId()), column, modulo))
+        self.ui.statusBar().showMessage('Sequence column {}.'.format(column) if column > 0 else 'No sequence column.', 2000)
+
+    @pyqtSlot()
+    def on_actionTimeColumn(self):
+        """
+        User selects a column with device timestamps as horizontal axis
+        """
+        column, ok = QInputDialog.getInt(self.ui, "Time Column",
+                                         "Column with device timestamp, 0 for sample number", self.timeColumn + 1, 0, 64)
+        if not ok:
+            return
+        unit, bits = "us", 32
+        if column > 0:
+            units = list(TIME_UNITS)
+            unit, ok = QInputDialog.getItem(self.ui, "Time Column", "Timestamp unit", units, 0, False)
+            if not ok:
+                return
+            bits, ok = QInputDialog.getInt(self.ui, "Time Column", "Timestamp counter bits, e.g. 32 for uint32, 0 no wrap around", 32, 0, 64)
+            if not ok:
+                return
+        self.timeColumn = column - 1
+        self.deviceClock = DeviceClock(TIME_UNITS[unit], bits)
+        if column > 0:
+            self.chartWidget.setLabel('bottom', 'Time', units='s')
+        else:
+            self.chartWidget.setLabel('bottom', 'Sample', units='')
+        self.logger.log(logging.INFO, "[{}]: Time column {} in {} with {} bits".format(int(QThread.currentThreadId()), column, unit, bits))
+        self.ui.statusBar().showMessage('Time column {}.'.format(column) if column > 0 else 'Horizontal axis is sample number.', 2000)
 
+    @pyqtSlot(object, object)
+    def on_sessionDataReceived(self, x, data_array):
+        """
+        Rows of a multi port session, x is time [s], one column per port
+        """
+        tic = time.perf_counter_ns()
+        num_rows = self.pushData(data_array, x)
+        if tracer.enabled: tracer.record(EV_LINES, tic, time.perf_counter_ns(), num_rows)
+
+    def startSession(self, names: list):
+        """
+        Plot multi port session, each port is one trace
+        """
+        self.sessionRunning = True
+        self.buffer.clear()
+        for i, line in enumerate(self.data_line):
+            line.opts['name'] = names[i] if i < len(names) else str(i)
+        self.chartWidget.setLabel('bottom', 'Time', units='s')
+        self.ChartTimer.start()
+        self.ui.pushButton_ChartStartStop.setEnabled(False)
+
+    def stopSession(self):
+        self.ChartTimer.stop()
+        self.sessionRunning = False
+        for i, line in enumerate(self.data_line):
+            line.opts['name'] = str(i)
+        if self.timeColumn < 0:
+            self.chartWidget.setLabel('bottom', 'Sample', units='')
+        self.ui.pushButton_ChartStartStop.setEnabled(True)
+
+    @pyqtSlot(bytes, float)
+    def on_newBytesReceived(self, byte_array: bytes, arrival: float):
+        """
+        Convert received bytes into interleaved samples and add them to the circular buffer
+        """
+        tic = time.perf_counter_ns()
+        data_array = self.sampleStream.decode(byte_array)
+        toc = time.perf_counter_ns()
+        STAGE_PARSE.queue = self.rxQueues["text"].get()
+        STAGE_PARSE.add(lines=data_array.shape[0], samples=data_array.size, nbytes=len(byte_array), ns=toc-tic)
+        num_rows = self.pushData(data_array, arrival=arrival)
+        if tracer.enabled: tracer.record(EV_BYTES, tic, time.perf_counter_ns(), num_rows)
+
+    @pyqtSlot(list, float)
+    def on_newPacketsReceived(self, packets: list, arrival: float):
+        """
+        Convert received binary packets and add data to the circular buffer
+        """
+        tic = time.perf_counter_ns()
+        if self.packetLayout is None:
+            data_array, num_errors = packets_to_array(packets)
+        else:
+            data_array, num_errors = self.packetLayout.decode(packets) # size and checksum errors
+        toc = time.perf_counter_ns()
+        STAGE_PARSE.queue = self.rxQueues["packets"].get()
+        STAGE_PARSE.add(lines=len(packets), samples=data_array.size, ns=toc-tic, errors=num_errors)
+        num_rows = self.pushData(data_array, arrival=arrival)
+        if tracer.enabled: tracer.record(EV_PACKETS, tic, time.perf_counter_ns(), num_rows)
+
+    def pushData(self, data_array, x=None, arrival=None):
+        """
+        Add sample numbers, pad or cut to MAX_COLUMNS and push rows to the circular buffer
+        x replaces sample numbers and time column, e.g. time of a session
+        arrival [s] perf_counter when the rows were read, fits the device clock
+        Returns number of rows
+        """
+        toc = time.perf_counter_ns()
+        breaks, columns = None, []                                                         # gaps, columns not plotted
+        session = x is not None                                                            # session removed time and sequence columns
+        if not session and 0 <= self.timeColumn < data_array.shape[1]:
+            x = self.deviceClock.update(data_array[:, self.timeColumn], time.perf_counter() if arrival is None else arrival) - self.timeOrigin
+            columns.append(self.timeColumn)
+        if not session and 0 <= self.sequenceColumn < data_array.shape[1]:
+            lost = self.sequence.numLost
+            breaks = self.sequence.check(data_array[:, self.sequenceColumn])
+            columns.append(self.sequenceColumn)
+            tic = time.perf_counter_ns()
+            STAGE_SEQUENCE.add(lines=data_array.shape[0], errors=self.sequence.numLost - lost, ns=tic-toc)
+            toc = tic
+        if columns:
+            data_array = np.delete(data_array, columns, axis=1)
         num_rows, num_cols = data_array.shape
-        sample_numbers = np.arange(self.sample_number, self.sample_number + num_rows)
-        sample_numbers = sample_numbers.reshape(-1, 1)
+        if num_rows == 0:
+            return 0
+        if x is None:
+            x = np.arange(self.sample_number, self.sample_number + num_rows)
         self.sample_number += num_rows
+        x = x.reshape(-1, 1)
         right_pad = MAX_COLUMNS - num_cols
         if right_pad > 0:
-            new_array = np.hstack([sample_numbers, data_array, np.full((num_rows, right_pad), np.nan)])
+            new_array = np.hstack([x, data_array, np.full((num_rows, right_pad), np.nan)])
         else:
-            new_array = np.hstack([sample_numbers, data_array[:, :MAX_COLUMNS]])
+            new_array = np.hstack([x, data_array[:, :MAX_COLUMNS]])
+        if breaks is not None and breaks.size > 0:
+            # rows of nan interrupt the plotted lines, they are placed at x of the following row
+            new_array = insert_breaks(new_array, breaks)
+            rows = breaks + np.arange(breaks.size)
+            new_array[rows, 0] = new_array[rows + 1, 0]
 
         self.buffer.push(new_array)
         
-        toc = time.perf_counter()
-        self.logger.log(logging.DEBUG, "[{}]: {} Data points received: took {} ms".format(int(QThread.currentThreadId()), num_rows, 1000*(toc-tic)))
-        # 300 microseconds
+        STAGE_PUSH.add(lines=num_rows, samples=num_rows*min(num_cols, MAX_COLUMNS), ns=time.perf_counter_ns()-toc)
+        return num_rows
         
     @pyqtSlot()
     def on_pushButton_StartStop(self):
@@ -295,16 +517,16 @@ class QChartUI(QObject):
         Start timer
         """
         if self.ui.pushButton_ChartStartStop.text() == "Start":
-            if self.serialUI.textLineTerminator == '':
-                self.logger.log(logging.ERROR, "[{}]: Plotting of of raw data not yet supported".format(int(QThread.currentThreadId())))
-                return
             # start plotting
-            try:
-                self.serialWorker.linesReceived.disconnect(self.serialUI.on_SerialReceivedLines) # turn off text display
-                self.logger.log(logging.WARNING, "[{}]: Disconnected lines-received signal from serial text display.".format(int(QThread.currentThreadId())))
-            except:
-                pass
-            self.serialWorker.linesReceived.connect(self.on_newLinesReceived) # enable plot data feed
+            if self.serialUI.displayConnected:
+                self.serialUI.disconnectDisplay() # turn off text display
+                self.logger.log(logging.WARNING, "[{}]: Disconnected serial text display.".format(int(QThread.currentThreadId())))
+            self.sampleStream.reset() # alignment starts with first received byte
+            self.sequence.reset() # first number after start is not a gap
+            self.deviceClock.reset() # device might have restarted
+            self.rxQueues["text"]    = self.serialWorker.connectReceiver("text",    self.on_newBytesReceived) # raw samples without line termination
+            self.rxQueues["lines"]   = self.serialWorker.connectReceiver("lines",   self.on_newLinesReceived) # enable plot data feed
+            self.rxQueues["packets"] = self.serialWorker.connectReceiver("packets", self.on_newPacketsReceived) # framed binary data feed
             self.ChartTimer.start()
             if self.serialUI.receiverIsRunning == False:
                 self.serialUI.startReceiverRequest.emit()
@@ -318,10 +540,13 @@ class QChartUI(QObject):
                 self.serialUI.stopReceiverRequest.emit()
                 self.serialUI.stopThroughputRequest.emit()
                 self.ui.pushButton_ChartStartStop.setText("Start")
-            try:
-                self.serialWorker.linesReceived.disconnect(self.on_newLinesReceived)
-            except:
-                self.logger.log(logging.WARNING, "[{}]: lines-received signal was not connected the chart".format(int(QThread.currentThreadId())))
+            self.serialWorker.disconnectReceiver("lines",   self.on_newLinesReceived,   self.rxQueues["lines"])
+            self.serialWorker.disconnectReceiver("packets", self.on_newPacketsReceived, self.rxQueues["packets"])
+            self.serialWorker.disconnectReceiver("text",    self.on_newBytesReceived,   self.rxQueues["text"])
+            if self.sequenceColumn >= 0:
+                self.logger.log(logging.INFO, "[{}]: Sequence {}".format(int(QThread.currentThreadId()), self.sequence.summary()))
+            if self.timeColumn >= 0:
+                self.logger.log(logging.INFO, "[{}]: Device clock {}".format(int(QThread.currentThreadId()), self.deviceClock.summary()))
             self.logger.log(logging.INFO, "[{}]: Stopped plotting".format(int(QThread.currentThreadId())))
             self.ui.statusBar().showMessage('Chart update stopped.', 2000)            
 
@@ -0,0 +1,176 @@
+############################################################################################
+# QT Monitor Helper
+############################################################################################
+# October 2026: line monitor, text display that paints visible lines only
+# ------------------------------------------------------------------------------------------
+# Urs Utzinger
+# University of Arizona 2026
+############################################################################################
+############################################################################################
+# QLineMonitor shows the lines of a LineRing (Monitor_helper) in a scroll area, runs in main
+# thread. It replaces the text display when long recordings are monitored.
+#
+# A QPlainTextEdit keeps the received text in a QTextDocument, each insert updates the
+# layout of the document and trimming it removes text from the document. A QListView over
+# a list model was tried as well, it lays out all rows when rows are added and repaints take
+# seconds with a million rows. QLineMonitor has one row per line with the height of the
+# font, the scroll bar counts rows and a repaint draws the rows in the window:
+#   adding lines          ring extend, scroll bar range, repaint is scheduled
+#   repaint               rows(first, first + visible rows), independent of retained lines
+#
+# Following the newest line continues while the scroll bar is at the bottom. When scrolled
+# up, the scroll bar moves up by the lines dropped from the ring and the same lines remain in
+# view. Rows are selected with the mouse (shift click extends) and copied with Ctrl+C.
+############################################################################################
+
+import logging
+
+from PyQt5.QtCore    import Qt, QThread
+from PyQt5.QtGui     import QPainter, QFontMetrics, QKeySequence, QPalette
+from PyQt5.QtWidgets import QAbstractScrollArea, QApplication
+
+from helpers.Monitor_helper import LineRing, MONITOR_LINES
+
+# Constants
+########################################################################################
+TEXT_MARGIN = 4                                                                            # [pixels] left of text
+
+class QLineMonitor(QAbstractScrollArea):
+    """
+    Scrollable view of the newest lines, painting cost depends on the window size only
+
+    appendLines(list)                 add lines, follows the newest line if scrolled to the bottom
+    clear()                           remove all lines
+    text()                            retained lines, e.g. to save them
+    """
+
+    def __init__(self, parent=None, capacity: int = MONITOR_LINES):
+        super(QLineMonitor, self).__init__(parent)
+
+        self.logger = logging.getLogger("QMonUI")
+
+        self.ring      = LineRing(capacity)
+        self.anchor    = -1                                                                # selected lines, absolute line numbers
+        self.cursor    = -1
+        self.textWidth = 0                                                                 # [pixels] widest line painted
+        self.setVerticalScrollBarPolicy(Qt.ScrollBarAlwaysOn)
+        self.viewport().setCursor(Qt.IBeamCursor)
+        self.setFocusPolicy(Qt.StrongFocus)
+        self.updateMetrics()
+
+        self.logger.log(logging.INFO, "[{}]: Initialized, {} lines retained.".format(int(QThread.currentThreadId()), self.ring.capacity))
+
+    def updateMetrics(self):
+        metrics = QFontMetrics(self.font())
+        self.lineHeight = max(metrics.lineSpacing(), 1)
+        self.ascent     = metrics.ascent()
+        self.charWidth  = max(metrics.averageCharWidth(), 1)
+
+    def visibleRows(self) -> int:
+        return max(self.viewport().height()//self.lineHeight, 1)
+
+    def updateScrollBars(self):
+        """ scroll bar counts rows, range changes as lines arrive """
+        vbar = self.verticalScrollBar()
+        vbar.setRange(0, max(len(self.ring) - self.visibleRows(), 0))
+        vbar.setPageStep(self.visibleRows())
+        hbar = self.horizontalScrollBar()
+        hbar.setRange(0, max(self.textWidth + 2*TEXT_MARGIN - self.viewport().width(), 0))
+        hbar.setPageStep(self.viewport().width())
+        hbar.setSingleStep(self.charWidth)
+
+    def appendLines(self, lines: list):
+        vbar = self.verticalScrollBar()
+        following = vbar.value() >= vbar.maximum()
+        dropped = self.ring.extend(lines)
+        self.updateScrollBars()
+        if following:
+            vbar.setValue(vbar.maximum())
+        elif dropped:
+            vbar.setValue(vbar.value() - dropped)                                          # same lines remain in view
+        self.viewport().update()
+
+    def clear(self):
+        self.ring.clear()
+        self.anchor, self.cursor, self.textWidth = -1, -1, 0
+        self.updateScrollBars()
+        self.viewport().update()
+
+    def text(self) -> str:
+        return self.ring.text()
+
+    def selectedText(self) -> str:
+        if self.anchor < 0:
+            return ""
+        first = min(self.anchor, self.cursor) - self.ring.first
+        last  = max(self.anchor, self.cursor) - self.ring.first + 1
+        return "\n".join(self.ring.rows(first, last))
+
+    def lineAt(self, y: int) -> int:
+        """ absolute line number at viewport position """
+        row = self.verticalScrollBar().value() + max(y, 0)//self.lineHeight
+        return self.ring.first + min(row, max(len(self.ring) - 1, 0))
+
+    # Qt events
+    ####################################################################################
+
+    def paintEvent(self, event):
+        painter = QPainter(self.viewport())
+        palette = self.palette()
+        painter.fillRect(event.rect(), palette.color(QPalette.Base))
+        first  = self.verticalScrollBar().value()
+        x      = TEXT_MARGIN - self.horizontalScrollBar().value()
+        top    = event.rect().top()//self.lineHeight                                      # rows that need repainting
+        bottom = event.rect().bottom()//self.lineHeight + 1
+        selFirst = min(self.anchor, self.cursor) - self.ring.first
+        selLast  = max(self.anchor, self.cursor) - self.ring.first
+        metrics  = painter.fontMetrics()
+        widest   = self.textWidth
+        for i, line in enumerate(self.ring.rows(first + top, first + bottom), start=top):
+            y = i*self.lineHeight
+            if self.anchor >= 0 and selFirst <= first + i <= selLast:
+                painter.fillRect(0, y, self.viewport().width(), self.lineHeight, palette.color(QPalette.Highlight))
+                painter.setPen(palette.color(QPalette.HighlightedText))
+            else:
+                painter.setPen(palette.color(QPalette.Text))
+            painter.drawText(x, y + self.ascent, line)
+            if len(line)*self.charWidth > widest:
+                widest = max(widest, metrics.horizontalAdvance(line))
+        painter.end()
+        if widest > self.textWidth:
+            self.textWidth = widest
+            self.updateScrollBars()
+
+    def resizeEvent(self, event):
+        super(QLineMonitor, self).resizeEvent(event)
+        vbar = self.verticalScrollBar()
+        following = vbar.value() >= vbar.maximum()
+        self.updateScrollBars()
+        if following:
+            vbar.setValue(vbar.maximum())
+
+    def changeEvent(self, event):
+        super(QLineMonitor, self).changeEvent(event)
+        self.updateMetrics()
+
+    def mousePressEvent(self, event):
+        if event.button() == Qt.LeftButton and len(self.ring):
+            line = self.lineAt(event.pos().y())
+            if not (event.modifiers() & Qt.ShiftModifier) or self.anchor < self.ring.first:
+                self.anchor = line
+            self.cursor = line
+            self.viewport().update()
+
+    def mouseMoveEvent(self, event):
+        if event.buttons() & Qt.LeftButton and self.anchor >= 0:
+            self.cursor = self.lineAt(event.pos().y())
+            self.viewport().update()
+
+    def keyPressEvent(self, event):
+        if event.matches(QKeySequence.Copy):
+            QApplication.clipboard().setText(self.selectedText())
+        elif event.matches(QKeySequence.SelectAll):
+            self.anchor, self.cursor = self.ring.first, self.ring.first + len(self.ring) - 1
+            self.viewport().update()
+        else:
+            super(QLineMonitor, self).keyPressEvent(event)
@@ -0,0 +1,218 @@
+############################################################################################
+# QT Profiler Helper
+############################################################################################
+# October 2026: pipeline metrics panel
+# October 2026: main thread event loop lag monitor
+# ------------------------------------------------------------------------------------------
+# Urs Utzinger
+# University of Arizona 2026
+############################################################################################
+############################################################################################
+# This code has 2 sections
+# QMetricsUI: dockable table with rates and latencies of each pipeline stage, runs in main thread.
+# QLagMonitor: measures how late the main thread event loop services a timer, a watchdog
+#   thread records a python stack of the main thread when the event loop stalls.
+#
+# The metrics themselves are collected in Profiler_helper without QT dependencies.
+############################################################################################
+
+import logging, time, threading, sys, traceback
+
+from PyQt5.QtCore    import QObject, QTimer, QThread, pyqtSlot, Qt, QStandardPaths
+from PyQt5.QtWidgets import QDockWidget, QTableWidget, QTableWidgetItem, QHeaderView, QFileDialog, QLabel
+
+from helpers.Profiler_helper import metrics, MetricsWriter, METRICS_COLUMNS, LatencyHistogram
+
+# Constants
+########################################################################################
+METRICS_INTERVAL = 1000                                                                    # [ms] panel update and file dump interval
+LAG_INTERVAL     = 50                                                                      # [ms] event loop heartbeat
+STALL_THRESHOLD  = 0.2                                                                     # [s] timer serviced this much later than due is a stall
+STALL_ELAPSED    = LAG_INTERVAL/1000. + STALL_THRESHOLD                                    # [s] time since last heartbeat at which the lag exceeds STALL_THRESHOLD
+
+############################################################################################
+# QMetricsUI interaction with Graphical User Interface
+############################################################################################
+
+class QMetricsUI(QObject):
+    """
+    Pipeline Metrics Interface for QT
+
+    Shows for each stage (read, frame, parse, push, plot, text ...)
+    events/s, lines/s, samples/s, bytes/s, latency percentiles, queue depth and errors.
+    The stage with the highest p99 latency or growing queue is the one that saturates first.
+
+    Slots (functions available to respond to external signals)
+        on_metricsTimer()                update panel and metrics file
+        on_actionMetricsLog(bool)        start/stop writing metrics to file
+    """
+
+    def __init__(self, parent=None, ui=None):
+        super(QMetricsUI, self).__init__(parent)
+
+        self.logger = logging.getLogger("QMetrUI")
+
+        if ui is None:
+            self.logger.log(logging.ERROR, "[{}]: Need to have access to User Interface".format(int(QThread.currentThreadId())))
+        self.ui = ui
+
+        self.writer = None                                                                 # metrics file
+
+        # Dockable table, one row per stage
+        self.columns = METRICS_COLUMNS[1:]                                                 # time is not shown
+        self.table = QTableWidget(0, len(self.columns))
+        self.table.setHorizontalHeaderLabels(self.columns)
+        self.table.verticalHeader().setVisible(False)
+        self.table.horizontalHeader().setSectionResizeMode(QHeaderView.Stretch)
+        self.table.setEditTriggers(QTableWidget.NoEditTriggers)
+        self.dock = QDockWidget("Pipeline Metrics", self.ui)
+        self.dock.setObjectName("dockWidget_Metrics")
+        self.dock.setWidget(self.table)
+        self.ui.addDockWidget(Qt.BottomDockWidgetArea, self.dock)
+        self.dock.hide()
+
+        # Periodic update, also runs when the panel is hidden so that the file dump continues
+        self.metricsTimer = QTimer(self)
+        self.metricsTimer.timeout.connect(self.on_metricsTimer)
+        self.metricsTimer.start(METRICS_INTERVAL)
+
+        self.logger.log(logging.INFO, "[{}]: Initialized.".format(int(QThread.currentThreadId())))
+
+    @pyqtSlot()
+    def on_metricsTimer(self):
+        """ obtain snapshot of metrics and show it """
+        snapshot = metrics.snapshot()
+        if self.writer is not None:
+            self.writer.write(snapshot)
+        if not self.dock.isVisible():
+            return
+        self.table.setRowCount(len(snapshot))
+        for row, stage in enumerate(snapshot):
+            for col, key in enumerate(self.columns):
+                value = stage[key]
+                text = value if isinstance(value, str) else "{:.4g}".format(value)
+                item = self.table.item(row, col)
+                if item is None:
+                    self.table.setItem(row, col, QTableWidgetItem(text))
+                else:
+                    item.setText(text)
+
+    @pyqtSlot(bool)
+    def on_actionMetricsLog(self, checked: bool):
+        """ start or stop appending metrics to a .csv or .json file """
+        if checked:
+            stdFileName = QStandardPaths.writableLocation(QStandardPaths.DocumentsLocation) + "/metrics.csv"
+            fname, _ = QFileDialog.getSaveFileName(self.ui, 'Log Metrics to', stdFileName, "CSV files (*.csv);;JSON lines (*.json)")
+            if fname:
+                self.writer = MetricsWriter(fname)
+                self.ui.statusBar().showMessage('Logging metrics.', 2000)
+            else:
+                self.sender().setChecked(False)
+        elif self.writer is not None:
+            self.writer.close()
+            self.writer = None
+            self.ui.statusBar().showMessage('Stopped logging metrics.', 2000)
+
+############################################################################################
+# QLagMonitor main thread responsiveness
+############################################################################################
+
+class QLagMonitor(QObject):
+    """
+    Event Loop Lag Monitor for QT
+
+    A precise timer in the main thread fires every LAG_INTERVAL. The difference between
+    when it fired and when it was due is the event loop lag and is recorded in the
+    "gui lag" metrics stage. Stalls longer than STALL_THRESHOLD are counted as errors.
+
+    A watchdog thread checks the time of the last timer event. If the main thread did not
+    service its event loop for STALL_ELAPSED, i.e. the next heartbeat will be a stall, it records
+    the python stack of the main thread, which shows the function that is blocking (e.g. text trim,
+    file save, large text insert).
+
+    The lag statistics are shown in a label in the status bar, the stack of the last stall is
+    its tool tip and is logged as warning.
+
+    Slots (functions available to respond to external signals)
+        on_lagTimer()                    heartbeat of main thread event loop
+        on_statusTimer()                 update status bar label
+    """
+
+    def __init__(self, parent=None, ui=None):
+        super(QLagMonitor, self).__init__(parent)
+
+        self.logger = logging.getLogger("QLagMon")
+
+        if ui is None:
+            self.logger.log(logging.ERROR, "[{}]: Need to have access to User Interface".format(int(QThread.currentThreadId())))
+        self.ui = ui
+
+        self.stage         = metrics.stage("gui lag")
+        self.latency       = LatencyHistogram()                                            # lag since last status update
+        self.numStalls     = 0
+        self.lastStack     = ""                                                            # main thread stack of last stall
+        self._mainIdent    = threading.get_ident()
+        self._heartbeat    = time.perf_counter()
+        self._stackTaken   = False                                                         # only one stack sample per stall
+        self._stop         = threading.Event()
+
+        # Status bar label, permanent widgets are not replaced by status messages
+        self.label = QLabel("")
+        self.ui.statusBar().addPermanentWidget(self.label)
+
+        # Heartbeat
+        self.lagTimer = QTimer(self)
+        self.lagTimer.setTimerType(Qt.PreciseTimer)
+        self.lagTimer.timeout.connect(self.on_lagTimer)
+        self.lagTimer.start(LAG_INTERVAL)
+
+        self.statusTimer = QTimer(self)
+        self.statusTimer.timeout.connect(self.on_statusTimer)
+        self.statusTimer.start(METRICS_INTERVAL)
+
+        # Watchdog
+        self.watchdog = threading.Thread(target=self._watch, name="LagWatchdog", daemon=True)
+        self.watchdog.start()
+
+        self.logger.log(logging.INFO, "[{}]: Initialized.".format(int(QThread.currentThreadId())))
+
+    @pyqtSlot()
+    def on_lagTimer(self):
+        """ measure how late this timer event was serviced """
+        now = time.perf_counter()
+        lag = now - self._heartbeat - LAG_INTERVAL/1000.
+        self._heartbeat = now
+        self._stackTaken = False
+        if lag < 0: lag = 0.
+        self.stage.add(ns=int(lag*1e9), errors=1 if lag > STALL_THRESHOLD else 0)
+        self.latency.record(int(lag*1e9))
+        if lag > STALL_THRESHOLD:
+            self.numStalls += 1
+            self.label.setToolTip(self.lastStack)                                          # stack sampled by watchdog during this stall
+            self.lastStack = ""                                                            # next stall without sample shows no stale stack
+            self.logger.log(logging.WARNING, "[{}]: Event loop stalled for {:.0f} ms.".format(int(QThread.currentThreadId()), 1000*lag))
+
+    @pyqtSlot()
+    def on_statusTimer(self):
+        """ show lag statistics in status bar """
+        self.label.setText("Lag p99 {:.0f} max {:.0f} ms, Stalls {}".format(
+            self.latency.percentile(99)/1e6, self.latency.max/1e6, self.numStalls))
+        self.latency.reset()
+
+    def _watch(self):
+        """ watchdog thread, sample main thread stack when event loop stalls """
+        while not self._stop.wait(LAG_INTERVAL/2000.):
+            if (not self._stackTaken) and (time.perf_counter() - self._heartbeat > STALL_ELAPSED):
+                frame = sys._current_frames().get(self._mainIdent)
+                if frame is None:
+                    continue
+                self._stackTaken = True
+                self.lastStack = "".join(traceback.format_stack(frame))
+                del frame
+                self.logger.log(logging.WARNING, "[{}]: Main thread stalled in:\n{}".format(threading.get_ident(), self.lastStack))
+
+    def stop(self):
+        """ stop watchdog thread """
+        self._stop.set()
+        self.lagTimer.stop()
+        self.statusTimer.stop()
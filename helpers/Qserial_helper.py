@@ -3,92 +3,48 @@
 ############################################################################################
 # July 2022: initial work
 # December 2023: implemented line reading
+# October 2026: serial worker moved to Qserialport_helper
+# October 2026: reconnect adapters that vanish and reappear
+# October 2026: low latency port profile
+# October 2026: arbitrary baud rates, achieved rate is read back
+# October 2026: flow control, receiver backpressure
 # ------------------------------------------------------------------------------------------
 # Urs Utzinger
 # University of Arizona 2022, 2023
 ############################################################################################
 ############################################################################################
-# This code has 3 sections
 # QSerialUI: Interface to GUI, runs in main thread.
-# QSerial: Serial functions running in separate thread, communication with signals and slots.
-# PSerial: Low level interaction with serial ports, called from QSerial.
+# The serial worker QSerial and the port wrapper PSerial are in Qserialport_helper, they
+# run in a separate thread and communicate with QSerialUI through signals and slots.
 ############################################################################################
-############################################################################################
-# Helpful readings:
-# ------------------------------------------------------------------------------------------
-# Signals and Slots and Threads
-#      https://realpython.com/python-pyqt-qthread/
-#      https://www.tutorialspoint.com/pyqt/pyqt_signals_and_slots.htm
-#      http://blog.debao.me/2013/08/how-to-use-qthread-in-the-right-way-part-1/
-#   Examples with Worker Tread
-#      https://stackoverflow.com/questions/41026032/pyqt5-how-to-send-a-signal-to-a-worker-thread
-#      https://stackoverflow.com/questions/68163578/stopping-an-infinite-loop-in-a-worker-thread-in-pyqt5-the-simplest-way
-#      https://stackoverflow.com/questions/61625043/threading-with-qrunnable-proper-manner-of-sending-bi-directional-callbacks
-#      https://stackoverflow.com/questions/52973090/pyqt5-signal-communication-between-worker-thread-and-main-window-is-not-working
-#      https://stackoverflow.com/questions/61625043/threading-with-qrunnable-proper-manner-of-sending-bi-directional-callbacks
-# Timer, infinite loop
-#      https://stackoverflow.com/questions/55651718/how-to-use-a-qtimer-in-a-separate-qthread
-#      https://stackoverflow.com/questions/23607294/qtimer-in-worker-thread
-#      https://stackoverflow.com/questions/60649644/how-to-properly-stop-qtimer-from-another-thread
-#      https://stackoverflow.com/questions/47661854/use-qtimer-to-run-functions-in-an-infinte-loop
-#      https://stackoverflow.com/questions/10492480/starting-qtimer-in-a-qthread
-#      https://programmer.ink/think/no-event-loop-or-use-of-qtimer-in-non-gui-qt-threads.html
-#      https://www.pythonfixing.com/2022/03/fixed-how-to-use-qtimer-inside-qthread.html
-# Serial
-#   Examples using pySerial
-#      https://programmer.group/python-uses-pyqt5-to-write-a-simple-serial-assistant.html
-#      https://github.com/mcagriaksoy/Serial-Communication-GUI-Program
-#      https://hl4rny.tistory.com/433
-#      https://iosoft.blog/pyqt-serial-terminal-code
-#   Examples using QSerialPort
-#      https://stackoverflow.com/questions/55070483/connect-to-serial-from-a-pyqt-gui
-#      https://ymt-lab.com/en/post/2021/pyqt5-serial-monitor
-#
-############################################################################################
-
-from serial import Serial as sp
-from serial import EIGHTBITS, PARITY_NONE, STOPBITS_ONE
-from serial.tools import list_ports 
 
 import time, logging
-from math import ceil
-from enum import Enum
-
-try:
-    import debugpy
-    DEBUGPY_ENABLED = True
-except ImportError:
-    DEBUGPY_ENABLED = False
-    
+
 from PyQt5.QtCore    import QObject, QTimer, QThread, pyqtSignal, pyqtSlot, QStandardPaths
 from PyQt5.QtCore    import Qt
-from PyQt5.QtGui     import QTextCursor
-from PyQt5.QtWidgets import QFileDialog
+from PyQt5.QtGui     import QTextCursor, QIntValidator
+from PyQt5.QtWidgets import QFileDialog, QInputDialog, QComboBox
+
+# Tracing of receiver pipeline
+from helpers.Profiler_helper import tracer, metrics, QueueCounter
+from helpers.Xmodem_helper   import PROTOCOLS as XMODEM_PROTOCOLS
+from helpers.Qmonitor_helper import QLineMonitor
+from helpers.Codec_helper    import FRAMINGS, LINE_CHECKSUMS, TextDecoder
+from helpers.Qserialport_helper import DEFAULT_BAUDRATE, TX_CHUNK_SIZE, LOW_LATENCY_VMIN, FLOW_CONTROLS
 
 # Constants
 ########################################################################################
-DEFAULT_BAUDRATE          = 115200      # default baud rate for serial port
-MAX_TEXTBROWSER_LENGTH    = 1024*1024   # display window character length is trimmed to this length
+MAX_TEXTBROWSER_LINES     = 20000       # display window keeps this many lines, oldest lines are removed as new ones arrive
                                         # lesser value results in better performance
-MAX_LINE_LENGTH           = 1024        # number of characters after which an end of line characters is expected
-RECEIVER_FINISHCOUNT      = 10          # [times] If we encountered a timeout 10 times we slow down serial polling
-NUM_LINES_COLLATE         = 10          # [lines] estimated number of lines to collate before emitting signal
-                                        #   this results in collating about NUM_LINES_COLLATE * 32 bytes in a list of lines
-                                        #   plotting and processing large amounts of data is more efficient for display and plotting 
-MAX_RECEIVER_INTERVAL     = 100         # [ms]
-MIN_RECEIVER_INTERVAL     = 5           # [ms]
-
-class SerialReceiverState(Enum):
-    """ 
-    When data is expected on the serial input we use a QT timer to read line by line.
-    When no data is expected we are in stopped state
-    When data is expected but has not yet arrived we are in awaiting state
-    When data has arrived and there might be more data arriving we are in receiving state
-    """
-    stopped               =  0
-    awaitingData          =  1
-    receivingData         =  2
-    
+
+# Trace events
+EV_UI_TEXT                = tracer.register("QSerialUI.on_SerialReceivedText")
+EV_UI_LINES               = tracer.register("QSerialUI.on_SerialReceivedLines")
+
+# Pipeline stages
+STAGE_TEXT                = metrics.stage("text")
+STAGE_SEQUENCE            = metrics.stage("sequence")                                     # lines are checked rows, errors are lost rows
+
 ############################################################################################
 # QSerial interaction with Graphical User Interface
 # This section contains routines that can not be moved to a separate thread 
@@ -120,6 +76,22 @@ class QSerialUI(QObject):
         serialStatusRequest              request that QSerial reports current port, baudrate, line termination, encoding, timeout
         finishWorkerRequest              request that QSerial worker is finished
         closePortRequest                 request that QSerial closes current port
+        serialSendFileRequest            request that QSerial transmits a file
+        cancelSendFileRequest            request that QSerial stops transmitting the file
+        changeTxRateRequest              request that QSerial limits transmission to bytes/s or lines/s
+        changeTxChunkSizeRequest         request that QSerial reads and transmits files in chunks of this size
+        startMacroRequest                request that QSerial runs a macro
+        stopMacroRequest                 request that QSerial stops the macro
+        changeTransactionRequest         request that QSerial matches replies with pattern, timeout and window
+        sendTransactionRequest           request that QSerial sends command count times and waits for replies
+        startPeriodicRequest             request that QSerial sends a line every period
+        stopPeriodicRequest              request that QSerial stops sending the line
+        uploadFileRequest                request that QSerial uploads files with XMODEM or YMODEM
+        changeLineChecksumRequest        request that QSerial validates a checksum at the end of each line
+        autobaudRequest                  request that QSerial finds the baud rate of the received data
+        changeReconnectRequest           request that QSerial reopens a port that vanished and reappeared
+        changeLatencyRequest             request that QSerial applies standard or low latency port profile
+        changeFlowControlRequest         request that QSerial uses RTS/CTS, DSR/DTR, XON/XOFF or no flow control
         
     Slots (functions available to respond to external signals)
         on_serialMonitorSend                 transmit text from UI to serial TX line
@@ -135,9 +107,33 @@ class QSerialUI(QObject):
         on_serialStatusReady(str, int, bytes, float) pickup QSerial status on port, baudrate, line termination, timeout
         on_newPortListReady(list, list)      pickup new list of serial ports
         on_newBaudListReady(tuple)           pickup new list of baudrates
-        on_SerialReceivedText(bytes)         pickup text from serial port
-        on_SerialReceivedLines(list)         pickup lines of text from serial port
-        on_throughputReceived(int, int)      pickup throughput data from QSerial
+        on_SerialReceivedText(bytes, float)  pickup text from serial port
+        on_SerialReceivedLines(list, float)  pickup lines of text from serial port
+        on_SerialReceivedPackets(list, float) pickup binary packets from serial port, displayed as hex
+        on_throughputReceived(int, int)      pickup throughput data from QSerial, show rows lost according to sequence numbers
+        on_fileProgressReady(int, int, float) pickup file transfer progress from QSerial
+        on_fileTransferFinished(bool)        file transfer completed or was cancelled
+        on_txQueueReady(int, float)          pickup transmit queue depth and drain time from QSerial
+        on_actionTxRate()                    user selected transmit rate limit
+        on_actionTxChunkSize()               user selected file transfer chunk size
+        on_actionRunMacro()                  user selected macro file to run
+        on_actionStopMacro()                 user stopped macro
+        on_macroStateChanged(bool, str)      macro started or finished with message
+        on_actionTransactions()              user selected command to send as transactions
+        on_transactionsFinished(str)         display transaction statistics
+        on_actionPeriodic()                  user selected line and period to send
+        on_actionStopPeriodic()              user stopped periodic sending
+        on_periodicStatsReady(float, float, float, int) pickup period and jitter from QSerial
+        on_actionUpload()                    user selected protocol and files to upload
+        on_actionLineChecksum()              user selected checksum at end of lines
+        on_actionAutobaud()                  user requested baud rate detection
+        on_autobaudFinished(int, float)      baud rate detection selected rate with score
+        on_actionAutoReconnect(bool)         user enabled or disabled reconnecting lost ports
+        on_portLost(str)                     port vanished, waiting for it to reappear
+        on_portReconnected(str, float)       port reopened after it was lost for some seconds
+        on_actionLatency()                   user selected port profile, read chunk size and VMIN
+        on_actionFlowControl()               user selected flow control
+        on_actionLineMonitor(bool)           user switched between text display and line monitor
     """
     
     # Signals
@@ -148,6 +144,7 @@ class QSerialUI(QObject):
     changePortRequest            = pyqtSignal(str, int)                                    # port and baudrate to change
     changeBaudRequest            = pyqtSignal(int)                                         # request serial baud rate to change
     changeLineTerminationRequest = pyqtSignal(bytes)                                       # request line termination to change
+    changeFramingRequest         = pyqtSignal(str)                                         # request binary framing, "cobs", "slip" or "" for none
     sendTextRequest              = pyqtSignal(bytes)                                       # request to transmit text to TX
     sendLineRequest              = pyqtSignal(bytes)                                   # request to transmit one line of text to TX
     sendLinesRequest             = pyqtSignal(list)                                        # request to transmit lines of text to TX
@@ -160,6 +157,21 @@ class QSerialUI(QObject):
     finishWorkerRequest          = pyqtSignal()                                            # request worker to finish
     closePortRequest             = pyqtSignal()                                            # close the current serial Port
     serialSendFileRequest        = pyqtSignal(str)                                         # request to open file and send over serial port
+    cancelSendFileRequest        = pyqtSignal()                                            # request to stop sending file
+    changeTxRateRequest          = pyqtSignal(float, bool)                                 # request transmit rate limit, bytes/s or lines/s
+    changeTxChunkSizeRequest     = pyqtSignal(int)                                         # request file transfer chunk size [bytes]
+    startMacroRequest            = pyqtSignal(str)                                         # request to run macro text
+    stopMacroRequest             = pyqtSignal()                                            # request to stop macro
+    changeTransactionRequest     = pyqtSignal(str, float, int)                             # reply pattern, timeout [ms], transactions in flight
+    sendTransactionRequest       = pyqtSignal(bytes, int)                                  # command, number of times
+    startPeriodicRequest         = pyqtSignal(bytes, float)                                # line, period [ms]
+    stopPeriodicRequest          = pyqtSignal()                                            # request to stop periodic sending
+    uploadFileRequest            = pyqtSignal(list, str, int)                              # file names, protocol, blocks in flight
+    changeLineChecksumRequest    = pyqtSignal(str)                                         # "xor", "crc8", "crc16" or "" for none
+    autobaudRequest              = pyqtSignal()                                            # find baud rate of received data
+    changeReconnectRequest       = pyqtSignal(bool)                                        # reopen port that vanished and reappeared
+    changeLatencyRequest         = pyqtSignal(bool, int, int)                              # low latency, read chunk [bytes], VMIN
+    changeFlowControlRequest     = pyqtSignal(str)                                         # one of FLOW_CONTROLS
            
     def __init__(self, parent=None, ui=None, worker=None):
 
@@ -178,11 +190,26 @@ class QSerialUI(QObject):
         self.lastNumSent           = 0                                                     # init throughput
         self.rx                    = 0                                                     # init throughput
         self.tx                    = 0                                                     # init throughput 
+        self.txQueueText           = ""                                                    # transmit queue depth and drain time
+        self.transactionReply      = "OK"                                                  # reply prefix or re:regular expression
+        self.transactionTimeout    = 1000.                                                 # [ms]
+        self.transactionWindow     = 1                                                     # transactions in flight
+        self.periodicText          = ""                                                    # period and jitter of periodic sender
+        self.txChunkSize           = TX_CHUNK_SIZE                                         # [bytes] file transfer chunk size
+        self.readChunk             = 0                                                     # [bytes] read at most this per call, 0 for all
+        self.vmin                  = LOW_LATENCY_VMIN                                      # [bytes] low latency wake up
+        self.flowControl           = "none"                                                # one of FLOW_CONTROLS
+        self.lastNumChecked        = 0                                                     # rows with sequence number
+        self.lastNumLost           = 0                                                     # rows missing in sequence
         self.receiverIsRunning     = False                                                 # keep track of worker state
         self.textLineTerminator    = b''                                                   # default line termination
+        self.framing               = ""                                                    # binary framing, none
         self.encoding              = 'utf-8'                                               # default encoding
+        self.textDecoder           = TextDecoder(self.encoding)                            # keeps characters split across received batches
         self.serialTimeout         = 0                                                     # default timeout    
         self.isScrolling           = False                                                 # keep track of text display scrolling
+        self.displayConnected      = False                                                 # text display receives from worker
+        self.displayQueues         = {kind: QueueCounter() for kind in ("lines", "text", "packets")}  # replaced by worker when connecting
         
         self.logger = logging.getLogger("QSerUI_")           
                    
@@ -194,6 +221,11 @@ class QSerialUI(QObject):
             self.logger.log(logging.ERROR, "[{}]: need to have access to serial worker signals".format(int(QThread.currentThreadId())))
         self.serialWorker =  worker
 
+        # Baud rate can be typed, any rate the adapter can generate
+        self.ui.comboBoxDropDown_BaudRates.setEditable(True)
+        self.ui.comboBoxDropDown_BaudRates.setInsertPolicy(QComboBox.NoInsert)
+        self.ui.comboBoxDropDown_BaudRates.setValidator(QIntValidator(1, 100000000, self))
+
         # Text display window on serial text display
         self.textScrollbar = self.ui.plainTextEdit_SerialTextDisplay.verticalScrollBar()
         self.ui.plainTextEdit_SerialTextDisplay.setVerticalScrollBarPolicy(Qt.ScrollBarAlwaysOn)
@@ -208,16 +240,21 @@ class QSerialUI(QObject):
         self.ui.pushButton_SerialSend.setEnabled(False)                
         
         # Limit the amount of text retained in the serial text display window
-        # Execute a text trim function every minute
-        self.textTrimTimer = QTimer(self)
-        self.textTrimTimer.timeout.connect(self.serialTextDisplay_trim)
-        self.textTrimTimer.start(10000)  # Trigger every 60 seconds, this halts the display for a fraction of second, so dont do it often
-      
+        # The document removes its first lines while text is inserted, there is no periodic trim
+        self.ui.plainTextEdit_SerialTextDisplay.setMaximumBlockCount(MAX_TEXTBROWSER_LINES)
+
         # Cursor for text display window
         self.textCursor = self.ui.plainTextEdit_SerialTextDisplay.textCursor()
         self.textCursor.movePosition(QTextCursor.End)
         self.ui.plainTextEdit_SerialTextDisplay.setTextCursor(self.textCursor)        
         self.ui.plainTextEdit_SerialTextDisplay.ensureCursorVisible()
+
+        # Line monitor takes the place of the text display when selected in the Tools menu
+        self.lineMonitor = QLineMonitor(parent=self.ui.plainTextEdit_SerialTextDisplay.parentWidget())
+        self.lineMonitor.setGeometry(self.ui.plainTextEdit_SerialTextDisplay.geometry())
+        self.lineMonitor.setFont(self.ui.plainTextEdit_SerialTextDisplay.font())
+        self.lineMonitor.hide()
+        self.useLineMonitor = False
         self.logger.log(logging.INFO, "[{}]: QSerialUI initialized.".format(int(QThread.currentThreadId())))
 
     # Response Functions to User Interface Signals
@@ -231,13 +268,11 @@ class QSerialUI(QObject):
         text = self.ui.lineEdit_SerialText.text()                                          # obtain text from send input window
         self.serialSendHistory.append(text)                                                # keep history of previously sent commands
         if self.receiverIsRunning == False:
-            self.serialWorker.linesReceived.connect(self.on_SerialReceivedLines) # connect text display to serial receiver signal
-            self.serialWorker.textReceived.connect(self.on_SerialReceivedText) # connect text display to serial receiver signal            
+            self.connectDisplay()                                                          # connect text display to serial receiver signals
             self.startReceiverRequest.emit()
             self.startThroughputRequest.emit()
             self.ui.pushButton_SerialStartStop.setText("Stop")
-        text = text + self.textLineTerminator                                              # add line termination
-        self.sendLineRequest.emit(text.encode(self.encoding))                              # send text to serial TX line
+        self.sendLineRequest.emit(text.encode(self.encoding))                              # send text to serial TX line, worker adds line termination
         self.ui.lineEdit_SerialText.clear()
         self.ui.statusBar().showMessage('Text sent.', 2000)            
 
@@ -245,13 +280,18 @@ class QSerialUI(QObject):
     def on_serialSendFile(self):
         """
         Transmitting file to serial TX line
+        While a file is transmitted the button cancels the transfer
         """
+        if self.ui.pushButton_SerialSend.text() == "Cancel":
+            self.cancelSendFileRequest.emit()
+            self.ui.statusBar().showMessage('File transfer cancel requested.', 2000)
+            return
         stdFileName = QStandardPaths.writableLocation(QStandardPaths.DocumentsLocation) + "/QSerial.txt"
-        fname, _ = QFileDialog.getOpenFileName(self.ui, 'Open', stdFileName, "Text files (*.txt)")
+        fname, _ = QFileDialog.getOpenFileName(self.ui, 'Open', stdFileName, "Text files (*.txt);;All files (*)")
         if fname:
             self.serialSendFileRequest.emit(fname)
-
-        self.ui.statusBar().showMessage('Text file sent.', 2000)            
+            self.ui.pushButton_SerialSend.setText("Cancel")
+            self.ui.statusBar().showMessage('File transfer requested.', 2000)            
 
     @pyqtSlot()
     def on_serialMonitorSendUpArrowPressed(self):
@@ -297,6 +337,8 @@ class QSerialUI(QObject):
         Clearing text display window 
         """
         self.ui.plainTextEdit_SerialTextDisplay.clear()
+        self.lineMonitor.clear()
+        self.textDecoder.reset()
         self.ui.statusBar().showMessage('Text Display Cleared.', 2000)            
 
     @pyqtSlot()
@@ -306,15 +348,13 @@ class QSerialUI(QObject):
         """
         if self.ui.pushButton_SerialStartStop.text() == "Start":
             self.ui.pushButton_SerialStartStop.setText("Stop")
-            self.serialWorker.linesReceived.connect(self.on_SerialReceivedLines) # connect text display to serial receiver signal
-            self.serialWorker.textReceived.connect(self.on_SerialReceivedText) # connect text display to serial receiver signal
+            self.connectDisplay()                                                          # connect text display to serial receiver signals
             self.startReceiverRequest.emit()
             self.startThroughputRequest.emit()
             self.ui.statusBar().showMessage('Text Display Started.', 2000)            
         else:
             self.ui.pushButton_SerialStartStop.setText("Start")
-            self.serialWorker.linesReceived.disconnect(self.on_SerialReceivedLines) # connect text display to serial receiver signal
-            self.serialWorker.textReceived.disconnect(self.on_SerialReceivedText) # connect text display to serial receiver signal
+            self.disconnectDisplay()
             self.stopReceiverRequest.emit()
             self.stopThroughputRequest.emit()
             self.ui.statusBar().showMessage('Text Display Stopped.', 2000)            
@@ -329,7 +369,10 @@ class QSerialUI(QObject):
 
         if fname:
             # check if fname is valid, user can select cancel
-            with open(fname, 'w') as f: f.write(self.ui.plainTextEdit_SerialTextDisplay.toPlainText())
+            if self.useLineMonitor:
+                with open(fname, 'w') as f: f.write(self.lineMonitor.text())
+            else:
+                with open(fname, 'w') as f: f.write(self.ui.plainTextEdit_SerialTextDisplay.toPlainText())
 
         self.ui.statusBar().showMessage('Serial Monitor text saved.', 2000)            
 
@@ -430,22 +473,19 @@ class QSerialUI(QObject):
     @pyqtSlot()
     def on_comboBoxDropDown_BaudRates(self):
         """ 
-        User selected a different baudrate on drop down list 
+        User selected a different baudrate on drop down list or typed one and pressed enter
         """
-        lenBaudRates = len(self.BaudRates)
-        if lenBaudRates > 0:                                                               # if we have recognized serial baudrates
-            index = self.ui.comboBoxDropDown_BaudRates.currentIndex()
-            if index < lenBaudRates:                                                       # last entry is -1
-                baudrate = self.BaudRates[index]
-            else:
-                baudrate = self.defaultBaudRate                                            # use default baud rate                            
-            if (baudrate != self.serialBaudRate):                                          # change baudrate if different from current
-                self.changeBaudRequest.emit(baudrate)
-                self.logger.log(logging.INFO, "[{}]: baudrate {}".format(int(QThread.currentThreadId()), baudrate))
-            else: 
-                self.logger.log(logging.INFO, "[{}]: baudrate remains the same".format(int(QThread.currentThreadId())))
+        try:
+            baudrate = int(self.ui.comboBoxDropDown_BaudRates.currentText())
+        except ValueError:
+            baudrate = -1
+        if baudrate <= 0:                                                                  # last entry is -1
+            baudrate = self.defaultBaudRate                                                # use default baud rate
+        if (baudrate != self.serialBaudRate):                                              # change baudrate if different from current
+            self.changeBaudRequest.emit(baudrate)
+            self.logger.log(logging.INFO, "[{}]: baudrate {}".format(int(QThread.currentThreadId()), baudrate))
         else: 
-            self.logger.log(logging.ERROR, "[{}]: no baudrates available".format(int(QThread.currentThreadId())))
+            self.logger.log(logging.INFO, "[{}]: baudrate remains the same".format(int(QThread.currentThreadId())))
 
         self.ui.statusBar().showMessage('Baudrate change requested.', 2000)
 
@@ -459,9 +499,12 @@ class QSerialUI(QObject):
         elif _tmp == "return (\\r)":            self.textLineTerminator = b'\r'
         elif _tmp == "newline return (\\n\\r)": self.textLineTerminator = b'\n\r'
         elif _tmp == "none":                    self.textLineTerminator = b''
+        elif _tmp in FRAMINGS:                  self.textLineTerminator = b''              # binary packets, delimiter is part of framing
         else:                                   self.textLineTerminator = b'\r\n'
+        self.framing = FRAMINGS.get(_tmp, "")
         self.changeLineTerminationRequest.emit(self.textLineTerminator)
-        self.logger.log(logging.INFO, "[{}]: line termination {}".format(int(QThread.currentThreadId()), repr(self.textLineTerminator)))
+        self.changeFramingRequest.emit(self.framing)
+        self.logger.log(logging.INFO, "[{}]: line termination {}, framing {}".format(int(QThread.currentThreadId()), repr(self.textLineTerminator), self.framing or "none"))
         self.ui.statusBar().showMessage('Line Termination updated', 2000)
 
     # Response to Serial Signals
@@ -497,16 +540,20 @@ class QSerialUI(QObject):
             self.logger.log(logging.DEBUG, "[{}]: port {}.".format(int(QThread.currentThreadId()),self.serialPortNames[index]))
         except:
             self.logger.log(logging.ERROR, "[{}]: port not available.".format(int(QThread.currentThreadId())))
-        # adjust the combobox current item to match the current baudrate
-        try: 
-            index = self.BaudRates.index(self.serialBaudRate)                              # find baud rate in serial baud rate list
+        # adjust the combobox current item to match the current baudrate, rates not in the list are shown as typed text
+        self.ui.comboBoxDropDown_BaudRates.blockSignals(True)
+        index = self.ui.comboBoxDropDown_BaudRates.findText(str(self.serialBaudRate))
+        if index > -1:
             self.ui.comboBoxDropDown_BaudRates.setCurrentIndex(index)                      #  baud combobox
-            self.logger.log(logging.DEBUG, "[{}]: baudrate {}.".format(int(QThread.currentThreadId()),self.BaudRates[index]))
-        except:
-            self.logger.log(logging.ERROR, "[{}]: no baudrate available.".format(int(QThread.currentThreadId())))
+        else:
+            self.ui.comboBoxDropDown_BaudRates.setEditText(str(self.serialBaudRate))
+        self.ui.comboBoxDropDown_BaudRates.blockSignals(False)
+        self.logger.log(logging.DEBUG, "[{}]: baudrate {}.".format(int(QThread.currentThreadId()), self.serialBaudRate))
 
         # adjust the combobox current item to match the current line termination
-        if   eol == b'\n':   _tmp = "newline (\\n)"
+        # framed packets have no line termination, keep the framing selected
+        if   self.framing:   _tmp = self.ui.comboBoxDropDown_LineTermination.currentText()
+        elif eol == b'\n':   _tmp = "newline (\\n)"
         elif eol == b'\r':   _tmp = "return (\\r)"
         elif eol == b'\n\r': _tmp = "newline return (\\n\\r)"
         elif eol == b'\r\n': _tmp = "return newline (\\r\\n)"
@@ -578,48 +625,75 @@ class QSerialUI(QObject):
         self.ui.comboBoxDropDown_BaudRates.blockSignals(False)
         self.ui.statusBar().showMessage('Baudrates updated', 2000)
 
-    @pyqtSlot(bytes)
-    def on_SerialReceivedText(self, byte_array: bytes):
+    def connectDisplay(self):
+        """
+        Text display receives lines, text and packets from the serial worker
+        """
+        if not self.displayConnected:
+            self.displayQueues["lines"]   = self.serialWorker.connectReceiver("lines",   self.on_SerialReceivedLines)
+            self.displayQueues["text"]    = self.serialWorker.connectReceiver("text",    self.on_SerialReceivedText)
+            self.displayQueues["packets"] = self.serialWorker.connectReceiver("packets", self.on_SerialReceivedPackets)
+            self.displayConnected = True
+
+    def disconnectDisplay(self):
+        """
+        Text display no longer receives, batches already emitted are still displayed
+        """
+        if self.displayConnected:
+            self.serialWorker.disconnectReceiver("lines",   self.on_SerialReceivedLines,   self.displayQueues["lines"])
+            self.serialWorker.disconnectReceiver("text",    self.on_SerialReceivedText,    self.displayQueues["text"])
+            self.serialWorker.disconnectReceiver("packets", self.on_SerialReceivedPackets, self.displayQueues["packets"])
+            self.displayConnected = False
+
+    @pyqtSlot(bytes, float)
+    def on_SerialReceivedText(self, byte_array: bytes, arrival: float):
         """ 
         Received text () on serial port 
         Display it in the text display window
         """
-        self.logger.log(logging.DEBUG, "[{}]: text received.".format(int(QThread.currentThreadId())))
-        try:
-            text = byte_array.decode(self.encoding)
-            self.logger.log(logging.DEBUG, "[{}]: {}".format(int(QThread.currentThreadId()),text))
-            # Move cursor to the end of the document and insert text, if scrollbar is at the end, make sure text display scrolls up
-            if self.textScrollbar.value() >= self.textScrollbar.maximum()-20: 
-                self.isScrolling = True
-            else: 
-                self.isScrolling = False
-            self.textCursor.movePosition(QTextCursor.End)
-            self.textCursor.insertText(text+'\n')
-            if self.isScrolling:
-                self.ui.plainTextEdit_SerialTextDisplay.ensureCursorVisible()
-        except:
-            self.logger.log(logging.ERROR, "[{}]: could not decode text in {}.".format(int(QThread.currentThreadId()),repr(byte_array)))
+        tic = time.perf_counter_ns()
+        STAGE_TEXT.queue = self.displayQueues["text"].get()
+        text = self.textDecoder.decode(byte_array)                                         # invalid bytes are replaced
+        if self.useLineMonitor:
+            self.lineMonitor.appendLines(text.split('\n'))
+        else:
+            self.serialTextDisplay_append(text)
+        toc = time.perf_counter_ns()
+        STAGE_TEXT.add(nbytes=len(byte_array), ns=toc-tic)
+        if tracer.enabled: tracer.record(EV_UI_TEXT, tic, toc, len(byte_array))
 
-    @pyqtSlot(list)
-    def on_SerialReceivedLines(self, lines: list):
+    @pyqtSlot(list, float)
+    def on_SerialReceivedLines(self, lines: list, arrival: float):
         """ 
         Received lines of text on serial port 
         Display the lines in the text display window
         """
-        self.logger.log(logging.DEBUG, "[{}]: text received.".format(int(QThread.currentThreadId())))
-        # decode each line to string and join them with newline (most Pythonic)
-        text = "\n".join(line.decode(self.encoding) for line in lines)
-        # insert text at end of the document    
-        if self.textScrollbar.value() >= self.textScrollbar.maximum()-20:
-            self.isScrolling = True
+        self.displayLines(lines, self.displayQueues["lines"])
+
+    def displayLines(self, lines: list, queue: QueueCounter):
+        """ 
+        Display lines in the text display window
+        """
+        tic = time.perf_counter_ns()
+        STAGE_TEXT.queue = queue.get()
+        # join lines with newline and decode them at once, invalid bytes are replaced
+        text = self.textDecoder.decodeLines(lines)
+        if self.useLineMonitor:
+            self.lineMonitor.appendLines(text.split('\n'))
         else:
-            self.isScrolling = False
-        self.textCursor.movePosition(QTextCursor.End)
-        self.textCursor.insertText(text+'\n')
-        if self.isScrolling:
-            self.ui.plainTextEdit_SerialTextDisplay.ensureCursorVisible()
+            self.serialTextDisplay_append(text)
+        toc = time.perf_counter_ns()
+        STAGE_TEXT.add(lines=len(lines), nbytes=len(text), ns=toc-tic)
+        if tracer.enabled: tracer.record(EV_UI_LINES, tic, toc, len(lines))
+
+    @pyqtSlot(list, float)
+    def on_SerialReceivedPackets(self, packets: list, arrival: float):
+        """ 
+        Received binary packets on serial port 
+        Display each packet as one line of hex numbers
+        """
+        self.displayLines([packet.hex(' ').encode() for packet in packets], self.displayQueues["packets"])
 
-        
     @pyqtSlot(bool)
     def on_serialWorkerStateChanged(self, running: bool):
         """ 
@@ -628,6 +702,7 @@ class QSerialUI(QObject):
         self.logger.log(logging.DEBUG, "[{}]: serial worker is {}.".format(int(QThread.currentThreadId()), "on" if running else "off"))
         self.receiverIsRunning = running
         if running: 
+            self.textDecoder.reset()                                                       # serial buffers were cleared
             self.ui.pushButton_SerialStartStop.setText("Stop")
             self.ui.pushButton_ChartStartStop.setText("Stop")
             self.ui.statusBar().showMessage('Serial Worker started', 2000)
@@ -636,813 +711,329 @@ class QSerialUI(QObject):
             self.ui.pushButton_ChartStartStop.setText("Start")
             self.ui.statusBar().showMessage('Serial Worker stopped', 2000)
 
-    def on_throughputReceived(self, numReceived, numSent):
+    @pyqtSlot(int, int, float)
+    def on_fileProgressReady(self, sent: int, total: int, rate: float):
         """
-        Report throughput
+        Report file transfer progress
         """
-        rx = numReceived - self.lastNumReceived
-        tx = numSent     - self.lastNumSent
-        if rx < 0: rx = self.rx # self.lastNumReceived is not cleared when we clear the serial buffer, take care of it here
-        if tx < 0: tx = self.tx
-        # poor man's low pass
-        self.rx = 0.5*self.rx + 0.5*rx
-        self.tx = 0.5*self.tx + 0.5*tx
-        self.ui.throughput.setText("{:<5.1f} {:<5.1f} kB/s".format(self.rx/1000, self.tx/1000))
-        self.lastNumReceived = numReceived
-        self.lastNumSent     = numSent
+        percent = 100.*sent/total if total > 0 else 100.
+        self.ui.statusBar().showMessage("Sending file {:.0f}% of {:.1f} kB, {:.1f} kB/s".format(percent, total/1000, rate/1000), 2000)
 
-    def serialTextDisplay_trim(self):
+    @pyqtSlot(bool)
+    def on_fileTransferFinished(self, completed: bool):
         """
-        Reduce the amount of text kept in the text display window
-        Attempt to keep the scrollbar location 
+        File transfer completed or was cancelled
         """
-        # Where is the scrollbar?
-        scrollbarMax=self.textScrollbar.maximum()
-        if scrollbarMax != 0:
-            proportion = self.textScrollbar.value() / scrollbarMax
-        else:
-            proportion = 1.0
-        # How much do we need to trim?
-        current_text = self.ui.plainTextEdit_SerialTextDisplay.toPlainText()
-        len_current_text = len(current_text)
-        numCharstoTrim = len_current_text - MAX_TEXTBROWSER_LENGTH
-        if numCharstoTrim > 0:
-            # Select the text to remove
-            self.textCursor.setPosition(0)
-            self.textCursor.movePosition(QTextCursor.Right, QTextCursor.KeepAnchor, numCharstoTrim)
-            # Remove the selected text
-            self.textCursor.removeSelectedText()
-            self.textCursor.movePosition(QTextCursor.End)
-            # update scrollbar position
-            new_max = self.textScrollbar.maximum()
-            new_value = round(proportion * new_max)
-            self.textScrollbar.setValue(new_value)
-            if new_value >= new_max-20:
-                self.ui.plainTextEdit_SerialTextDisplay.ensureCursorVisible()
-        self.ui.statusBar().showMessage('Trimmed Text Display Window', 2000)
-
-        
-############################################################################################
-# Q Serial
-#
-# separate thread handling serial input and output
-# these routines have no access to the user interface, 
-# communication occurs through signals
-#
-# for serial write we send bytes
-# for serial read we receive bytes
-# conversion from text to bytes occurs in QSerialUI
-############################################################################################
-
-class QSerial(QObject):
-    """
-    Serial Interface for QT
-
-    Worker Signals
-        textReceived bytes               received text on serial RX
-        linesReceived list               received multiple lines on serial RX
-        newPortListReady                 completed a port scan
-        newBaudListReady                 completed a baud scan
-        throughputReady                  throughput data is available
-        serialStatusReady                report on port and baudrate available
-        serialWorkerStateChanged         worker started or stopped
-
-    Worker Slots
-        on_startReceiverRequest()        start timer that reads input port
-        on_stopReceiverRequest()         stop  timer that reads input port
-        on_stopWorkerRequest()           stop  timer and close serial port
-        on_sendTextRequest(bytes)        worker received request to transmit text
-        on_sendLinesRequest(list of bytes) worker received request to transmit multiple lines of text
-        on_changePortRequest(str, int)   worker received request to change port
-        on_changeLineTerminationRequest(bytes)
-                                         worker received request to change line termination
-        on_closePortRequest()            worker received request to close current port
-        on_changeBaudRequest(int)        worker received request to change baud rate
-        on_scanPortsRequest()            worker received request to scan for serial ports
-        on_scanBaudRatesRequest()        worker received request to scan for serial baudrates
-        on_serialStatusRequest()         worker received request to report current port and baudrate 
-        on_startThroughputRequest()      start timer to report throughput
-        on_stopThroughputRequest()       stop timer to report throughput
-        on_throughputTimer()             emit throughput data
-    """
-        
-    # Signals
-    ########################################################################################
-    textReceived             = pyqtSignal(bytes)                                           # text received on serial port
-    linesReceived            = pyqtSignal(list)                                            # lines of text received on serial port
-    newPortListReady         = pyqtSignal(list, list)                                      # updated list of serial ports is available
-    newBaudListReady         = pyqtSignal(tuple)                                           # updated list of baudrates is available
-    serialStatusReady        = pyqtSignal(str, int, bytes, float)                          # serial status is available
-    throughputReady          = pyqtSignal(int,int)                                         # number of characters received/sent on serial port
-    serialWorkerStateChanged = pyqtSignal(bool)                                            # worker started or stopped
-    finished                 = pyqtSignal() 
-        
-    def __init__(self, parent=None):
+        self.ui.pushButton_SerialSend.setText("Send File")
+        self.ui.statusBar().showMessage('File sent.' if completed else 'File transfer stopped.', 2000)
 
-        super(QSerial, self).__init__(parent)
-
-        self.logger = logging.getLogger("QSerial")           
-
-        self.PSer = PSerial()
-        self.PSer.scanports()
-        self.serialPorts     = [sublist[0] for sublist in self.PSer.ports]                  # COM3 ...
-        self.serialPortNames = [sublist[1] for sublist in self.PSer.ports]                  # USB ... (COM3)
-        self.serialBaudRates = self.PSer.baudrates
-        
-        self.textLineTerminator = b'\r\n' # default line termination
-
-        # Adjust response time
-        # Fastest serial baud rate is 5,000,000 bits per second 
-        # Regular serial baud rate is   115,200 bits per second
-        # Slow serial baud rate is        9,600 bits per second
-        # Transmitting one byte with 8N1 (8 data bits, no stop bit, one stop bit) might take up to 10 bits
-        # Transmitting two int16 like "-8192, -8191\r\n" takes 14 bytes (3 times more than the actual numbers)
-        # This would result in receiving 1k lines/second with 115200 and 40k lines/second with 5,000,000
-        # These numbers are now updated with a function based on baud rate, see further below        
-        self.receiverInterval          = MIN_RECEIVER_INTERVAL                             # in milliseconds 
-        self.receiverIntervalStandby   = 10*MIN_RECEIVER_INTERVAL                          # in milliseconds
-        self.serialReadTimeOut         = 0                                                 # in seconds
-        self.serialReceiverCountDown   = 0                                                 # initialize
-
-        self.logger.log(logging.INFO, "[{}]: QSerial initialized.".format(int(QThread.currentThreadId())))
-        
-    # Slots
-    ########################################################################################
-
-    @pyqtSlot()
-    def on_setupReceiverRequest(self):
-        """ 
-        Set up a QTimer for reading data from serial input line at predefined interval.
-        This does not start the timer.
-        We can not create the timer in the init function because we will not move QSerial 
-         to a new thread and the timer would not move with it.
-         
-        Set up QTimer for throughput measurements
-        """
-        # if DEBUGPY_ENABLED: debugpy.debug_this_thread() # this should enable debugging of all methods QSerial methods
-                
-        # setup the receiver timer
-        self.serialReceiverState = SerialReceiverState.stopped # initialize state machine
-        self.receiverTimer = QTimer()
-        self.receiverTimer.timeout.connect(self.updateReceiver)
-        self.logger.log(logging.INFO, "[{}]: Setup receiver timer.".format(int(QThread.currentThreadId())))
-
-        # setup the receiver timer
-        self.throughputTimer = QTimer(self)
-        self.throughputTimer.setInterval(1000) 
-        self.throughputTimer.timeout.connect(self.on_throughputTimer)
-        self.logger.log(logging.INFO, "[{}]: Setup throughput timer.".format(int(QThread.currentThreadId())))
+    @pyqtSlot(int, float)
+    def on_txQueueReady(self, depth: int, drainTime: float):
+        """
+        Report data waiting to be transmitted, shown with throughput
+        """
+        self.txQueueText = " TX {:.1f} kB {:.1f} s".format(depth/1000, drainTime) if depth > 0 else ""
 
     @pyqtSlot()
-    def on_throughputTimer(self):
+    def on_actionTxRate(self):
         """
-        Report throughput
+        Limit transmission rate, e.g. for devices with small receive buffers
         """
-        if self.PSer.ser_open:
-            self.throughputReady.emit(self.PSer.totalCharsReceived, self.PSer.totalCharsSent)
-        else:
-            self.throughputReady.emit(0,0)
+        unit, ok = QInputDialog.getItem(self.ui, "Transmit Rate", "Limit transmission to", ["bytes/s", "lines/s"], 1, False)
+        if not ok:
+            return
+        rate, ok = QInputDialog.getDouble(self.ui, "Transmit Rate", "{} (0 no limit)".format(unit), 0., 0., 1e7, 1)
+        if ok:
+            self.changeTxRateRequest.emit(rate, unit == "lines/s")
+            self.ui.statusBar().showMessage('Transmit rate {}.'.format("{:g} {}".format(rate, unit) if rate > 0 else "not limited"), 2000)
 
     @pyqtSlot()
-    def on_startReceiverRequest(self):
-        """ 
-        Start QTimer for reading data from serial input line (RX)
-        Response will need to be analyzed in the main task.
-        """
-        # clear serial buffers
-        self.PSer.clear()
-        # start the receiver timer
-        self.receiverTimer.setInterval(self.receiverInterval) 
-        self.receiverTimer.start()        
-        self.serialReceiverState = SerialReceiverState.awaitingData
-        self.serialWorkerStateChanged.emit(True)
-        self.logger.log(logging.INFO, "[{}]: Started receiver.".format(int(QThread.currentThreadId())))
+    def on_actionTxChunkSize(self):
+        """
+        Size of the chunks a file is read and handed to the port with,
+        smaller chunks keep the transmit queue short for slow devices
+        """
+        chunkSize, ok = QInputDialog.getInt(self.ui, "File Chunk Size", "bytes", self.txChunkSize, 1, 1 << 20)
+        if ok:
+            self.txChunkSize = chunkSize
+            self.changeTxChunkSizeRequest.emit(chunkSize)
+            self.ui.statusBar().showMessage('File chunk size {} bytes.'.format(chunkSize), 2000)
 
     @pyqtSlot()
-    def on_stopReceiverRequest(self):
-        """ 
-        Stop the receiver timer
+    def on_actionRunMacro(self):
         """
-        self.receiverTimer.stop()
-        self.serialReceiverState = SerialReceiverState.stopped
-        self.serialWorkerStateChanged.emit(False)
-        self.logger.log(logging.INFO, "[{}]: Stopped receiver.".format(int(QThread.currentThreadId())))
+        Run a macro file in the serial worker
+        """
+        stdFileName = QStandardPaths.writableLocation(QStandardPaths.DocumentsLocation) + "/macro.txt"
+        fname, _ = QFileDialog.getOpenFileName(self.ui, 'Run Macro', stdFileName, "Macro files (*.txt *.macro);;All files (*)")
+        if not fname:
+            return
+        try:
+            with open(fname, 'r', encoding='utf-8') as f:
+                text = f.read()
+        except (OSError, UnicodeDecodeError):
+            self.ui.statusBar().showMessage('Could not read macro file.', 2000)
+            return
+        if self.receiverIsRunning == False:
+            # responses are needed for waitfor steps
+            self.connectDisplay()
+            self.startReceiverRequest.emit()
+            self.startThroughputRequest.emit()
+            self.ui.pushButton_SerialStartStop.setText("Stop")
+        self.startMacroRequest.emit(text)
 
     @pyqtSlot()
-    def on_startThroughputRequest(self):
-        """ 
-        Stop QTimer for reading through put from PSer)
+    def on_actionStopMacro(self):
+        """
+        Stop running macro
         """
-        self.throughputTimer.start()
-        self.logger.log(logging.INFO, "[{}]: Started throughput timer.".format(int(QThread.currentThreadId())))
+        self.stopMacroRequest.emit()
 
-    @pyqtSlot()
-    def on_stopThroughputRequest(self):
-        """ 
-        Stop QTimer for reading through put from PSer)
+    @pyqtSlot(bool, str)
+    def on_macroStateChanged(self, running: bool, message: str):
         """
-        self.throughputTimer.stop()
-        self.logger.log(logging.INFO, "[{}]: Stopped throughput timer.".format(int(QThread.currentThreadId())))
+        Macro started or finished
+        """
+        self.ui.statusBar().showMessage('Macro {}.'.format(message), 2000)
 
     @pyqtSlot()
-    def updateReceiver(self):
-        """ 
-        Reading lines of text from serial RX 
-        """
-        # if DEBUGPY_ENABLED: debugpy.debug_this_thread() # this should enable debugging of all methods QSerial methods
-
-        if (self.serialReceiverState != SerialReceiverState.stopped):
-            startTime = time.perf_counter()
-            
-            # check if end of line handling is wanted
-            if self.PSer.eol != b'': 
-                # use the readlines and handle line termination
-                lines = self.PSer.readlines() # read lines until buffer empty
-                endTime = time.perf_counter()
-                
-                if lines: 
-                    self.logger.log(logging.DEBUG, "[{}]: {} lines {:.3f} [ms] per line.".format(int(QThread.currentThreadId()),len(lines), 1000*(endTime-startTime)/len(lines)))
-                    if self.serialReceiverState == SerialReceiverState.awaitingData:
-                        self.receiverTimer.setInterval(self.receiverInterval)
-                        self.serialReceiverState == SerialReceiverState.receivingData
-                    self.linesReceived.emit(lines)
+    def on_actionTransactions(self):
+        """
+        Send a command several times, each command waits for a reply
+        Reports round trip time and number of transactions per second
+        """
+        command, ok = QInputDialog.getText(self.ui, "Transactions", "Command, {seq} is replaced by sequence number")
+        if not ok or not command:
+            return
+        reply, ok = QInputDialog.getText(self.ui, "Transactions", "Reply prefix or re:regular expression, (?P<seq>\\d+) matches sequence number",
+                                         text=self.transactionReply)
+        if not ok:
+            return
+        count, ok = QInputDialog.getInt(self.ui, "Transactions", "Number of transactions", 100, 1, 10000000)
+        if not ok:
+            return
+        window, ok = QInputDialog.getInt(self.ui, "Transactions", "Transactions in flight", self.transactionWindow, 1, 10000)
+        if not ok:
+            return
+        self.transactionReply, self.transactionWindow = reply, window
+        if self.receiverIsRunning == False:
+            # replies are needed
+            self.connectDisplay()
+            self.startReceiverRequest.emit()
+            self.startThroughputRequest.emit()
+            self.ui.pushButton_SerialStartStop.setText("Stop")
+        self.changeTransactionRequest.emit(reply, self.transactionTimeout, window)
+        self.sendTransactionRequest.emit(command.encode(self.encoding), count)
 
-                else:
-                    if self.serialReceiverState == SerialReceiverState.receivingData:
-                        self.serialReceiverCountDown += 1
-                        if self.serialReceiverCountDown >= RECEIVER_FINISHCOUNT:    
-                            # switch to awaiting data
-                            self.serialReceiverState = SerialReceiverState.awaitingData
-                            # slow down timer
-                            self.receiverTimer.setInterval(self.receiverIntervalStandby)
-                            self.serialReceiverCountDown = 0
-                            self.logger.log(logging.INFO, "[{}]: Receiving finished, set slower update rate.".format(int(QThread.currentThreadId())))
+    @pyqtSlot(str)
+    def on_transactionsFinished(self, summary: str):
+        """
+        Display transaction statistics
+        """
+        self.ui.statusBar().showMessage(summary, 10000)
 
-            else:
-                # use the ser interface directly
-                byte_array = self.PSer.read()
-                endTime = time.perf_counter()
-                self.logger.log(logging.DEBUG, "[{}]: {} bytes {:.3f} [ms] per line.".format(int(QThread.currentThreadId()),len(byte_array), 1000*(endTime-startTime)/len(byte_array) if len(byte_array) > 0 else 0))
-                self.textReceived.emit(byte_array)
-        
+    @pyqtSlot()
+    def on_actionUpload(self):
+        """
+        Upload files with XMODEM or YMODEM, e.g. firmware to a boot loader
+        Progress is reported and the transfer is cancelled the same way as for send file
+        """
+        if self.ui.pushButton_SerialSend.text() == "Cancel":
+            self.ui.statusBar().showMessage('File transfer in progress.', 2000)
+            return
+        protocol, ok = QInputDialog.getItem(self.ui, "Upload", "Protocol", list(XMODEM_PROTOCOLS), 1, False)
+        if not ok:
+            return
+        window, ok = QInputDialog.getInt(self.ui, "Upload", "Blocks sent before acknowledge, 1 for standard receivers", 1, 1, 64)
+        if not ok:
+            return
+        stdFileName = QStandardPaths.writableLocation(QStandardPaths.DocumentsLocation)
+        if protocol == "YMODEM":
+            fnames, _ = QFileDialog.getOpenFileNames(self.ui, 'Upload', stdFileName, "All files (*)")
         else:
-            self.logger.log(logging.ERROR, "[{}]: Receiver is stopped or port is not open.".format(int(QThread.currentThreadId())))
+            fname, _ = QFileDialog.getOpenFileName(self.ui, 'Upload', stdFileName, "All files (*)")
+            fnames = [fname] if fname else []
+        if fnames:
+            self.uploadFileRequest.emit(fnames, protocol, window)
+            self.ui.pushButton_SerialSend.setText("Cancel")
+            self.ui.statusBar().showMessage('Waiting for receiver to start {}.'.format(protocol), 2000)
 
-        self.logger.log(logging.DEBUG, "[{}]: Completed receiving lines.".format(int(QThread.currentThreadId())))
+    @pyqtSlot()
+    def on_actionLineChecksum(self):
+        """
+        Validate a checksum at the end of each received line, e.g. NMEA sentences ending in *hh
+        Lines that fail are dropped and counted as frame errors in the pipeline metrics
+        """
+        items = ["none"] + list(LINE_CHECKSUMS)
+        item, ok = QInputDialog.getItem(self.ui, "Line Checksum", "Checksum at end of line", items, 0, False)
+        if ok:
+            self.changeLineChecksumRequest.emit(LINE_CHECKSUMS.get(item, ""))
+            self.ui.statusBar().showMessage('Line checksum {}.'.format(item), 2000)
 
     @pyqtSlot()
-    def on_stopWorkerRequest(self): 
-        """ 
-        Worker received request to stop
-        We want to stop QTimer and close serial port and then let subscribers know that serial worker is no longer available
-        """
-        self.receiverTimer.stop()
-        self.serialWorkerStateChanged.emit(False)
-        self.PSer.close()
-        self.logger.log(logging.INFO, "[{}]: Stopped timer, closed port.".format(int(QThread.currentThreadId())))
-        self.finished.emit()
-            
-    @pyqtSlot(bytes)
-    def on_sendTextRequest(self, byte_array: bytes):
-        """ 
-        Request to transmit text to serial TX line 
+    def on_actionAutobaud(self):
         """
-        if self.PSer.ser_open:
-            l = self.PSer.write(byte_array)
-            self.logger.log(logging.DEBUG, "[{}]: Transmitted \"{}\" [{}].".format(int(QThread.currentThreadId()),byte_array.decode('utf-8'), l))
-        else:
-            self.logger.log(logging.ERROR, "[{}]: Tx, port not opened.".format(int(QThread.currentThreadId())))
+        Receive briefly at each baud rate and select the one where the data looks like text
+        The device needs to be sending
+        """
+        if self.serialPort == "":
+            self.ui.statusBar().showMessage('Open a serial port first.', 2000)
+            return
+        self.autobaudRequest.emit()
+        self.ui.statusBar().showMessage('Detecting baud rate...', 2000)
 
-    @pyqtSlot(bytes)
-    def on_sendLineRequest(self, byte_array: bytes):
-        """ 
-        Request to transmit a line of text to serial TX line 
-        Terminate the text with eol characters.
+    @pyqtSlot(int, float)
+    def on_autobaudFinished(self, baud: int, score: float):
         """
-        if self.PSer.ser_open:
-            l = self.PSer.writeline(byte_array)
-            self.logger.log(logging.DEBUG, "[{}]: Transmitted \"{}\" [{}].".format(int(QThread.currentThreadId()),byte_array.decode('utf-8'), l))
+        Baud rate detection finished, serial status with new rate was reported before
+        """
+        if score > 1.:
+            self.ui.statusBar().showMessage('Baud rate {} detected, score {:.2f}.'.format(baud, score), 5000)
         else:
-            self.logger.log(logging.ERROR, "[{}]: Tx, port not opened.".format(int(QThread.currentThreadId())))
+            self.ui.statusBar().showMessage('No text received, baud rate {} kept.'.format(baud), 5000)
 
-    @pyqtSlot(list)
-    def on_sendLinesRequest(self, lines: list):
-        """ 
-        Request to transmit multiple lines of text to serial TX line
+    @pyqtSlot(bool)
+    def on_actionAutoReconnect(self, enabled: bool):
         """
-        if self.PSer.ser_open:
-            l = self.PSer.writelines(lines)
-            self.logger.log(logging.DEBUG, "[{}]: Transmitted {} bytes.".format(int(QThread.currentThreadId()), l))
-        else:
-            self.logger.log(logging.ERROR, "[{}]: Tx, port not opened.".format(int(QThread.currentThreadId())))
+        Reopen a USB serial adapter with the same settings when it reappears after a reset
+        """
+        self.changeReconnectRequest.emit(enabled)
+        self.ui.statusBar().showMessage('Auto reconnect {}.'.format("on" if enabled else "off"), 2000)
 
     @pyqtSlot(str)
-    def on_sendFileRequest(self, fname: str):
-        """ 
-        Request to transmit file to serial TX line 
+    def on_portLost(self, port: str):
         """
-        # if DEBUGPY_ENABLED: debugpy.debug_this_thread()
-        
-        if self.PSer.ser_open:
-            if fname:
-                with open(fname, 'rb') as f: # open file in binary read mode
-                    try: 
-                        file_content = f.read()
-                        l = self.PSer.write(file_content)
-                        self.logger.log(logging.DEBUG, "[{}]: Transmitted \"{}\" [{}].".format(int(QThread.currentThreadId()),fname, l))
-                    except:
-                        self.logger.log(logging.ERROR, "[{}]: Rrror transmitting \"{}\".".format(int(QThread.currentThreadId()),fname))
-            else:
-                self.logger.log(logging.WARNING, "[{}]: No file name provided.".format(int(QThread.currentThreadId())))        
-        else:
-            self.logger.log(logging.ERROR, "[{}]: Tx, port not opened.".format(int(QThread.currentThreadId())))
+        Port vanished, the worker reopens it when it reappears
+        """
+        self.logger.log(logging.WARNING, "[{}]: Port {} lost.".format(int(QThread.currentThreadId()), port))
+        self.ui.statusBar().showMessage('Port {} lost, waiting for it to reappear.'.format(port))
 
-    @pyqtSlot(str, int)
-    def on_changePortRequest(self, port: str, baud: int):
-        """ 
-        Request to change port received 
-        """
-        self.PSer.close()
-        if port != "":
-            serialReadTimeOut, receiverInterval, receiverIntervalStandby = compute_timeouts(baud)
-            if self.PSer.open(port=port, baud=baud, eol=self.textLineTerminator, timeout=serialReadTimeOut):
-                self.serialReadTimeOut = serialReadTimeOut
-                self.receiverInterval = receiverInterval 
-                self.receiverIntervalStandby = receiverIntervalStandby
-                self.receiverTimer.setInterval(self.receiverInterval) 
-                self.logger.log(logging.INFO, "[{}]: Port {} opened with eol {} and timeout {}.".format(
-                    int(QThread.currentThreadId()), port, repr(self.textLineTerminator), self.PSer.timeout))
-            else:
-                self.logger.log(logging.ERROR, "[{}]: Failed to open port {}.".format(int(QThread.currentThreadId()), port))
+    @pyqtSlot(str, float)
+    def on_portReconnected(self, port: str, latency: float):
+        """
+        Port reopened with previous settings, receiver resumed if it was running
+        """
+        self.logger.log(logging.INFO, "[{}]: Port {} reconnected after {:.0f} ms.".format(int(QThread.currentThreadId()), port, latency*1000))
+        self.ui.statusBar().showMessage('Port {} reconnected after {:.0f} ms.'.format(port, latency*1000), 5000)
 
     @pyqtSlot()
-    def on_closePortRequest(self):
-        """ 
-        Request to close port received 
+    def on_actionLatency(self):
         """
-        self.PSer.close()
-
-    @pyqtSlot(int)
-    def on_changeBaudRateRequest(self, baud: int):
-        """ 
-        New baudrate received 
-        """
-        if (baud is None) or (baud <= 0):
-            self.logger.log(logging.WARNING, "[{}]: Range error, baudrate not changed to {},".format(int(QThread.currentThreadId()), baud))
-        else:                
-            serialReadTimeOut, receiverInterval, receiverIntervalStandby = compute_timeouts(baud)    
-            if self.PSer.ser_open:
-                if self.serialBaudRates.index(baud) >= 0: # check if baud rate is available by searching for its index in the baud rate list
-                    self.PSer.changeport(self.PSer.port, baud, eol=self.textLineTerminator, timeout=serialReadTimeOut)
-                    if self.PSer.baud == baud: # check if new value matches desired value
-                        self.serialReadTimeOut = serialReadTimeOut
-                        # self.serialBaudRate = baud  # update local variable
-                        self.receiverInterval = receiverInterval
-                        self.receiverIntervalStandby = receiverIntervalStandby
-                        self.receiverTimer.setInterval(self.receiverInterval) 
-                    else:
-                        # self.serialBaudRate = self.PSer.baud
-                        self.logger.log(logging.ERROR, "[{}]: Failed to set baudrate to {}.".format(int(QThread.currentThreadId()), baud))
-                else: 
-                    self.logger.log(logging.ERROR, "[{}]: Baudrate {} not available.".format(int(QThread.currentThreadId()), baud))
-                    # self.serialBaudRate = -1
-            else:
-                self.logger.log(logging.ERROR, "[{}]: Failed to set baudrate, serial port not open!".format(int(QThread.currentThreadId())))
-            
-    @pyqtSlot(bytes)
-    def on_changeLineTerminationRequest(self, lineTermination: bytes):
-        """ 
-        New LineTermination received
+        Standard profile polls the port, low latency wakes the worker as soon as bytes arrive
+        and asks the driver to forward small packets without delay
         """
-        if (lineTermination is None):
-            self.logger.log(logging.WARNING, "[{}]: Line termination not changed, line termination string not provided.".format(int(QThread.currentThreadId())))
+        items = ["standard", "low latency"]
+        item, ok = QInputDialog.getItem(self.ui, "Port Profile", "Profile", items, 0, False)
+        if not ok:
             return
-        else:            
-            self.PSer.eol = lineTermination
-            self.textLineTerminator = self.PSer.eol
-            self.logger.log(logging.INFO, "[{}]: Changed line termination to {}.".format(int(QThread.currentThreadId()), repr(self.textLineTerminator)))
+        lowLatency = item == "low latency"
+        if lowLatency:
+            chunk, ok = QInputDialog.getInt(self.ui, "Port Profile", "Read at most bytes per wake up, 0 for all available", self.readChunk, 0, 1024*1024)
+            if not ok:
+                return
+            vmin, ok = QInputDialog.getInt(self.ui, "Port Profile", "VMIN, wake up when this many bytes arrived, fewer are read by the receiver timer", self.vmin, 1, 255)
+            if not ok:
+                return
+            self.readChunk, self.vmin = chunk, vmin
+        self.changeLatencyRequest.emit(lowLatency, self.readChunk if lowLatency else 0, self.vmin)
+        self.ui.statusBar().showMessage('Port profile {}.'.format(item), 2000)
 
     @pyqtSlot()
-    def on_scanPortsRequest(self):
-        """ 
-        Request to scan for serial ports received 
-        """            
-        if self.PSer.scanports() > 0 :
-            self.serialPorts =     [sublist[0] for sublist in self.PSer.ports]
-            self.serialPortNames = [sublist[1] for sublist in self.PSer.ports]
-        else :
-            self.serialPorts = []
-            self.serialPortNames = []        
-        self.logger.log(logging.INFO, "[{}]: Port(s) {} available.".format(int(QThread.currentThreadId()),self.serialPortNames))
-        self.newPortListReady.emit(self.serialPorts, self.serialPortNames)
-        
-    @pyqtSlot()
-    def on_scanBaudRatesRequest(self):
-        """ 
-        Request to report serial baud rates received 
+    def on_actionFlowControl(self):
         """
-        if self.PSer.ser_open:
-            self.serialBaudRates = self.PSer.baudrates
-        else:
-            self.serialBaudRates = ()
-        if len(self.serialBaudRates) > 0:
-            self.logger.log(logging.INFO, "[{}]: Baudrate(s) {} available.".format(int(QThread.currentThreadId()),self.serialBaudRates))
-        else:
-            self.logger.log(logging.WARNING, "[{}]: No baudrates available, port is closed.".format(int(QThread.currentThreadId())))
-        self.newBaudListReady.emit(self.serialBaudRates)
+        Flow control lets the device pause while the program can not keep up and the other way around,
+        the device has to use the same flow control
+        """
+        item, ok = QInputDialog.getItem(self.ui, "Flow Control", "Flow control", list(FLOW_CONTROLS), FLOW_CONTROLS.index(self.flowControl), False)
+        if ok:
+            self.flowControl = item
+            self.changeFlowControlRequest.emit(item)
+            self.ui.statusBar().showMessage('Flow control {}.'.format(item), 2000)
 
-    @pyqtSlot()
-    def on_serialStatusRequest(self):
-        """ 
-        Request to report serial port and baudrate received
+    @pyqtSlot(bool)
+    def on_actionLineMonitor(self, enabled: bool):
+        """
+        Line monitor retains a fixed number of lines and paints only the lines in view,
+        for long recordings at high line rates
         """
-        self.logger.log(logging.INFO, "[{}]: Provided serial status".format(int(QThread.currentThreadId())))
-        if self.PSer.ser_open:
-            self.serialStatusReady.emit(self.PSer.port, self.PSer.baud, self.PSer.eol, self.PSer.timeout)
+        self.useLineMonitor = enabled
+        self.lineMonitor.setVisible(enabled)
+        self.ui.plainTextEdit_SerialTextDisplay.setVisible(not enabled)
+        if enabled:
+            self.ui.statusBar().showMessage('Line monitor on, newest {} lines retained.'.format(self.lineMonitor.ring.capacity), 2000)
         else:
-            self.serialStatusReady.emit("", self.PSer.baud, self.PSer.eol, self.PSer.timeout)
-
-def compute_timeouts(baud: int):
-    # Set timeout to the amount of time it takes to receive the shortest expected line of text
-    # integer '123/n/r' 5 bytes, which is at least 45 serial bits
-    # serialReadTimeOut = 40 / baud [s] is very small and we should imply make it by just setting it to zero (non blocking)
-    serialReadTimeOut = 0 # make it non blocking        
-    
-    # Set the QTimer interval so that each call we get a couple of lines
-    # lets assume we receive 4 integers in one line, this is approx 32 bytes, 10 serial bits per byte
-    # lets request NUM_LINES_COLLATE lines per call 
-    receiverInterval  = ceil(NUM_LINES_COLLATE * 32 * 10 / baud * 1000)  # in milliseconds
-    # check serial should occur no more than 200 times per second no less than 10 times per second
-    if receiverInterval < MIN_RECEIVER_INTERVAL: receiverInterval = MIN_RECEIVER_INTERVAL # set maximum to 100 Hz
-    receiverIntervalStandby  = 10 * receiverInterval # make standby 10 times slower
-    if receiverIntervalStandby > MAX_RECEIVER_INTERVAL: # 
-        receiverIntervalStandby = MAX_RECEIVER_INTERVAL # but check at least 10 times per second
-    
-    return serialReadTimeOut, receiverInterval, receiverIntervalStandby
-
-################################################################################
-# Serial Low Level 
-################################################################################
+            self.ui.statusBar().showMessage('Text display on.', 2000)
 
-class PSerial():
-    """
-    Serial Wrapper.
-    
-    read returns bytes or list of bytes
-    write expects bytes or list of bytes
-    """
-    
-    def __init__(self):
-        # if DEBUGPY_ENABLED: debugpy.debug_this_thread() # this should enable debugging of all PSerial methods
-            
-        self.logger = logging.getLogger("PSerial")           
-        self.ser = None
-        self._port = ""
-        self._baud = -1
-        self._eol = ""
-        self._timeout = -1
-        self.ser_open = False
-        self.totalCharsReceived = 0
-        self.totalCharsSent = 0
-        self.partialLine = b''
-        self.havePartialLine = False
-        # check for serial ports
-        _ = self.scanports()
-    
-    def scanports(self) -> int:
-        """ 
-        scans for all available ports 
-        """
-        self._ports = [
-            [p.device, p.description]
-            for p in list_ports.comports()
-        ]
-        return len(self._ports)
-
-    def open(self, port: str, baud: int, eol: bytes, timeout: float) -> bool:
-        """ open specified port """
-        try:       
-            self.ser = sp(
-                port = port,                    # the serial device
-                baudrate = baud,                # often 115200 but Teensy sends/receives as fast as possible
-                bytesize = EIGHTBITS,           # most common option
-                parity = PARITY_NONE,           # most common option
-                stopbits = STOPBITS_ONE,        # most common option
-                timeout = timeout,              # wait until requested characters are received on read request or timeout occurs
-                write_timeout = timeout,        # wait until requested characters are sent
-                inter_byte_timeout = None,      # disable inter character timeout
-                rtscts = False,                 # do not use 'request to send' and 'clear to send' handshaking
-                dsrdtr = False,                 # dont want 'data set ready' signaling
-                exclusive = None,               # do not share port in POSIX
-                xonxoff = False,                # dont have 'xon/xoff' hand shaking in serial data stream
-                )
-        except: 
-            self.ser_open = False
-            self.ser = None
-            self._port=""
-            self.logger.log(logging.ERROR, "[SER {}]: Failed to open port {}.".format(int(QThread.currentThreadId()),port))
-            return False
-        else: 
-            self.logger.log(logging.DEBUG, "[SER {}]: {} opened with baud {}.".format(int(QThread.currentThreadId()), port, baud))
-            self.ser_open = True
-            self._baud = baud
-            self._port = port
-            self._timeout = timeout
-            self._eol = eol
-            self._leneol = len(eol)
-            # clear buffers
-            self.ser.reset_input_buffer()
-            self.ser.reset_output_buffer()
-            self.totalCharsReceived = 0
-            self.totalCharsSent = 0
-            return True
-        
-    def close(self):
-        """ 
-        closes serial port 
-        
-        we have issue in closing textIOwrapped serial port, somehow it claims to be already closed
+    @pyqtSlot()
+    def on_actionPeriodic(self):
         """
-        
-        if (self.ser is not None):
-            # close the port
-            try:
-            # clear buffers
-                self.ser.reset_input_buffer()
-                self.ser.reset_output_buffer()
-                self.ser.close()
-            except:
-                # self.logger.log(logging.ERROR, "[SER {}]: failed to complete closure.".format(int(QThread.currentThreadId())))                      
-                pass
-            self._port = ""
-        self.logger.log(logging.INFO, "[SER {}]: Closed.".format(int(QThread.currentThreadId())))
-        self.ser_open = False
-            
-    def changeport(self, port: str, baud: int, eol: bytes, timeout: float):
-        """ switch to different port """
-        self.close()
-        self.open(port=port, baud=baud, eol=eol, timeout=timeout ) # open also clears the buffers
-        self.logger.log(logging.INFO, "[SER {}]: Changed port to {} with baud {} and eol {}".format(int(QThread.currentThreadId()),port,baud,repr(eol)))
-    
-    def read(self) -> bytes:
-        """ reads serial buffer until empty """
-        startTime = time.perf_counter()
-        bytes_to_read = self.ser.in_waiting
-        if bytes_to_read:
-            byte_array = self.ser.read(bytes_to_read)
-            self.totalCharsReceived += bytes_to_read
-            endTime = time.perf_counter()
-            self.logger.log(logging.DEBUG, "[SER {}]: Read {} bytes. tic toc {}.".format(int(QThread.currentThreadId()), bytes_to_read, endTime-startTime))
-            return byte_array
-        else:
-            endTime = time.perf_counter()
-            self.logger.log(logging.DEBUG, "[SER {}]: End of read, buffer empty. tic toc {}.".format(int(QThread.currentThreadId()),endTime-startTime))
-            return b''
-    
-    def readline(self) -> bytes:
-        """ 
-        reads one line of text 
-        this will not work if the read completed before reading the line termination characters
-        then the merged line will include the line termination characters
-        to avoid this the read timeout can not be set to zero or this function should not be used. 
-        """
-        startTime = time.perf_counter()
-        _line = self.ser.read_until(self._eol) # _line includes the delimiter
-        self.totalCharsReceived += len(_line)
-        if _line:
-            # received text
-            if _line.endswith(self._eol):
-                # have complete line
-                if self.havePartialLine:
-                    # merge previous partial line with current line 
-                    line = self.partialLine + _line[:-self._leneol]
-                    self.havePartialLine = False
-                    self.partialLine = b''
-                else:
-                    line = _line[:-self._leneol]
-            else:
-                # have partial line
-                self.partialLine = _line # save partial line
-                self.havePartialLine = True
-                line = b''
-        endTime = time.perf_counter()
-        self.logger.log(logging.DEBUG, "[SER {}]: tic toc {}, line {}.".format(int(QThread.currentThreadId()), endTime-startTime,  repr(line)))
-        return line.rstrip(self._eol)
-        
-    def readlines(self) -> list:
-        """ 
-        reads serial buffer and converts it into lines of text
-        
-        1. read all bytes from the serial buffer
-        2. find the right most location of the line termination characters
-        3. if line termination has been found 
-           3.1 split the byte array into lines
-           3.2 if there was previously a partial line, merge it with the first line
-           3.2.1 if we received a partial delimiter at the end of the read bytes, 
-                 the merged line will contain a delimiter and we need to split the merged line
-                 and place the split lines at the beginning of the other lines.
-           3.3 if there is a remainder after the last delimiter make it the new partial line
-        4. if no line termination has been found add the byte_array to the partial line array
-        
-        issue here is that if we have a partial delimiter adn the end of the byte array, the partial line will become two lines
+        Send a line at a fixed period, e.g. to poll a sensor
         """
-        # if DEBUGPY_ENABLED: debugpy.debug_this_thread() # this should enable debugging of all methods QSerial methods
-        
-        lines = []
-        
-        startTime = time.perf_counter()
-        bytes_to_read = self.ser.in_waiting
-        if bytes_to_read:
-            byte_array = self.ser.read(bytes_to_read)
-            self.totalCharsReceived += bytes_to_read
-        else:
-            self.logger.log(logging.DEBUG, "[SER {}]: End of read, buffer empty.".format(int(QThread.currentThreadId())))
-            return lines # is empty list
-
-        idx = byte_array.rfind(self._eol) # find end of line delimiter
-        if idx == -1:
-            # no delimiter found
-            self.partialLine += byte_array
-            self.havePartialLine = True
-        else:
-            # delimiter found
-            lines = byte_array.split(self._eol) # split into list of lines, remove eol delimiter
-            if self.havePartialLine:
-                # merge previous partial line with first line
-                # make sure to split the merged line if it contains a delimiter
-                #   if we got partial eol at the end of the byte_array, 
-                #   the merged partial line plus new line will include a delimiter
-                _lines = (self.partialLine + lines[0]).split(self._eol) 
-                lines = _lines + lines[1:]
-                self.havePartialLine = False # clear partial line flag
-                self.partialLine = b'' # clear partial line
-            # check remaining part of the byte_array
-            e = idx + self._leneol 
-            if e < len(byte_array):
-                # we have a remainder, lets put it into the partial line for later use
-                # if we got partial eol in the remainder, the code above for merging will take care of it
-                self.partialLine = byte_array[e:]
-                self.havePartialLine = True
-                lines = lines[:-1] # remove last line from the list as it is a partial line
-            # make sure last or first line is not empty 
-            if lines[-1] == b'': lines = lines[:-1] # (regularly happens)
-            if lines[0] == b'':  lines = lines[1:]  # (occasionally happens)
-        endTime = time.perf_counter() # takes about 0.1 ms
-
-        # DEBUG
-        # indices = [index for index, line in enumerate(lines) if len(line) <= 2]
-        # if len(indices) > 0:
-        #    lines[indices]
-        
-        self.logger.log(logging.DEBUG, "[SER {}]: Eead {} bytes. tic toc {}.".format(int(QThread.currentThreadId()), bytes_to_read, endTime-startTime))
-        return lines
-                            
-    def write(self, byte_array: bytes) -> int:
-        """ sends an array of bytes """
-        try:
-            l = self.ser.write(byte_array)
-            self.totalCharsSent += l
-            self.logger.log(logging.DEBUG, "[SER {}]: Wrote {} bytes.".format(int(QThread.currentThreadId()), l))
-            return l
-        except:
-            self.logger.log(logging.ERROR, "[SER {}]: Failed to write with timeout {}.".format(int(QThread.currentThreadId()), self.timeout ))
-            return l
+        text, ok = QInputDialog.getText(self.ui, "Periodic Send", "Line to send")
+        if not ok or not text:
+            return
+        period, ok = QInputDialog.getDouble(self.ui, "Periodic Send", "Period [ms]", 100., 0.1, 3600000., 1)
+        if ok:
+            self.startPeriodicRequest.emit(text.encode(self.encoding), period)
+            self.ui.statusBar().showMessage('Sending every {:g} ms.'.format(period), 2000)
 
-    def writeline(self, byte_array: bytes) -> int:
-        """ sends an array of bytes + eol """
-        try:
-            l = self.ser.write(byte_array + self._eol)
-            self.totalCharsSent += l
-            self.logger.log(logging.DEBUG, "[SER {}]: Wrote {} bytes.".format(int(QThread.currentThreadId()), l))
-            return l
-        except:
-            self.logger.log(logging.ERROR, "[SER {}]: Failed to write with timeout {}.".format(int(QThread.currentThreadId()), self.timeout ))
-            return l
+    @pyqtSlot()
+    def on_actionStopPeriodic(self):
+        """
+        Stop periodic sending
+        """
+        self.stopPeriodicRequest.emit()
+        self.periodicText = ""
+        self.ui.statusBar().showMessage('Stopped periodic sending.', 2000)
 
-    def writelines(self, lines: list) -> int:
-        """ sends several lines of text, append eol to each line """
-        byte_array = self._eol.join(line for line in lines)
-        try:
-            l=self.ser.write(byte_array)
-            self.totalCharsSent += l
-            self.logger.log(logging.DEBUG, "[SER {}]: Wrote {} chars.".format(int(QThread.currentThreadId()), l))
-            return l
-        except:
-            self.logger.log(logging.ERROR, "[SER {}]: Failed to write with timeout {}.".format(int(QThread.currentThreadId()), self.timeout ))
-            return l
+    @pyqtSlot(float, float, float, int)
+    def on_periodicStatsReady(self, period: float, jitter: float, jitterMax: float, missed: int):
+        """
+        Report actual period and jitter of periodic sender, shown with throughput
+        """
+        self.periodicText = " Period {:.3f} ms jitter p99 {:.3f} max {:.3f} ms{}".format(
+            period*1000, jitter*1000, jitterMax*1000, ", missed {}".format(missed) if missed else "")
 
-    def avail(self) -> int:
-        """ is there data in the serial receiving buffer? """
-        if self.ser is not None:
-            return self.ser.in_waiting
-        else:
-            return -1
-    
-    def clear(self):
-        """ 
-        clear serial buffers
-        we want to clear not flush
-        """
-        if self.ser is not None:
-            self.ser.reset_input_buffer()
-            self.ser.reset_output_buffer()
-            self.totalCharsReceived = 0
-            self.totalCharsSent = 0
-            
-    # Setting and reading internal variables
-    ########################################################################################
-        
-    @property
-    def ports(self):
-        """ returns list of ports """
-        return self._ports    
-
-    @property
-    def baudrates(self):
-        """ returns list of baudrates """
-        if self.ser_open:
-            if max(self.ser.BAUDRATES) <= 115200:
-                # add higher baudrates to the list
-                return (self.ser.BAUDRATES + (230400, 250000, 460800, 500000, 921600, 1000000, 2000000))
-            return self.ser.BAUDRATES
-        else:
-            return ()
-
-    @property
-    def connected(self):
-        """ return true if connected """
-        return self.ser_open
-
-    @property
-    def port(self):
-        """ returns current port """
-        if self.ser_open: return self._port
-        else: return ""
-        
-    @port.setter
-    def port(self, val):
-        """ sets serial port """
-        if (val is None) or  (val == ""):
-            self.logger.log(logging.WARNING, "[SER {}]: No port given {}.".format(int(QThread.currentThreadId()), val))
-            return
-        else:
-            # change the port, clears the buffers
-            if self.changeport(self, val, self.baud):
-                self.logger.log(logging.DEBUG, "[SER {}]: Port:{}.".format(int(QThread.currentThreadId()), val))
-                self._port = val
-            else:
-                self.logger.log(logging.ERROR, "[SER {}]: Failed to open port {}.".format(int(QThread.currentThreadId()), val))
+    def on_throughputReceived(self, numReceived, numSent):
+        """
+        Report throughput
+        """
+        rx = numReceived - self.lastNumReceived
+        tx = numSent     - self.lastNumSent
+        if rx < 0: rx = self.rx # self.lastNumReceived is not cleared when we clear the serial buffer, take care of it here
+        if tx < 0: tx = self.tx
+        # poor man's low pass
+        self.rx = 0.5*self.rx + 0.5*rx
+        self.tx = 0.5*self.tx + 0.5*tx
+        # rows lost according to sequence numbers since previous report
+        checked = STAGE_SEQUENCE.lines  - self.lastNumChecked
+        lost    = STAGE_SEQUENCE.errors - self.lastNumLost
+        lossText = " loss {:.2f}%".format(100*lost/(checked + lost)) if checked + lost > 0 else ""
+        self.ui.throughput.setText("{:<5.1f} {:<5.1f} kB/s{}{}{}".format(self.rx/1000, self.tx/1000, lossText, self.txQueueText, self.periodicText))
+        self.lastNumReceived = numReceived
+        self.lastNumSent     = numSent
+        self.lastNumChecked  = STAGE_SEQUENCE.lines
+        self.lastNumLost     = STAGE_SEQUENCE.errors
 
-    @property
-    def baud(self):
-        """ returns current serial baudrate """
-        if self.ser_open: return self._baud
-        else: return -1
-        
-    @baud.setter
-    def baud(self, val):
-        """ sets serial baud rate """
-        if (val is None) or (val <= 0):
-            self.logger.log(logging.WARNING, "[SER {}]: Baudrate not changed to {}.".format(int(QThread.currentThreadId()), val))
-            return
-        if self.ser_open:
-            self.ser.baudrate = val        # set new baudrate
-            self._baud = self.ser.baudrate # request baudrate
-            if (self._baud == val) : 
-                self.logger.log(logging.DEBUG, "[SER {}]: Baudrate:{}.".format(int(QThread.currentThreadId()), val))
-            else:
-                self.logger.log(logging.ERROR, "[SER {}]: Failed to set baudrate to {}.".format(int(QThread.currentThreadId()), val))
-            # clear buffers
-            self.ser.reset_input_buffer()
-            self.ser.reset_output_buffer()
+    def serialTextDisplay_append(self, text: str):
+        """
+        Insert text at the end of the text display window
+        The document drops its first lines beyond MAX_TEXTBROWSER_LINES, the scrollbar counts lines,
+        when scrolled up it is moved by the number of lines dropped so that the same text stays in view
+        """
+        # if scrollbar is at the end, make sure text display scrolls up
+        if self.textScrollbar.value() >= self.textScrollbar.maximum()-20:
+            self.isScrolling = True
         else:
-            self.logger.log(logging.ERROR, "[SER {}]: Failed to set baudrate, serial port not open!".format(int(QThread.currentThreadId())))
-
-    @property
-    def eol(self):
-        """ returns current line termination """
-        return self._eol
-        
-    @eol.setter
-    def eol(self, val):
-        """ sets serial ioWrapper line termination """
-        if (val is None):
-            self.logger.log(logging.WARNING, "[SER {}]: EOL not changed, need to provide string.".format(int(QThread.currentThreadId())))
-            return
+            self.isScrolling = False
+        document  = self.ui.plainTextEdit_SerialTextDisplay.document()
+        numBlocks = document.blockCount()
+        position  = self.textScrollbar.value()
+        self.textCursor.movePosition(QTextCursor.End)
+        self.textCursor.insertText(text+'\n')
+        if self.isScrolling:
+            self.ui.plainTextEdit_SerialTextDisplay.ensureCursorVisible()
         else:
-            self._eol = val
-            # self._eol = ""
-            self.logger.log(logging.ERROR, "[SER {}]: EOL: {}".format(int(QThread.currentThreadId()), repr(val)))
-
-    @property
-    def timeout(self):
-        """ returns current serial timeout """
-        return self._timeout
-
-#####################################################################################
-# Testing
-#####################################################################################
-
-if __name__ == '__main__':
-    # not implemented
-    pass
+            numDropped = numBlocks + text.count('\n') + 1 - document.blockCount()
+            if numDropped > 0:
+                self.textScrollbar.setValue(max(position - numDropped, 0))
@@ -0,0 +1,1964 @@
+############################################################################################
+# QT Serial Port Helper
+############################################################################################
+# July 2022: initial work
+# December 2023: implemented line reading
+# October 2026: moved out of Qserial_helper, only QtCore is imported
+# October 2026: reconnect adapters that vanish and reappear
+# October 2026: low latency port profile
+# October 2026: arbitrary baud rates, achieved rate is read back
+# October 2026: flow control, receiver backpressure
+# ------------------------------------------------------------------------------------------
+# Urs Utzinger
+# University of Arizona 2022, 2023
+############################################################################################
+############################################################################################
+# This code has 2 sections
+# QSerial: Serial functions running in separate thread, communication with signals and slots.
+# PSerial: Low level interaction with serial ports, called from QSerial.
+#
+# No widgets are used, the headless recorder runs QSerial with a QCoreApplication.
+# The user interface QSerialUI is in Qserial_helper.
+############################################################################################
+############################################################################################
+# Helpful readings:
+# ------------------------------------------------------------------------------------------
+# Signals and Slots and Threads
+#      https://realpython.com/python-pyqt-qthread/
+#      https://www.tutorialspoint.com/pyqt/pyqt_signals_and_slots.htm
+#      http://blog.debao.me/2013/08/how-to-use-qthread-in-the-right-way-part-1/
+#   Examples with Worker Tread
+#      https://stackoverflow.com/questions/41026032/pyqt5-how-to-send-a-signal-to-a-worker-thread
+#      https://stackoverflow.com/questions/68163578/stopping-an-infinite-loop-in-a-worker-thread-in-pyqt5-the-simplest-way
+#      https://stackoverflow.com/questions/61625043/threading-with-qrunnable-proper-manner-of-sending-bi-directional-callbacks
+#      https://stackoverflow.com/questions/52973090/pyqt5-signal-communication-between-worker-thread-and-main-window-is-not-working
+#      https://stackoverflow.com/questions/61625043/threading-with-qrunnable-proper-manner-of-sending-bi-directional-callbacks
+# Timer, infinite loop
+#      https://stackoverflow.com/questions/55651718/how-to-use-a-qtimer-in-a-separate-qthread
+#      https://stackoverflow.com/questions/23607294/qtimer-in-worker-thread
+#      https://stackoverflow.com/questions/60649644/how-to-properly-stop-qtimer-from-another-thread
+#      https://stackoverflow.com/questions/47661854/use-qtimer-to-run-functions-in-an-infinte-loop
+#      https://stackoverflow.com/questions/10492480/starting-qtimer-in-a-qthread
+#      https://programmer.ink/think/no-event-loop-or-use-of-qtimer-in-non-gui-qt-threads.html
+#      https://www.pythonfixing.com/2022/03/fixed-how-to-use-qtimer-inside-qthread.html
+# Serial
+#   Examples using pySerial
+#      https://programmer.group/python-uses-pyqt5-to-write-a-simple-serial-assistant.html
+#      https://github.com/mcagriaksoy/Serial-Communication-GUI-Program
+#      https://hl4rny.tistory.com/433
+#      https://iosoft.blog/pyqt-serial-terminal-code
+#   Examples using QSerialPort
+#      https://stackoverflow.com/questions/55070483/connect-to-serial-from-a-pyqt-gui
+#      https://ymt-lab.com/en/post/2021/pyqt5-serial-monitor
+#
+############################################################################################
+
+from serial import Serial as sp
+from serial import EIGHTBITS, PARITY_NONE, STOPBITS_ONE
+from serial.tools import list_ports 
+
+import time, logging, os, re, sys, array, threading
+from math import ceil
+from enum import Enum
+
+try:
+    import debugpy
+    DEBUGPY_ENABLED = True
+except ImportError:
+    DEBUGPY_ENABLED = False
+
+try:
+    import termios, fcntl
+except ImportError:
+    termios = fcntl = None                                                                 # Windows, no VMIN
+    
+from PyQt5.QtCore    import QObject, QTimer, QThread, pyqtSignal, pyqtSlot, QSocketNotifier
+from PyQt5.QtCore    import Qt
+
+# Tracing of receiver pipeline
+from helpers.Profiler_helper import tracer, metrics, QueueCounter
+from helpers.Transmit_helper import TxQueue, TokenBucket, LANE_INTERACTIVE, LANE_BULK, LANE_FILE
+from helpers.Macro_helper    import MacroRunner, PeriodicSchedule
+from helpers.Transaction_helper import TransactionTracker
+from helpers.Xmodem_helper   import XmodemSender
+from helpers.Hotplug_helper  import DeviceMonitor, DEVICE_DIRECTORY
+from helpers.Codec_helper    import FrameDecoder, LINE_CHECKSUMS, check_block, score_baud, best_baud, AUTOBAUD_MIN_BYTES
+
+# Constants
+########################################################################################
+DEFAULT_BAUDRATE          = 115200      # default baud rate for serial port
+MAX_LINE_LENGTH           = 1024        # number of characters after which an end of line characters is expected
+RECEIVER_FINISHCOUNT      = 10          # [times] If we encountered a timeout 10 times we slow down serial polling
+NUM_LINES_COLLATE         = 10          # [lines] estimated number of lines to collate before emitting signal
+                                        #   this results in collating about NUM_LINES_COLLATE * 32 bytes in a list of lines
+                                        #   plotting and processing large amounts of data is more efficient for display and plotting 
+MAX_RECEIVER_INTERVAL     = 100         # [ms]
+MIN_RECEIVER_INTERVAL     = 5           # [ms]
+TX_CHUNK_SIZE             = 1024        # [bytes] files are read and transmitted in chunks of this size
+TX_BUFFER_SIZE            = 4096        # [bytes] do not keep more than this in the operating system transmit buffer
+TX_INTERVAL               = 5           # [ms] transmitter pacing interval
+PROGRESS_INTERVAL         = 0.1         # [s] file transfer progress is reported at this interval
+SPIN_TIME                 = 0.002       # [s] macro steps and periodic commands due sooner than this are busy waited for, timers have 1 ms resolution
+UPLOAD_INTERVAL           = 1           # [ms] protocol upload services the port at this interval
+MACRO_SLICE               = 0.005       # [s] macro returns to the event loop after running this long so that receiver is serviced
+AUTOBAUD_WINDOW           = 0.02        # [s] bytes are collected at least this long at each candidate baud rate
+AUTOBAUD_MIN_BAUD         = 1200        # lower rates need too long to receive enough bytes, total scan stays below 1 s
+HOTPLUG_RETRY             = 20          # [ms] while port is lost check for it at this interval, without inotify this polls the directory
+HOTPLUG_POLL              = 500         # [ms] without inotify, check for removal of open port at this interval
+LOW_LATENCY_TIMER         = 1           # [ms] FTDI latency timer in low latency profile
+DEFAULT_LATENCY_TIMER     = 16          # [ms] FTDI driver default, adapter sends a partial USB packet after this time
+LOW_LATENCY_VMIN          = 1           # [bytes] port becomes readable when this many bytes arrived
+LOW_LATENCY_TX_INTERVAL   = 1           # [ms] transmitter pacing interval in low latency profile
+RX_BUFFER_SIZE            = 4096        # [bytes] operating system receive buffer, one read returns at most this
+BAUD_TOLERANCE            = 0.03        # achieved baud rate may deviate this much from requested, UARTs tolerate about 3%
+TCGETS2                   = 0x802C542A  # Linux ioctl reading termios2, c_ospeed is the rate the driver set
+FLOW_CONTROLS             = ("none", "RTS/CTS", "DSR/DTR", "XON/XOFF")
+RX_HIGH_WATER             = 50          # [batches] stop reading the port when this many received batches were not yet processed
+RX_LOW_WATER              = 10          # [batches] resume reading when the backlog dropped to this
+
+# Trace events
+EV_RECEIVER_LINES         = tracer.register("QSerial.updateReceiver lines")
+EV_RECEIVER_TEXT          = tracer.register("QSerial.updateReceiver text")
+EV_RECEIVER_PACKETS       = tracer.register("QSerial.updateReceiver packets")
+EV_READ                   = tracer.register("PSerial.read")
+EV_READLINE               = tracer.register("PSerial.readline")
+EV_READLINES              = tracer.register("PSerial.readlines")
+
+# Pipeline stages
+STAGE_READ                = metrics.stage("read")
+STAGE_FRAME               = metrics.stage("frame")
+STAGE_TX                  = metrics.stage("tx")
+STAGE_MACRO               = metrics.stage("macro")                                        # latency is how late commands are sent
+STAGE_TRANSACTION         = metrics.stage("transaction")                                  # latency is round trip time, errors are timeouts
+STAGE_UPLOAD              = metrics.stage("upload")                                       # acknowledged bytes, errors are retransmitted blocks
+STAGE_PERIODIC            = metrics.stage("periodic")                                     # latency is how late commands are sent, errors are missed periods
+
+class SerialReceiverState(Enum):
+    """ 
+    When data is expected on the serial input we use a QT timer to read line by line.
+    When no data is expected we are in stopped state
+    When data is expected but has not yet arrived we are in awaiting state
+    When data has arrived and there might be more data arriving we are in receiving state
+    """
+    stopped               =  0
+    awaitingData          =  1
+    receivingData         =  2
+
+############################################################################################
+# Q Serial
+#
+# separate thread handling serial input and output
+# these routines have no access to the user interface, 
+# communication occurs through signals
+#
+# for serial write we send bytes
+# for serial read we receive bytes
+# conversion from text to bytes occurs in QSerialUI
+############################################################################################
+
+class QSerial(QObject):
+    """
+    Serial Interface for QT
+
+    Worker Signals
+        textReceived bytes, float        received text on serial RX, perf_counter when it was read
+        linesReceived list, float        received multiple lines on serial RX, perf_counter when they were read
+        packetsReceived list, float      received COBS or SLIP framed packets on serial RX, decoded
+        newPortListReady                 completed a port scan
+        newBaudListReady                 completed a baud scan
+        throughputReady                  throughput data is available
+        serialStatusReady                report on port and baudrate available
+        serialWorkerStateChanged         worker started or stopped
+        fileProgressReady                bytes of file sent, file size, bytes/s
+        fileTransferFinished             file transfer completed (True) or stopped (False)
+        txQueueReady                     bytes waiting to be transmitted, time to transmit them
+        macroStateChanged                macro running or finished, message
+        transactionsReady                list of (sequence, command, reply, round trip time [s]), reply is empty after timeout
+        transactionsFinished             statistics after all transactions completed
+        periodicStatsReady               mean period, p99 and max jitter [s], missed periods, once a second
+        autobaudFinished                 selected baud rate and its score
+        portLost                         open port vanished, e.g. USB adapter was reset
+        portReconnected                  lost port was reopened, seconds it was lost
+                                         file upload reports with fileProgressReady and fileTransferFinished
+
+    Worker Slots
+        on_startReceiverRequest()        start timer that reads input port
+        on_stopReceiverRequest()         stop  timer that reads input port
+        on_stopWorkerRequest()           stop  timer and close serial port
+        on_sendTextRequest(bytes)        worker received request to transmit text
+        on_sendLineRequest(bytes)        worker received request to transmit command, ahead of other data
+        on_sendLinesRequest(list of bytes) worker received request to transmit multiple lines of text
+        on_changeTxRateRequest(float, bool) limit transmission to bytes/s or lines/s, 0 no limit
+        on_changePortRequest(str, int)   worker received request to change port
+        on_changeLineTerminationRequest(bytes)
+                                         worker received request to change line termination
+        on_changeFramingRequest(str)     receive and transmit "cobs" or "slip" framed packets, "" for lines or text
+        on_changeLineChecksumRequest(str) validate "xor", "crc8" or "crc16" checksum at end of lines, "" for none
+        on_closePortRequest()            worker received request to close current port
+        on_changeBaudRequest(int)        worker received request to change baud rate
+        on_scanPortsRequest()            worker received request to scan for serial ports
+        on_scanBaudRatesRequest()        worker received request to scan for serial baudrates
+        on_autobaudRequest()             score received data at each baud rate and select the best
+        on_changeReconnectRequest(bool)  reopen a lost port when it reappears
+        on_hotplugEvent()                device directory changed or retry to reopen lost port
+        on_changeLatencyRequest(bool, int, int, int)
+                                         low latency profile, read chunk [bytes], VMIN
+        on_changeFlowControlRequest(str) RTS/CTS, DSR/DTR, XON/XOFF or none
+        on_serialStatusRequest()         worker received request to report current port and baudrate 
+        on_startThroughputRequest()      start timer to report throughput
+        on_stopThroughputRequest()       stop timer to report throughput
+        on_throughputTimer()             emit throughput data
+        on_sendFileRequest(str)          start transmitting file in chunks
+        on_cancelSendFileRequest()       stop transmitting file
+        on_changeTxChunkSizeRequest(int) change file transfer chunk size
+        on_txTimer()                     transmit queued data and file paced to baud rate and rate limit
+        on_startMacroRequest(str)        parse and run macro
+        on_stopMacroRequest()            stop macro
+        on_macroTimer()                  execute macro steps that are due
+        on_changeTransactionRequest(str, float, int)
+                                         reply pattern, timeout [ms], transactions in flight
+        on_sendTransactionRequest(bytes, int)
+                                         send command count times as transactions
+        on_cancelTransactionRequest()    forget outstanding transactions
+        on_transactionTimer()            expire transactions without reply
+        on_startPeriodicRequest(bytes, float)
+                                         send line every period [ms]
+        on_stopPeriodicRequest()         stop periodic sending
+        on_periodicTimer()               send line when due
+        on_uploadFileRequest(list, str, int)
+                                         upload files with protocol, blocks in flight
+        on_uploadTimer()                 exchange protocol data with receiver
+
+    Consumers of received data connect with connectReceiver(kind, slot) and call get() on the
+    returned counter for each batch, kind is "lines", "text" or "packets"
+    """
+        
+    # Signals
+    ########################################################################################
+    textReceived             = pyqtSignal(bytes, float)                                    # text received on serial port, read time [s]
+    linesReceived            = pyqtSignal(list, float)                                     # lines of text received on serial port, read time [s]
+    packetsReceived          = pyqtSignal(list, float)                                     # binary packets received on serial port, read time [s]
+    newPortListReady         = pyqtSignal(list, list)                                      # updated list of serial ports is available
+    newBaudListReady         = pyqtSignal(tuple)                                           # updated list of baudrates is available
+    serialStatusReady        = pyqtSignal(str, int, bytes, float)                          # serial status is available
+    throughputReady          = pyqtSignal(int,int)                                         # number of characters received/sent on serial port
+    serialWorkerStateChanged = pyqtSignal(bool)                                            # worker started or stopped
+    fileProgressReady        = pyqtSignal(int, int, float)                                 # bytes sent, file size, bytes/s
+    fileTransferFinished     = pyqtSignal(bool)                                            # file transfer completed or stopped
+    txQueueReady             = pyqtSignal(int, float)                                      # bytes waiting to be transmitted, seconds to transmit them
+    macroStateChanged        = pyqtSignal(bool, str)                                       # macro running, message
+    transactionsReady        = pyqtSignal(list)                                            # completed or expired transactions
+    transactionsFinished     = pyqtSignal(str)                                             # transaction statistics
+    periodicStatsReady       = pyqtSignal(float, float, float, int)                        # period, jitter p99, jitter max, missed
+    autobaudFinished         = pyqtSignal(int, float)                                      # detected baud rate, score
+    portLost                 = pyqtSignal(str)                                             # port vanished
+    portReconnected          = pyqtSignal(str, float)                                      # port reopened, seconds it was lost
+    finished                 = pyqtSignal() 
+        
+    def __init__(self, parent=None):
+
+        super(QSerial, self).__init__(parent)
+
+        self.logger = logging.getLogger("QSerial")           
+
+        self.PSer = PSerial()
+        self.PSer.scanports()
+        self.serialPorts     = [sublist[0] for sublist in self.PSer.ports]                  # COM3 ...
+        self.serialPortNames = [sublist[1] for sublist in self.PSer.ports]                  # USB ... (COM3)
+        self.serialBaudRates = self.PSer.baudrates
+        
+        self.textLineTerminator = b'\r\n' # default line termination
+        self.framer             = None    # COBS or SLIP decoder, None for lines or text
+
+        # Adjust response time
+        # Fastest serial baud rate is 5,000,000 bits per second 
+        # Regular serial baud rate is   115,200 bits per second
+        # Slow serial baud rate is        9,600 bits per second
+        # Transmitting one byte with 8N1 (8 data bits, no stop bit, one stop bit) might take up to 10 bits
+        # Transmitting two int16 like "-8192, -8191\r\n" takes 14 bytes (3 times more than the actual numbers)
+        # This would result in receiving 1k lines/second with 115200 and 40k lines/second with 5,000,000
+        # These numbers are now updated with a function based on baud rate, see further below        
+        self.receiverInterval          = MIN_RECEIVER_INTERVAL                             # in milliseconds 
+        self.receiverIntervalStandby   = 10*MIN_RECEIVER_INTERVAL                          # in milliseconds
+        self.serialReadTimeOut         = 0                                                 # in seconds
+        self.serialReceiverCountDown   = 0                                                 # initialize
+
+        # Transmitter, data is queued and transmitted by the transmitter timer
+        # commands typed by the user are transmitted ahead of text, lines and files
+        self.txQueue                   = TxQueue(self.textLineTerminator)
+        self.txBucket                  = TokenBucket()                                     # rate limit, default none
+        self.txChunkSize               = TX_CHUNK_SIZE                                     # in bytes
+        self.txFile                    = None                                              # file being transmitted
+        self.txFileSize                = 0
+        self.txFileSent                = 0
+        self.txFileRead                = 0
+
+        # Macro, runs in this thread, scheduled with its own timer
+        self.macro                     = None
+
+        # Transactions, commands with replies
+        self.transactions              = TransactionTracker()
+        self.transactionRest           = b''                                               # partial reply without line termination
+
+        # Periodic sender, line sent at absolute deadlines
+        self.periodic                  = PeriodicSchedule()
+        self.periodicLine              = None                                              # None when not sending
+
+        # Hot plug, monitor is created with its notifier in the worker thread
+        self.hotplug                   = None
+        self.hotplugDirectory          = DEVICE_DIRECTORY
+        self.autoReconnect             = True
+        self.lostPort                  = ""                                                # port that vanished
+        self.lostBaud                  = DEFAULT_BAUDRATE
+        self.resumeReceiver            = False                                             # receiver was running when port vanished
+
+        # Low latency profile, receiver is woken by a notifier on the port instead of polled
+        self.lowLatency                = False
+        self.rxNotifier                = None
+
+        # Received batches, one queue counter for each connected consumer slot
+        self.rxQueues                  = {"lines": (), "text": (), "packets": ()}          # replaced, not modified, while worker emits
+        self.rxLock                    = threading.Lock()                                  # connecting a consumer and emitting a batch
+
+        # Backpressure, port is not read while the user interface falls behind
+        self.rxThrottled               = False
+        self.numThrottled              = 0
+
+        # Protocol upload, receiver is serviced by upload timer instead of updateReceiver
+        self.upload                    = None
+        self.uploadSent                = 0
+        self.uploadRetries             = 0
+        self.txStartTime               = 0.
+        self.txLastTime                = 0.
+        self.txLastProgress            = 0.
+
+        self.logger.log(logging.INFO, "[{}]: QSerial initialized.".format(int(QThread.currentThreadId())))
+        
+    # Slots
+    ########################################################################################
+
+    @pyqtSlot()
+    def on_setupReceiverRequest(self):
+        """ 
+        Set up a QTimer for reading data from serial input line at predefined interval.
+        This does not start the timer.
+        We can not create the timer in the init function because we will not move QSerial 
+         to a new thread and the timer would not move with it.
+         
+        Set up QTimer for throughput measurements
+        """
+        # if DEBUGPY_ENABLED: debugpy.debug_this_thread() # this should enable debugging of all methods QSerial methods
+                
+        # setup the receiver timer
+        self.serialReceiverState = SerialReceiverState.stopped # initialize state machine
+        self.receiverTimer = QTimer()
+        self.receiverTimer.timeout.connect(self.updateReceiver)
+        self.logger.log(logging.INFO, "[{}]: Setup receiver timer.".format(int(QThread.currentThreadId())))
+
+        # setup the receiver timer
+        self.throughputTimer = QTimer(self)
+        self.throughputTimer.setInterval(1000) 
+        self.throughputTimer.timeout.connect(self.on_throughputTimer)
+        self.logger.log(logging.INFO, "[{}]: Setup throughput timer.".format(int(QThread.currentThreadId())))
+
+        # setup the transmitter timer, it runs only while data is waiting to be transmitted
+        self.txTimer = QTimer(self)
+        self.txTimer.setTimerType(Qt.PreciseTimer)
+        self.txTimer.setInterval(TX_INTERVAL)
+        self.txTimer.timeout.connect(self.on_txTimer)
+        self.logger.log(logging.INFO, "[{}]: Setup transmitter timer.".format(int(QThread.currentThreadId())))
+
+        # setup the macro timer, single shot to when the next macro step is due
+        self.macroTimer = QTimer(self)
+        self.macroTimer.setTimerType(Qt.PreciseTimer)
+        self.macroTimer.setSingleShot(True)
+        self.macroTimer.timeout.connect(self.on_macroTimer)
+        self.logger.log(logging.INFO, "[{}]: Setup macro timer.".format(int(QThread.currentThreadId())))
+
+        # setup the transaction timer, single shot to when the oldest transaction times out
+        self.transactionTimer = QTimer(self)
+        self.transactionTimer.setTimerType(Qt.PreciseTimer)
+        self.transactionTimer.setSingleShot(True)
+        self.transactionTimer.timeout.connect(self.on_transactionTimer)
+
+        # setup the periodic timer, single shot to shortly before the line is due
+        self.periodicTimer = QTimer(self)
+        self.periodicTimer.setTimerType(Qt.PreciseTimer)
+        self.periodicTimer.setSingleShot(True)
+        self.periodicTimer.timeout.connect(self.on_periodicTimer)
+
+        # setup the upload timer, runs during XMODEM/YMODEM upload
+        self.uploadTimer = QTimer(self)
+        self.uploadTimer.setTimerType(Qt.PreciseTimer)
+        self.uploadTimer.setInterval(UPLOAD_INTERVAL)
+        self.uploadTimer.timeout.connect(self.on_uploadTimer)
+
+        # setup hot plug detection, inotify wakes the worker when the device directory changes,
+        # the timer polls the directory when there is no inotify and retries reopening a lost port
+        self.hotplug = DeviceMonitor(self.hotplugDirectory)
+        self.hotplugTimer = QTimer(self)
+        self.hotplugTimer.timeout.connect(self.on_hotplugEvent)
+        if self.hotplug.fileno >= 0:
+            self.hotplugNotifier = QSocketNotifier(self.hotplug.fileno, QSocketNotifier.Read, self)
+            self.hotplugNotifier.activated.connect(self.on_hotplugEvent)
+        self.logger.log(logging.INFO, "[{}]: Setup hot plug detection, {}.".format(
+            int(QThread.currentThreadId()), "inotify" if self.hotplug.fileno >= 0 else "polling"))
+
+    @pyqtSlot()
+    def on_throughputTimer(self):
+        """
+        Report throughput
+        """
+        if self.PSer.ser_open:
+            self.throughputReady.emit(self.PSer.totalCharsReceived, self.PSer.totalCharsSent)
+        else:
+            self.throughputReady.emit(0,0)
+        depth = self.txQueue.depth + self.txFileSize - self.txFileRead
+        self.txQueueReady.emit(depth, self.txDrainTime())
+        if self.periodicLine is not None:
+            self.periodicStatsReady.emit(*self.periodic.stats())
+
+    @pyqtSlot()
+    def on_startReceiverRequest(self):
+        """ 
+        Start QTimer for reading data from serial input line (RX)
+        Response will need to be analyzed in the main task.
+        """
+        # clear serial buffers
+        self.PSer.clear()
+        # start the receiver timer
+        self.receiverTimer.setInterval(self.receiverInterval) 
+        self.receiverTimer.start()        
+        self.serialReceiverState = SerialReceiverState.awaitingData
+        self.updateRxNotifier()
+        self.serialWorkerStateChanged.emit(True)
+        self.logger.log(logging.INFO, "[{}]: Started receiver.".format(int(QThread.currentThreadId())))
+
+    @pyqtSlot()
+    def on_stopReceiverRequest(self):
+        """ 
+        Stop the receiver timer
+        """
+        self.receiverTimer.stop()
+        self.serialReceiverState = SerialReceiverState.stopped
+        self.updateRxNotifier()
+        self.serialWorkerStateChanged.emit(False)
+        self.logger.log(logging.INFO, "[{}]: Stopped receiver.".format(int(QThread.currentThreadId())))
+
+    @pyqtSlot()
+    def on_startThroughputRequest(self):
+        """ 
+        Stop QTimer for reading through put from PSer)
+        """
+        self.throughputTimer.start()
+        self.logger.log(logging.INFO, "[{}]: Started throughput timer.".format(int(QThread.currentThreadId())))
+
+    @pyqtSlot()
+    def on_stopThroughputRequest(self):
+        """ 
+        Stop QTimer for reading through put from PSer)
+        """
+        self.throughputTimer.stop()
+        self.logger.log(logging.INFO, "[{}]: Stopped throughput timer.".format(int(QThread.currentThreadId())))
+
+    @pyqtSlot()
+    def updateReceiver(self):
+        """ 
+        Reading lines of text from serial RX 
+        """
+        # if DEBUGPY_ENABLED: debugpy.debug_this_thread() # this should enable debugging of all methods QSerial methods
+
+        if self.upload is not None:
+            return                                                                         # upload protocol reads the port
+
+        try:
+            if self.throttleReceiver():
+                return                                                                     # user interface is behind, let the port buffer fill
+            if (self.serialReceiverState != SerialReceiverState.stopped):
+                tracing = tracer.enabled                                                   # read once, tracing can be started during this call
+                if tracing: tic = time.perf_counter_ns()
+            
+                # check if binary packets are wanted
+                if self.framer is not None:
+                    byte_array = self.PSer.read()
+                    if byte_array:
+                        now = time.perf_counter()                                          # read time, queued slots run later
+                        toc = time.perf_counter_ns()
+                        packets, num_errors = self.framer.decode(byte_array)
+                        STAGE_FRAME.add(lines=len(packets), nbytes=len(byte_array), ns=time.perf_counter_ns()-toc, errors=num_errors)
+                        if packets:
+                            self.emitReceived("packets", packets, now)
+                            if self.transactions.inFlight:
+                                self.serviceTransactions(self.transactions.match(packets, now))
+                        if tracing: tracer.record(EV_RECEIVER_PACKETS, tic, time.perf_counter_ns(), len(packets))
+
+                # check if end of line handling is wanted
+                elif self.PSer.eol != b'': 
+                    # use the readlines and handle line termination
+                    lines = self.PSer.readlines() # read lines until buffer empty
+                
+                    if lines: 
+                        now = time.perf_counter()                                          # read time, queued slots run later
+                        if self.serialReceiverState == SerialReceiverState.awaitingData:
+                            self.receiverTimer.setInterval(self.receiverInterval)
+                            self.serialReceiverState == SerialReceiverState.receivingData
+                        self.emitReceived("lines", lines, now)
+                        if self.transactions.inFlight:
+                            self.serviceTransactions(self.transactions.match(lines, now))
+                        if self.macro is not None and self.macro.waitingFor is not None:
+                            self.macro.feed(lines)
+                            self.on_macroTimer()
+                        if tracing: tracer.record(EV_RECEIVER_LINES, tic, time.perf_counter_ns(), len(lines))
+
+                    else:
+                        if self.serialReceiverState == SerialReceiverState.receivingData:
+                            self.serialReceiverCountDown += 1
+                            if self.serialReceiverCountDown >= RECEIVER_FINISHCOUNT:    
+                                # switch to awaiting data
+                                self.serialReceiverState = SerialReceiverState.awaitingData
+                                # slow down timer
+                                self.receiverTimer.setInterval(self.receiverIntervalStandby)
+                                self.serialReceiverCountDown = 0
+                                self.logger.log(logging.INFO, "[{}]: Receiving finished, set slower update rate.".format(int(QThread.currentThreadId())))
+
+                else:
+                    # use the ser interface directly
+                    byte_array = self.PSer.read()
+                    if byte_array:
+                        now = time.perf_counter()
+                        self.emitReceived("text", byte_array, now)
+                        if self.transactions.inFlight:
+                            self.serviceTransactions(self.transactions.match(self.splitReplies(byte_array), now))
+                        if self.macro is not None and self.macro.waitingFor is not None:
+                            self.macro.feed([byte_array])
+                            self.on_macroTimer()
+                        if tracing: tracer.record(EV_RECEIVER_TEXT, tic, time.perf_counter_ns(), len(byte_array))
+        
+            else:
+                self.logger.log(logging.ERROR, "[{}]: Receiver is stopped or port is not open.".format(int(QThread.currentThreadId())))
+        except OSError as e:
+            # USB adapter was unplugged or reset
+            self.closeLostPort(str(e))
+
+    def connectReceiver(self, kind: str, slot) -> QueueCounter:
+        """
+        Connect consumer slot to linesReceived, textReceived or packetsReceived
+        Returns the counter of batches emitted to the slot and not yet handled,
+        the slot calls get() for each batch, also for batches arriving after disconnect
+        """
+        counter = QueueCounter()
+        with self.rxLock:                                                                  # no batch is emitted between connecting and counting
+            getattr(self, kind + "Received").connect(slot)
+            self.rxQueues[kind] = self.rxQueues[kind] + (counter,)
+        return counter
+
+    def disconnectReceiver(self, kind: str, slot, counter: QueueCounter):
+        """ disconnect consumer slot, its counter no longer contributes to the backlog """
+        with self.rxLock:
+            try:
+                getattr(self, kind + "Received").disconnect(slot)
+            except TypeError:
+                pass                                                                       # was not connected
+            self.rxQueues[kind] = tuple(c for c in self.rxQueues[kind] if c is not counter)
+
+    def emitReceived(self, kind: str, data, now: float):
+        """ count batch for each connected consumer and emit it with the time it was read """
+        with self.rxLock:
+            for counter in self.rxQueues[kind]:
+                counter.put()
+            getattr(self, kind + "Received").emit(data, now)
+
+    @property
+    def backlog(self) -> int:
+        """ batches not yet handled by the slowest consumer of this worker """
+        return max((counter.depth for counters in self.rxQueues.values() for counter in counters), default=0)
+
+    def throttleReceiver(self) -> bool:
+        """
+        Backpressure, returns True while the port is not read
+        When RX_HIGH_WATER received batches wait in the event queue of the user interface, reading pauses
+        until the backlog is down to RX_LOW_WATER. The operating system buffer fills and the driver
+        deasserts RTS (RTS/CTS) or sends XOFF (XON/XOFF) so that the device pauses instead of data being lost.
+        Linux has no DSR/DTR flow control, DTR is dropped here.
+        """
+        depth = self.backlog
+        if not self.rxThrottled:
+            if depth < RX_HIGH_WATER:
+                return False
+            self.rxThrottled = True
+            self.numThrottled += 1
+            if self.PSer.flowControl == "DSR/DTR": self.PSer.setDtr(False)
+            self.updateRxNotifier()
+            self.logger.log(logging.DEBUG, "[{}]: Receiver paused, {} batches not processed.".format(int(QThread.currentThreadId()), depth))
+        elif depth <= RX_LOW_WATER:
+            self.rxThrottled = False
+            if self.PSer.flowControl == "DSR/DTR": self.PSer.setDtr(True)
+            self.updateRxNotifier()
+            self.logger.log(logging.DEBUG, "[{}]: Receiver resumed.".format(int(QThread.currentThreadId())))
+        return self.rxThrottled
+
+    @pyqtSlot()
+    def on_stopWorkerRequest(self): 
+        """ 
+        Worker received request to stop
+        We want to stop QTimer and close serial port and then let subscribers know that serial worker is no longer available
+        """
+        self.receiverTimer.stop()
+        self.serialWorkerStateChanged.emit(False)
+        if self.txFile is not None:
+            self.finishFileTransfer(False)
+        if self.upload is not None:
+            self.upload.cancel()
+            self.on_uploadTimer()
+        if self.macro is not None:
+            self.macro.stop("stopped")
+            self.finishMacro()
+        self.transactions.clear()
+        self.transactionRest = b''
+        self.transactionTimer.stop()
+        self.on_stopPeriodicRequest()
+        self.txQueue.clear()
+        if self.hotplug is not None:
+            self.forgetLostPort()
+            if self.hotplug.fileno >= 0: self.hotplugNotifier.setEnabled(False)
+            self.hotplug.close()
+        self.PSer.close()
+        self.updateRxNotifier()
+        self.logger.log(logging.INFO, "[{}]: Stopped timer, closed port.".format(int(QThread.currentThreadId())))
+        self.finished.emit()
+            
+    @pyqtSlot(bytes)
+    def on_sendTextRequest(self, byte_array: bytes):
+        """ 
+        Request to transmit text to serial TX line 
+        """
+        self.queueTx(byte_array, LANE_BULK)
+
+    @pyqtSlot(bytes)
+    def on_sendLineRequest(self, byte_array: bytes):
+        """ 
+        Request to transmit a line of text to serial TX line 
+        Terminate the text with eol characters.
+        This is used for commands typed by the user, they are transmitted ahead of other data.
+        When framing is active the text is sent as one packet.
+        """
+        if self.framer is not None:
+            self.queueTx(self.framer.encode(byte_array), LANE_INTERACTIVE)
+        else:
+            self.queueTx(byte_array + self.PSer.eol, LANE_INTERACTIVE)
+
+    @pyqtSlot(list)
+    def on_sendLinesRequest(self, lines: list):
+        """ 
+        Request to transmit multiple lines of text to serial TX line
+        """
+        self.queueTx(self.PSer.eol.join(lines) + self.PSer.eol, LANE_BULK)
+
+    def queueTx(self, byte_array: bytes, lane: int):
+        """ queue data and start transmitting it """
+        if self.PSer.ser_open:
+            self.txQueue.put(byte_array, lane)
+            self.on_txTimer()                                                              # transmit what is allowed right away
+        else:
+            self.logger.log(logging.ERROR, "[{}]: Tx, port not opened.".format(int(QThread.currentThreadId())))
+
+    @pyqtSlot(float, bool)
+    def on_changeTxRateRequest(self, rate: float, lines: bool):
+        """ 
+        Request to limit transmission to rate bytes/s or lines/s, 0 is as fast as the port allows
+        """
+        self.txBucket.setRate(rate, lines)
+        self.logger.log(logging.INFO, "[{}]: Transmit rate limited to {} {}.".format(
+            int(QThread.currentThreadId()), rate, "lines/s" if lines else "bytes/s"))
+
+    def txDrainTime(self) -> float:
+        """ [s] time to transmit queued data and rest of file """
+        bytesPerSecond = self.PSer.baud/10. if self.PSer.ser_open else 0.
+        if self.txBucket.rate > 0 and not self.txBucket.lines:
+            bytesPerSecond = min(bytesPerSecond, self.txBucket.rate)
+        linesPerSecond = self.txBucket.rate if self.txBucket.lines else 0.
+        return self.txQueue.drainTime(bytesPerSecond, linesPerSecond, self.txFileSize - self.txFileRead)
+
+    @pyqtSlot(str)
+    def on_sendFileRequest(self, fname: str):
+        """ 
+        Request to transmit file to serial TX line 
+
+        The file is not loaded into memory, the transmitter timer reads it in chunks and
+        hands them to the port at the rate the baud rate and transmit buffer allow,
+        so that the receiver keeps running while a large file is sent.
+        """
+        # if DEBUGPY_ENABLED: debugpy.debug_this_thread()
+        
+        if not self.PSer.ser_open:
+            self.logger.log(logging.ERROR, "[{}]: Tx, port not opened.".format(int(QThread.currentThreadId())))
+            self.fileTransferFinished.emit(False)
+        elif not fname:
+            self.logger.log(logging.WARNING, "[{}]: No file name provided.".format(int(QThread.currentThreadId())))        
+            self.fileTransferFinished.emit(False)
+        elif self.txFile is not None or self.upload is not None:
+            self.logger.log(logging.WARNING, "[{}]: File transfer already in progress.".format(int(QThread.currentThreadId())))        
+        else:
+            try: 
+                self.txFile = open(fname, 'rb') # open file in binary read mode
+                self.txFileSize = os.path.getsize(fname)
+            except OSError:
+                self.txFile = None
+                self.logger.log(logging.ERROR, "[{}]: Error opening \"{}\".".format(int(QThread.currentThreadId()),fname))
+                self.fileTransferFinished.emit(False)
+                return
+            self.txFileSent     = 0
+            self.txFileRead     = 0
+            self.txStartTime    = time.perf_counter()
+            self.txLastTime     = self.txStartTime
+            self.txLastProgress = self.txStartTime
+            self.txTimer.start()
+            self.logger.log(logging.INFO, "[{}]: Transmitting \"{}\" [{}].".format(int(QThread.currentThreadId()),fname, self.txFileSize))
+
+    @pyqtSlot()
+    def on_cancelSendFileRequest(self):
+        """ 
+        Request to stop transmitting file
+        """
+        if self.txFile is not None:
+            self.finishFileTransfer(False)
+            self.logger.log(logging.INFO, "[{}]: File transfer cancelled after {} bytes.".format(int(QThread.currentThreadId()), self.txFileSent))
+        if self.upload is not None:
+            self.upload.cancel()
+            self.on_uploadTimer()                                                          # notify receiver and finish
+
+    @pyqtSlot(int)
+    def on_changeTxChunkSizeRequest(self, chunkSize: int):
+        """ 
+        Request to change size of the chunks a file is read and transmitted with
+        """
+        if chunkSize > 0:
+            self.txChunkSize = chunkSize
+            self.logger.log(logging.INFO, "[{}]: File transfer chunk size {}.".format(int(QThread.currentThreadId()), chunkSize))
+        else:
+            self.logger.log(logging.WARNING, "[{}]: Range error, chunk size not changed to {}.".format(int(QThread.currentThreadId()), chunkSize))
+
+    @pyqtSlot()
+    def on_txTimer(self):
+        """
+        Transmit queued data and next part of the file
+
+        The number of bytes handed to the port is limited by
+          the time since the last call at the current baud rate (10 bits per byte)
+          the free space in the operating system transmit buffer
+          the rate limit in bytes/s or lines/s
+        Queued commands go first, then text and lines, then the file.
+        With write timeout of zero the port accepts what fits, the remainder stays queued.
+        """
+        if not self.PSer.ser_open:
+            if self.txFile is not None:
+                self.logger.log(logging.ERROR, "[{}]: Tx, port closed during file transfer.".format(int(QThread.currentThreadId())))
+                self.finishFileTransfer(False)
+            self.txQueue.clear()
+            self.txTimer.stop()
+            return
+
+        now = time.perf_counter()
+        dt = min(now - self.txLastTime, 4*TX_INTERVAL/1000.)                               # do not catch up after long pauses
+        self.txLastTime = now
+        budget = min(ceil(self.PSer.baud/10.*dt), TX_BUFFER_SIZE - self.PSer.txWaiting)
+        if self.PSer.flowControl == "DSR/DTR" and not self.PSer.dsrReady():
+            budget = 0                                                                     # device is not ready, RTS/CTS and XON/XOFF are handled by the driver
+        sent, lines = 0, 0
+
+        while budget > 0:
+            if self.txFile is not None and self.txQueue.numBytes[LANE_FILE] == 0:
+                # refill file lane
+                chunk = self.txFile.read(self.txChunkSize)
+                self.txFileRead += len(chunk)
+                self.txQueue.put(chunk, LANE_FILE)
+            tokens = self.txBucket.available(now)
+            if self.txBucket.lines:
+                data, lane = self.txQueue.get(budget, tokens)
+            else:
+                data, lane = self.txQueue.get(int(min(budget, tokens)))
+            if not data:
+                break                                                                      # queue empty or rate limit reached
+            l = self.PSer.write(data)
+            self.txQueue.unget(data[l:], lane)
+            if l <= 0:
+                break                                                                      # port is busy, try again next time
+            n = self.txQueue.count(data[:l])
+            self.txBucket.consume(n if self.txBucket.lines else l)
+            if lane == LANE_FILE:
+                self.txFileSent += l
+            budget -= l
+            sent   += l
+            lines  += n
+
+        if sent:
+            STAGE_TX.queue = self.txQueue.numItems
+            STAGE_TX.add(lines=lines, nbytes=sent)
+
+        if self.txFile is not None:
+            if self.txFileRead >= self.txFileSize and self.txQueue.numBytes[LANE_FILE] == 0:
+                self.finishFileTransfer(True)
+            elif now - self.txLastProgress >= PROGRESS_INTERVAL:
+                self.txLastProgress = now
+                self.fileProgressReady.emit(self.txFileSent, self.txFileSize, self.txFileSent/(now - self.txStartTime))
+
+        if self.txQueue or self.txFile is not None:
+            if not self.txTimer.isActive(): self.txTimer.start()
+        else:
+            self.txTimer.stop()
+
+    @pyqtSlot(str)
+    def on_startMacroRequest(self, text: str):
+        """
+        Request to run a macro, see Macro_helper for the steps
+        """
+        if not self.PSer.ser_open:
+            self.logger.log(logging.ERROR, "[{}]: Macro, port not opened.".format(int(QThread.currentThreadId())))
+            self.macroStateChanged.emit(False, "not started, port not opened")
+            return
+        if self.macro is not None:
+            self.logger.log(logging.WARNING, "[{}]: Macro already running.".format(int(QThread.currentThreadId())))
+            return
+        try:
+            self.macro = MacroRunner(text, send=self.sendMacro)
+        except ValueError as e:
+            self.logger.log(logging.ERROR, "[{}]: Macro error {}.".format(int(QThread.currentThreadId()), e))
+            self.macroStateChanged.emit(False, "error {}".format(e))
+            return
+        self.macro.start()
+        self.macroStateChanged.emit(True, "running")
+        self.logger.log(logging.INFO, "[{}]: Started macro with {} steps.".format(int(QThread.currentThreadId()), len(self.macro.steps)))
+        self.on_macroTimer()
+
+    @pyqtSlot()
+    def on_stopMacroRequest(self):
+        """
+        Request to stop the macro
+        """
+        if self.macro is not None:
+            self.macro.stop("stopped")
+            self.finishMacro()
+
+    def sendMacro(self, byte_array: bytes, eol: bool):
+        """ macro step transmits data, lateness is recorded in macro stage """
+        STAGE_MACRO.add(lines=1, nbytes=len(byte_array), ns=int((time.perf_counter() - self.macro.deadline)*1e9))
+        self.queueTx(byte_array + self.PSer.eol if eol else byte_array, LANE_BULK)
+
+    @pyqtSlot()
+    def on_macroTimer(self):
+        """
+        Execute macro steps that are due and schedule the next one
+
+        Steps are executed within a fraction of a millisecond of when they are due (see waitUntil).
+        Waits are added to when the previous step was due so that the schedule does not drift.
+        After MACRO_SLICE the event loop runs so that data is received while the macro runs.
+        """
+        if self.macro is None:
+            return
+        if not self.PSer.ser_open:
+            self.macro.stop("port closed")
+        start = time.perf_counter()
+        while True:
+            due = self.macro.run(time.perf_counter())
+            if due is None:
+                self.finishMacro()
+                return
+            if time.perf_counter() - start > MACRO_SLICE:
+                self.macroTimer.start(0)
+                return
+            if not self.waitUntil(self.macroTimer, due):
+                return
+
+    @pyqtSlot(bytes, float)
+    def on_startPeriodicRequest(self, byte_array: bytes, period: float):
+        """
+        Request to send a line every period milliseconds
+        The line is sent at start + k*period, late sends do not delay the following ones.
+        """
+        if not self.PSer.ser_open:
+            self.logger.log(logging.ERROR, "[{}]: Periodic, port not opened.".format(int(QThread.currentThreadId())))
+            return
+        if period <= 0:
+            self.logger.log(logging.WARNING, "[{}]: Range error, period {} ms.".format(int(QThread.currentThreadId()), period))
+            return
+        self.periodicLine = byte_array + self.PSer.eol
+        self.periodic.start(time.perf_counter(), period/1000.)
+        self.logger.log(logging.INFO, "[{}]: Sending {} every {} ms.".format(int(QThread.currentThreadId()), repr(byte_array), period))
+        self.on_periodicTimer()
+
+    @pyqtSlot()
+    def on_stopPeriodicRequest(self):
+        """
+        Request to stop periodic sending
+        """
+        if self.periodicLine is not None:
+            self.periodicTimer.stop()
+            self.periodicLine = None
+            self.logger.log(logging.INFO, "[{}]: Stopped periodic sending after {} lines.".format(int(QThread.currentThreadId()), self.periodic.numFired))
+
+    @pyqtSlot()
+    def on_periodicTimer(self):
+        """ send line when due and schedule next one """
+        if self.periodicLine is None:
+            return
+        if not self.PSer.ser_open:
+            self.on_stopPeriodicRequest()
+            return
+        if self.waitUntil(self.periodicTimer, self.periodic.due):
+            now = time.perf_counter()
+            late = now - self.periodic.due
+            missed = self.periodic.numMissed
+            self.queueTx(self.periodicLine, LANE_INTERACTIVE)
+            self.periodic.fire(now)
+            STAGE_PERIODIC.add(lines=1, nbytes=len(self.periodicLine), ns=int(late*1e9), errors=self.periodic.numMissed - missed)
+            # return to event loop before the next line, for short periods the timer fires right away
+            self.periodicTimer.start(max(int((self.periodic.due - time.perf_counter() - SPIN_TIME)*1000), 0))
+
+    def waitUntil(self, timer: QTimer, due: float) -> bool:
+        """
+        Returns True at due if it is less than SPIN_TIME away, the remaining time is busy waited.
+        Otherwise starts the single shot timer to wake up SPIN_TIME before due and returns False.
+        """
+        delay = due - time.perf_counter()
+        if delay > SPIN_TIME:
+            timer.start(int((delay - SPIN_TIME)*1000))
+            return False
+        while time.perf_counter() < due:
+            pass
+        return True
+
+    def finishMacro(self):
+        """ report end of macro """
+        self.macroTimer.stop()
+        macro, self.macro = self.macro, None
+        message = macro.error if macro.error else "finished, sent {} commands".format(macro.numSent)
+        self.macroStateChanged.emit(False, message)
+        self.logger.log(logging.INFO if not macro.error else logging.WARNING, "[{}]: Macro {}.".format(int(QThread.currentThreadId()), message))
+
+    @pyqtSlot(str, float, int)
+    def on_changeTransactionRequest(self, reply: str, timeout: float, window: int):
+        """
+        Request to change how replies are matched
+        reply is a prefix or re:regular expression, a group named seq matches the sequence number
+        """
+        try:
+            self.transactions.configure(reply, timeout, window)
+            self.transactionTimer.stop()
+            self.logger.log(logging.INFO, "[{}]: Transactions reply {}, timeout {} ms, {} in flight.".format(
+                int(QThread.currentThreadId()), reply, timeout, window))
+        except re.error as e:
+            self.logger.log(logging.ERROR, "[{}]: Transactions reply {} is not valid, {}.".format(int(QThread.currentThreadId()), reply, e))
+
+    @pyqtSlot(bytes, int)
+    def on_sendTransactionRequest(self, command: bytes, count: int):
+        """
+        Request to send command count times, each waits for its reply
+        """
+        if not self.PSer.ser_open:
+            self.logger.log(logging.ERROR, "[{}]: Transactions, port not opened.".format(int(QThread.currentThreadId())))
+            return
+        if not self.transactions.busy:
+            self.transactionRest = b''
+        self.transactions.submit(command, count)
+        self.serviceTransactions([])
+
+    @pyqtSlot()
+    def on_cancelTransactionRequest(self):
+        """
+        Request to forget pending and outstanding transactions
+        """
+        self.transactions.clear()
+        self.transactionRest = b''
+        self.transactionTimer.stop()
+
+    @pyqtSlot()
+    def on_transactionTimer(self):
+        """ oldest transaction timed out """
+        self.serviceTransactions(self.transactions.expire(time.perf_counter()))
+
+    def splitReplies(self, byte_array: bytes) -> list:
+        """ lines of text received without line termination, a reply can span several reads """
+        lines = (self.transactionRest + byte_array).split(b'\n')
+        self.transactionRest = lines.pop()[-MAX_LINE_LENGTH:]
+        return [line.rstrip(b'\r') for line in lines]
+
+    def serviceTransactions(self, done: list):
+        """
+        Report completed transactions, transmit commands that fit into the window
+        and schedule timeout of the oldest transaction
+        """
+        now = time.perf_counter()
+        done += self.transactions.expire(now)
+        if done:
+            numTimeouts = sum(1 for d in done if d[3] < 0)
+            for d in done:
+                if d[3] >= 0: STAGE_TRANSACTION.latency.record(int(d[3]*1e9))
+            STAGE_TRANSACTION.add(lines=len(done) - numTimeouts, errors=numTimeouts)
+            self.transactionsReady.emit(done)
+        for command in self.transactions.ready(now):
+            if self.framer is not None:
+                self.queueTx(self.framer.encode(command), LANE_INTERACTIVE)                # one packet, each reply is a packet
+            else:
+                self.queueTx(command + (self.PSer.eol or b'\n'), LANE_INTERACTIVE)        # without termination replies are split at newline
+        if self.transactions.inFlight:
+            self.transactionTimer.start(max(ceil((self.transactions.nextDeadline - now)*1000), 0))
+        else:
+            self.transactionTimer.stop()
+            if done:
+                summary = self.transactions.summary()
+                self.transactionsFinished.emit(summary)
+                self.logger.log(logging.INFO, "[{}]: Transactions {}.".format(int(QThread.currentThreadId()), summary))
+
+    @pyqtSlot(list, str, int)
+    def on_uploadFileRequest(self, fnames: list, protocol: str, window: int):
+        """
+        Request to upload files with XMODEM-CRC, XMODEM-1K or YMODEM (several files)
+        The receiver has to start the transfer within a minute.
+        """
+        if not self.PSer.ser_open:
+            self.logger.log(logging.ERROR, "[{}]: Upload, port not opened.".format(int(QThread.currentThreadId())))
+            self.fileTransferFinished.emit(False)
+            return
+        if self.txFile is not None or self.upload is not None:
+            self.logger.log(logging.WARNING, "[{}]: File transfer already in progress.".format(int(QThread.currentThreadId())))
+            return
+        try:
+            files = []
+            for fname in fnames:
+                with open(fname, 'rb') as f:
+                    files.append((os.path.basename(fname), f.read()))
+            self.upload = XmodemSender(files, protocol, window)
+        except (OSError, ValueError) as e:
+            self.logger.log(logging.ERROR, "[{}]: Upload not started, {}.".format(int(QThread.currentThreadId()), e))
+            self.fileTransferFinished.emit(False)
+            return
+        self.txStartTime    = time.perf_counter()
+        self.txLastProgress = self.txStartTime
+        self.uploadSent, self.uploadRetries = 0, 0
+        self.PSer.read()                                                                   # discard what was received before
+        self.updateRxNotifier()                                                            # upload timer reads the port
+        self.uploadTimer.start()
+        self.logger.log(logging.INFO, "[{}]: {} upload of {} bytes in {} files, waiting for receiver.".format(
+            int(QThread.currentThreadId()), protocol, self.upload.total, len(files)))
+
+    @pyqtSlot()
+    def on_uploadTimer(self):
+        """
+        Pass received bytes to the protocol and transmit its blocks
+        """
+        upload = self.upload
+        if upload is None:
+            self.uploadTimer.stop()
+            return
+        now = time.perf_counter()
+        if self.PSer.ser_open:
+            upload.feed(self.PSer.read(), now)
+            out = upload.poll(now)
+            if out:
+                self.queueTx(out, LANE_INTERACTIVE)
+        elif not upload.finished:
+            upload.cancel()
+            upload.error = "port closed"
+        if upload.sent != self.uploadSent or upload.numRetries != self.uploadRetries:
+            STAGE_UPLOAD.add(nbytes=upload.sent - self.uploadSent, errors=upload.numRetries - self.uploadRetries)
+            self.uploadSent, self.uploadRetries = upload.sent, upload.numRetries
+        if upload.finished:
+            self.uploadTimer.stop()
+            self.upload = None
+            self.updateRxNotifier()
+            duration = now - self.txStartTime
+            self.fileProgressReady.emit(upload.sent, upload.total, upload.sent/duration if duration > 0 else 0.)
+            self.fileTransferFinished.emit(upload.success)
+            self.logger.log(logging.INFO if upload.success else logging.ERROR, "[{}]: Upload {}, {} bytes in {:.2f} s, {} retries.".format(
+                int(QThread.currentThreadId()), "completed" if upload.success else "failed, " + upload.error, upload.sent, duration, upload.numRetries))
+        elif now - self.txLastProgress >= PROGRESS_INTERVAL and upload.sent > 0:
+            self.txLastProgress = now
+            self.fileProgressReady.emit(upload.sent, upload.total, upload.sent/(now - self.txStartTime))
+
+    def finishFileTransfer(self, completed: bool):
+        """ close file and report result """
+        self.txFile.close()
+        self.txFile = None
+        self.txQueue.clear(LANE_FILE)
+        self.txFileRead = self.txFileSize
+        duration = time.perf_counter() - self.txStartTime
+        self.fileProgressReady.emit(self.txFileSent, self.txFileSize, self.txFileSent/duration if duration > 0 else 0.)
+        self.fileTransferFinished.emit(completed)
+        if completed:
+            self.logger.log(logging.INFO, "[{}]: Transmitted {} bytes in {:.2f} s.".format(int(QThread.currentThreadId()), self.txFileSent, duration))
+
+    @pyqtSlot(str, int)
+    def on_changePortRequest(self, port: str, baud: int):
+        """ 
+        Request to change port received 
+        """
+        self.forgetLostPort()
+        self.PSer.close()
+        self.updateRxNotifier()
+        if port != "":
+            serialReadTimeOut, receiverInterval, receiverIntervalStandby = compute_timeouts(baud)
+            if self.PSer.open(port=port, baud=baud, eol=self.textLineTerminator, timeout=serialReadTimeOut):
+                if self.hotplug is not None and self.hotplug.follow(port) and self.hotplug.fileno < 0:
+                    self.hotplugTimer.start(HOTPLUG_POLL)
+                self.serialReadTimeOut = serialReadTimeOut
+                self.receiverInterval = receiverInterval 
+                self.receiverIntervalStandby = receiverIntervalStandby
+                self.receiverTimer.setInterval(self.receiverInterval) 
+                self.updateRxNotifier()
+                self.logger.log(logging.INFO, "[{}]: Port {} opened with eol {} and timeout {}.".format(
+                    int(QThread.currentThreadId()), port, repr(self.textLineTerminator), self.PSer.timeout))
+            else:
+                self.logger.log(logging.ERROR, "[{}]: Failed to open port {}.".format(int(QThread.currentThreadId()), port))
+
+    @pyqtSlot()
+    def on_closePortRequest(self):
+        """ 
+        Request to close port received 
+        """
+        self.forgetLostPort()
+        self.PSer.close()
+        self.updateRxNotifier()
+
+    @pyqtSlot(bool)
+    def on_changeReconnectRequest(self, enabled: bool):
+        """
+        Reopen a port that vanished when a device with the same serial number appears
+        """
+        self.autoReconnect = enabled
+        if not enabled:
+            self.forgetLostPort()
+        self.logger.log(logging.INFO, "[{}]: Auto reconnect {}.".format(int(QThread.currentThreadId()), "on" if enabled else "off"))
+
+    @pyqtSlot(str)
+    def on_changeFlowControlRequest(self, kind: str):
+        """
+        Flow control of the open port and of ports opened later
+        """
+        if kind not in FLOW_CONTROLS:
+            self.logger.log(logging.ERROR, "[{}]: Unknown flow control {}.".format(int(QThread.currentThreadId()), kind))
+            return
+        self.PSer.flowControl = kind
+        self.logger.log(logging.INFO, "[{}]: Flow control {}.".format(int(QThread.currentThreadId()), kind))
+
+    @pyqtSlot(bool, int, int)
+    def on_changeLatencyRequest(self, lowLatency: bool, chunk: int, vmin: int):
+        """
+        Standard or low latency port profile, applied to the open port and when a port is opened
+        Low latency reads as soon as VMIN bytes are waiting, fewer bytes at the end of a burst
+        are read by the receiver timer
+        """
+        self.lowLatency      = lowLatency
+        self.PSer.lowLatency = lowLatency
+        self.PSer.readChunk  = max(chunk, 0)
+        self.PSer.vmin       = min(max(vmin, 1), 255)
+        self.txTimer.setInterval(LOW_LATENCY_TX_INTERVAL if lowLatency else TX_INTERVAL)  # remainder of a command beyond the baud rate budget
+        applied = self.PSer.tune()
+        self.updateRxNotifier()
+        self.logger.log(logging.INFO, "[{}]: Port profile {}, read chunk {}, {}.".format(int(QThread.currentThreadId()),
+            "low latency" if lowLatency else "standard", self.PSer.readChunk or "all", ", ".join(applied) if applied else ("nothing to tune" if self.PSer.ser_open else "applied when port opens")))
+
+    def updateRxNotifier(self):
+        """
+        Low latency profile: read when the port becomes readable instead of waiting for the receiver timer,
+        the timer keeps running at its interval. Call after the port was opened or closed, the notifier
+        belongs to the file descriptor.
+        """
+        wanted = (self.lowLatency and self.PSer.ser_open and self.upload is None and not self.rxThrottled
+                  and self.serialReceiverState != SerialReceiverState.stopped
+                  and termios is not None)                                                 # POSIX, port is a file descriptor
+        if self.rxNotifier is not None:
+            if wanted and self.rxNotifier.socket() == self.PSer.ser.fileno():
+                return
+            self.rxNotifier.setEnabled(False)
+            self.rxNotifier.deleteLater()
+            self.rxNotifier = None
+        if wanted:
+            self.rxNotifier = QSocketNotifier(self.PSer.ser.fileno(), QSocketNotifier.Read, self)
+            self.rxNotifier.activated.connect(self.updateReceiver)
+
+    def closeLostPort(self, reason: str):
+        """
+        Port vanished, close it and wait for it to reappear
+        """
+        if self.lostPort or not self.PSer.ser_open:
+            return
+        self.lostPort       = self.PSer.port
+        self.lostBaud       = self.PSer.baud
+        self.resumeReceiver = self.receiverTimer.isActive()
+        self.receiverTimer.stop()
+        self.PSer.close()
+        self.updateRxNotifier()
+        self.logger.log(logging.WARNING, "[{}]: Port {} lost: {}.".format(int(QThread.currentThreadId()), self.lostPort, reason))
+        self.portLost.emit(self.lostPort)
+        if self.autoReconnect and self.hotplug.device:
+            self.hotplug.lost(time.perf_counter())
+            self.hotplugTimer.start(HOTPLUG_RETRY)
+        else:
+            self.forgetLostPort()                                                          # not a hot plug device, stays closed
+            self.serialWorkerStateChanged.emit(False)
+            self.on_serialStatusRequest()
+
+    def forgetLostPort(self):
+        """ user closed or changed port, do not reconnect """
+        self.lostPort = ""
+        self.resumeReceiver = False
+        if self.hotplug is not None:
+            self.hotplug.forget()
+            self.hotplugTimer.stop()
+
+    @pyqtSlot()
+    def on_hotplugEvent(self):
+        """
+        Device directory changed or timer, reopen lost port with previous settings
+        """
+        event, device = self.hotplug.check(time.perf_counter())
+        if event == "lost":
+            self.closeLostPort("removed")
+        elif event == "back" and self.lostPort and self.autoReconnect:
+            serialReadTimeOut, receiverInterval, receiverIntervalStandby = compute_timeouts(self.lostBaud)
+            if not self.PSer.open(port=device, baud=self.lostBaud, eol=self.textLineTerminator, timeout=serialReadTimeOut):
+                self.hotplug.failed(time.perf_counter())                                   # e.g. permissions not yet set, retry after next change
+                return
+            latency = self.hotplug.reconnected(time.perf_counter())
+            self.hotplugTimer.stop()
+            if self.hotplug.fileno < 0: self.hotplugTimer.start(HOTPLUG_POLL)
+            self.serialReadTimeOut = serialReadTimeOut
+            self.receiverInterval = receiverInterval
+            self.receiverIntervalStandby = receiverIntervalStandby
+            self.receiverTimer.setInterval(self.receiverInterval)
+            if self.framer is not None: self.framer.reset()
+            self.lostPort = ""
+            if self.resumeReceiver:
+                self.on_startReceiverRequest()
+            self.logger.log(logging.INFO, "[{}]: Port {} reconnected after {:.0f} ms.".format(int(QThread.currentThreadId()), device, latency*1000))
+            self.on_scanPortsRequest()                                                     # name might have changed
+            self.on_serialStatusRequest()
+            self.portReconnected.emit(device, latency)
+
+    @pyqtSlot(int)
+    def on_changeBaudRateRequest(self, baud: int):
+        """ 
+        New baudrate received 
+        Any rate can be requested, the port is changed in place and reports the rate the driver achieved
+        """
+        if (baud is None) or (baud <= 0):
+            self.logger.log(logging.WARNING, "[{}]: Range error, baudrate not changed to {},".format(int(QThread.currentThreadId()), baud))
+        else:                
+            if self.PSer.ser_open:
+                self.PSer.baud = baud                                                      # logs failure, keeps previous rate
+                if abs(self.PSer.baud - baud) <= BAUD_TOLERANCE*baud: # check if new value matches desired value
+                    serialReadTimeOut, receiverInterval, receiverIntervalStandby = compute_timeouts(self.PSer.baud)
+                    self.serialReadTimeOut = serialReadTimeOut
+                    self.receiverInterval = receiverInterval
+                    self.receiverIntervalStandby = receiverIntervalStandby
+                    self.receiverTimer.setInterval(self.receiverInterval) 
+                    self.logger.log(logging.INFO, "[{}]: Baudrate {}, achieved {}.".format(int(QThread.currentThreadId()), baud, self.PSer.baud))
+                else:
+                    self.logger.log(logging.ERROR, "[{}]: Failed to set baudrate to {}, port is at {}.".format(int(QThread.currentThreadId()), baud, self.PSer.baud))
+                self.on_serialStatusRequest()                                              # user interface shows achieved rate
+            else:
+                self.logger.log(logging.ERROR, "[{}]: Failed to set baudrate, serial port not open!".format(int(QThread.currentThreadId())))
+            
+    @pyqtSlot(bytes)
+    def on_changeLineTerminationRequest(self, lineTermination: bytes):
+        """ 
+        New LineTermination received
+        """
+        if (lineTermination is None):
+            self.logger.log(logging.WARNING, "[{}]: Line termination not changed, line termination string not provided.".format(int(QThread.currentThreadId())))
+            return
+        else:            
+            self.PSer.eol = lineTermination
+            self.textLineTerminator = self.PSer.eol
+            self.txQueue.eol = self.PSer.eol
+            self.logger.log(logging.INFO, "[{}]: Changed line termination to {}.".format(int(QThread.currentThreadId()), repr(self.textLineTerminator)))
+
+    @pyqtSlot(str)
+    def on_changeFramingRequest(self, framing: str):
+        """ 
+        Receive COBS or SLIP framed binary packets instead of lines or text
+        """
+        try:
+            self.framer = FrameDecoder(framing) if framing else None
+            self.logger.log(logging.INFO, "[{}]: Changed framing to {}.".format(int(QThread.currentThreadId()), framing or "none"))
+        except ValueError as e:
+            self.framer = None
+            self.logger.log(logging.ERROR, "[{}]: {}.".format(int(QThread.currentThreadId()), e))
+
+    @pyqtSlot(str)
+    def on_changeLineChecksumRequest(self, kind: str):
+        """ 
+        Validate checksum at end of each line, lines that fail are dropped
+        """
+        self.PSer.lineChecksum = kind if kind in LINE_CHECKSUMS.values() else ""
+        self.PSer.numChecksumErrors = 0
+        self.logger.log(logging.INFO, "[{}]: Changed line checksum to {}.".format(int(QThread.currentThreadId()), self.PSer.lineChecksum or "none"))
+
+    @pyqtSlot()
+    def on_scanPortsRequest(self):
+        """ 
+        Request to scan for serial ports received 
+        """            
+        if self.PSer.scanports() > 0 :
+            self.serialPorts =     [sublist[0] for sublist in self.PSer.ports]
+            self.serialPortNames = [sublist[1] for sublist in self.PSer.ports]
+        else :
+            self.serialPorts = []
+            self.serialPortNames = []        
+        self.logger.log(logging.INFO, "[{}]: Port(s) {} available.".format(int(QThread.currentThreadId()),self.serialPortNames))
+        self.newPortListReady.emit(self.serialPorts, self.serialPortNames)
+        
+    @pyqtSlot()
+    def on_scanBaudRatesRequest(self):
+        """ 
+        Request to report serial baud rates received 
+        """
+        if self.PSer.ser_open:
+            self.serialBaudRates = self.PSer.baudrates
+        else:
+            self.serialBaudRates = ()
+        if len(self.serialBaudRates) > 0:
+            self.logger.log(logging.INFO, "[{}]: Baudrate(s) {} available.".format(int(QThread.currentThreadId()),self.serialBaudRates))
+        else:
+            self.logger.log(logging.WARNING, "[{}]: No baudrates available, port is closed.".format(int(QThread.currentThreadId())))
+        self.newBaudListReady.emit(self.serialBaudRates)
+
+    @pyqtSlot()
+    def on_autobaudRequest(self):
+        """
+        Score a short window of received data at each baud rate and switch to the best one
+        Blocks the worker for less than a second, the receiver is serviced afterwards
+        """
+        if not self.PSer.ser_open:
+            self.logger.log(logging.WARNING, "[{}]: Baud rate not detected, port is closed.".format(int(QThread.currentThreadId())))
+            return
+        tic = time.perf_counter()
+        current = self.PSer.baud
+        scores = self.PSer.autobaud([baud for baud in self.PSer.baudrates if baud >= AUTOBAUD_MIN_BAUD])
+        baud = best_baud(scores, current)
+        toc = time.perf_counter()
+        if baud != current:
+            serialReadTimeOut, receiverInterval, receiverIntervalStandby = compute_timeouts(baud)
+            self.PSer.baud = baud                                                          # changes rate of open port, no reopen
+            self.serialReadTimeOut = serialReadTimeOut
+            self.receiverInterval = receiverInterval
+            self.receiverIntervalStandby = receiverIntervalStandby
+            self.receiverTimer.setInterval(self.receiverInterval)
+        self.PSer.partialLine, self.PSer.havePartialLine = b'', False                      # bytes received at other rates
+        self.logger.log(logging.INFO, "[{}]: Baud rate {} score {:.2f}, scanned {} rates in {:.0f} ms.".format(
+            int(QThread.currentThreadId()), baud, scores.get(baud, -1.), len(scores), (toc - tic)*1000))
+        self.on_serialStatusRequest()
+        self.autobaudFinished.emit(self.PSer.baud, float(max(scores.get(baud, -1.), -1.)))
+
+    @pyqtSlot()
+    def on_serialStatusRequest(self):
+        """ 
+        Request to report serial port and baudrate received
+        """
+        self.logger.log(logging.INFO, "[{}]: Provided serial status".format(int(QThread.currentThreadId())))
+        if self.PSer.ser_open:
+            self.serialStatusReady.emit(self.PSer.port, self.PSer.baud, self.PSer.eol, self.PSer.timeout)
+        else:
+            self.serialStatusReady.emit("", self.PSer.baud, self.PSer.eol, self.PSer.timeout)
+
+def compute_timeouts(baud: int):
+    # Set timeout to the amount of time it takes to receive the shortest expected line of text
+    # integer '123/n/r' 5 bytes, which is at least 45 serial bits
+    # serialReadTimeOut = 40 / baud [s] is very small and we should imply make it by just setting it to zero (non blocking)
+    serialReadTimeOut = 0 # make it non blocking        
+    
+    # Set the QTimer interval so that each call we get a couple of lines
+    # lets assume we receive 4 integers in one line, this is approx 32 bytes, 10 serial bits per byte
+    # lets request NUM_LINES_COLLATE lines per call 
+    receiverInterval  = ceil(NUM_LINES_COLLATE * 32 * 10 / baud * 1000)  # in milliseconds
+    # check serial should occur no more than 200 times per second no less than 10 times per second
+    if receiverInterval < MIN_RECEIVER_INTERVAL: receiverInterval = MIN_RECEIVER_INTERVAL # set maximum to 100 Hz
+    if receiverInterval > MAX_RECEIVER_INTERVAL: receiverInterval = MAX_RECEIVER_INTERVAL # slow rates, e.g. 300 baud
+    # above about 4 Mbaud half the receive buffer fills faster than MIN_RECEIVER_INTERVAL, one read returns at most the buffer
+    bufferInterval = int(RX_BUFFER_SIZE / 2 * 10 / baud * 1000)
+    if receiverInterval > bufferInterval: receiverInterval = max(bufferInterval, 1)
+    receiverIntervalStandby  = 10 * receiverInterval # make standby 10 times slower
+    if receiverIntervalStandby > MAX_RECEIVER_INTERVAL: # 
+        receiverIntervalStandby = max(MAX_RECEIVER_INTERVAL, receiverInterval) # but check at least 10 times per second
+    
+    return serialReadTimeOut, receiverInterval, receiverIntervalStandby
+
+def latency_timer(port: str) -> str:
+    """ sysfs latency timer of FTDI adapter, "" for other ports """
+    path = "/sys/bus/usb-serial/devices/{}/latency_timer".format(os.path.basename(os.path.realpath(port)))
+    return path if os.path.exists(path) else ""
+
+################################################################################
+# Serial Low Level 
+################################################################################
+
+class PSerial():
+    """
+    Serial Wrapper.
+    
+    read returns bytes or list of bytes
+    write expects bytes or list of bytes
+    """
+    
+    def __init__(self):
+        # if DEBUGPY_ENABLED: debugpy.debug_this_thread() # this should enable debugging of all PSerial methods
+            
+        self.logger = logging.getLogger("PSerial")           
+        self.ser = None
+        self._port = ""
+        self._baud = -1
+        self._eol = ""
+        self._timeout = -1
+        self.ser_open = False
+        self.totalCharsReceived = 0
+        self.totalCharsSent = 0
+        self.partialLine = b''
+        self.havePartialLine = False
+        self.lineChecksum = ""                                                             # "xor", "crc8", "crc16" or "" for none
+        self.numChecksumErrors = 0
+        self.lowLatency = False                                                            # port profile, see tune
+        self.readChunk = 0                                                                 # [bytes] read at most this much per call, 0 for all waiting
+        self.vmin = LOW_LATENCY_VMIN
+        self.tuned = False                                                                 # low latency settings were applied to the open port
+        self._flowControl = "none"                                                         # one of FLOW_CONTROLS
+        # check for serial ports
+        _ = self.scanports()
+    
+    def scanports(self) -> int:
+        """ 
+        scans for all available ports 
+        """
+        self._ports = [
+            [p.device, p.description]
+            for p in list_ports.comports()
+        ]
+        return len(self._ports)
+
+    def open(self, port: str, baud: int, eol: bytes, timeout: float) -> bool:
+        """ open specified port """
+        try:       
+            self.ser = sp(
+                port = port,                    # the serial device
+                baudrate = baud,                # often 115200 but Teensy sends/receives as fast as possible
+                bytesize = EIGHTBITS,           # most common option
+                parity = PARITY_NONE,           # most common option
+                stopbits = STOPBITS_ONE,        # most common option
+                timeout = timeout,              # wait until requested characters are received on read request or timeout occurs
+                write_timeout = timeout,        # wait until requested characters are sent
+                inter_byte_timeout = None,      # disable inter character timeout
+                rtscts = self._flowControl == "RTS/CTS",   # 'request to send' and 'clear to send' handshaking
+                dsrdtr = self._flowControl == "DSR/DTR",   # 'data set ready' signaling, on POSIX QSerial drives DTR
+                exclusive = None,               # do not share port in POSIX
+                xonxoff = self._flowControl == "XON/XOFF", # 'xon/xoff' hand shaking in serial data stream
+                )
+        except: 
+            self.ser_open = False
+            self.ser = None
+            self._port=""
+            self.logger.log(logging.ERROR, "[SER {}]: Failed to open port {}.".format(int(QThread.currentThreadId()),port))
+            return False
+        else: 
+            self.ser_open = True
+            self._baud = self.achievedBaud()
+            self.logger.log(logging.DEBUG, "[SER {}]: {} opened with baud {}, achieved {}.".format(int(QThread.currentThreadId()), port, baud, self._baud))
+            self._port = port
+            self._timeout = timeout
+            self._eol = eol
+            self._leneol = len(eol)
+            # clear buffers
+            self.ser.reset_input_buffer()
+            self.ser.reset_output_buffer()
+            self.totalCharsReceived = 0
+            self.totalCharsSent = 0
+            self.tuned = False
+            applied = self.tune()
+            if applied:
+                self.logger.log(logging.INFO, "[SER {}]: {} low latency, {}.".format(int(QThread.currentThreadId()), port, ", ".join(applied)))
+            return True
+        
+    def close(self):
+        """ 
+        closes serial port 
+        
+        we have issue in closing textIOwrapped serial port, somehow it claims to be already closed
+        """
+        
+        if (self.ser is not None):
+            # close the port
+            try:
+            # clear buffers
+                self.ser.reset_input_buffer()
+                self.ser.reset_output_buffer()
+                self.ser.close()
+            except:
+                # self.logger.log(logging.ERROR, "[SER {}]: failed to complete closure.".format(int(QThread.currentThreadId())))                      
+                pass
+            self._port = ""
+        self.logger.log(logging.INFO, "[SER {}]: Closed.".format(int(QThread.currentThreadId())))
+        self.ser_open = False
+            
+    def changeport(self, port: str, baud: int, eol: bytes, timeout: float):
+        """ switch to different port """
+        self.close()
+        self.open(port=port, baud=baud, eol=eol, timeout=timeout ) # open also clears the buffers
+        self.logger.log(logging.INFO, "[SER {}]: Changed port to {} with baud {} and eol {}".format(int(QThread.currentThreadId()),port,baud,repr(eol)))
+    
+    def achievedBaud(self) -> int:
+        """
+        Baud rate the driver set. pyserial requests rates without B constant with termios2 BOTHER,
+        the driver stores the rate it could generate in c_ospeed, e.g. a divider of the adapter clock.
+        Other systems return the requested rate.
+        """
+        if fcntl is not None and sys.platform.startswith("linux"):
+            buf = array.array('i', [0] * 64)                                               # struct termios2, c_ospeed is 11th int
+            try:
+                fcntl.ioctl(self.ser.fd, TCGETS2, buf)
+                if buf[10] > 0:
+                    return buf[10]
+            except (OSError, AttributeError) as e:
+                self.logger.log(logging.DEBUG, "[SER {}]: Baud rate not read back: {}.".format(int(QThread.currentThreadId()), e))
+        return self.ser.baudrate
+
+    def tune(self) -> list:
+        """
+        Apply the port profile to the open port, returns the settings that took effect
+        
+        Low latency
+          ASYNC_LOW_LATENCY  Linux serial drivers push received bytes to the reader right away,
+                             the FTDI driver also sets the adapter latency timer to 1 ms
+          latency_timer      FTDI adapters hold bytes up to 16 ms to fill a USB packet, set in sysfs
+                             when writable, e.g. with a udev rule
+          VMIN               POSIX, poll reports the port readable once VMIN bytes arrived. VTIME is 0,
+                             with an inter byte timer poll reports a single byte, and reads of the
+                             non blocking port return what is waiting without using either value
+        Standard restores driver defaults if low latency was applied.
+        Settings a port does not have are skipped, a pty has none of them.
+        """
+        applied = []
+        if not self.ser_open or (not self.lowLatency and not self.tuned):
+            return applied
+        try:
+            self.ser.set_low_latency_mode(self.lowLatency)                                 # TIOCGSERIAL/TIOCSSERIAL ioctl
+            applied.append("ASYNC_LOW_LATENCY {}".format("set" if self.lowLatency else "cleared"))
+        except (AttributeError, ValueError) as e:                                          # not Linux, or no serial_struct
+            self.logger.log(logging.DEBUG, "[SER {}]: ASYNC_LOW_LATENCY not available: {}.".format(int(QThread.currentThreadId()), e))
+        timer = latency_timer(self._port)
+        if timer:
+            try:
+                with open(timer, 'w') as f:
+                    f.write(str(LOW_LATENCY_TIMER if self.lowLatency else DEFAULT_LATENCY_TIMER))
+                applied.append("latency timer {} ms".format(LOW_LATENCY_TIMER if self.lowLatency else DEFAULT_LATENCY_TIMER))
+            except OSError as e:
+                self.logger.log(logging.DEBUG, "[SER {}]: Latency timer not changed: {}.".format(int(QThread.currentThreadId()), e))
+        if termios is not None:
+            try:
+                attributes = termios.tcgetattr(self.ser.fd)
+                vmin = self.vmin if self.lowLatency else 0                                 # pyserial uses 0, 0 without inter byte timeout
+                attributes[6][termios.VMIN], attributes[6][termios.VTIME] = vmin, 0
+                termios.tcsetattr(self.ser.fd, termios.TCSANOW, attributes)
+                applied.append("VMIN {}".format(vmin))
+            except (AttributeError, termios.error) as e:
+                self.logger.log(logging.DEBUG, "[SER {}]: VMIN not set: {}.".format(int(QThread.currentThreadId()), e))
+        self.tuned = self.lowLatency
+        return applied
+
+    def autobaud(self, candidates, window: float = AUTOBAUD_WINDOW) -> dict:
+        """
+        Receive at each candidate baud rate and score the bytes, returns baud: score
+        The rate of the open port is changed in place, closing and reopening would take longer
+        and might reset the device. The port is left at its original rate.
+        """
+        scores = {}
+        for baud in candidates:
+            try:
+                self.ser.baudrate = baud
+                self.ser.reset_input_buffer()
+                time.sleep(max(window, AUTOBAUD_MIN_BYTES*10./baud))                       # at least AUTOBAUD_MIN_BYTES at this rate
+                data = self.ser.read(self.ser.in_waiting)
+            except (OSError, ValueError) as e:
+                self.logger.log(logging.DEBUG, "[SER {}]: Baud rate {} skipped: {}.".format(int(QThread.currentThreadId()), baud, e))
+                continue
+            self.totalCharsReceived += len(data)
+            scores[baud] = score_baud(data, self._eol)
+        try:
+            self.ser.baudrate = self._baud
+            self.ser.reset_input_buffer()
+            if self.tuned: self.tune()                                                     # changing the rate resets VMIN
+        except (OSError, ValueError) as e:
+            self.logger.log(logging.ERROR, "[SER {}]: Could not restore baud rate {}: {}.".format(int(QThread.currentThreadId()), self._baud, e))
+        return scores
+
+    def read(self) -> bytes:
+        """ reads serial buffer until empty """
+        tic = time.perf_counter_ns()
+        bytes_to_read = self.ser.in_waiting
+        if self.readChunk and bytes_to_read > self.readChunk:
+            bytes_to_read = self.readChunk                                                 # rest is read on next call
+        if bytes_to_read:
+            byte_array = self.ser.read(bytes_to_read)
+            bytes_to_read = len(byte_array)                                                # fewer when input was flushed meanwhile
+            self.totalCharsReceived += bytes_to_read
+            toc = time.perf_counter_ns()
+            STAGE_READ.add(nbytes=bytes_to_read, ns=toc-tic)
+            if tracer.enabled: tracer.record(EV_READ, tic, toc, bytes_to_read)
+            return byte_array
+        else:
+            return b''
+    
+    def readline(self) -> bytes:
+        """ 
+        reads one line of text 
+        this will not work if the read completed before reading the line termination characters
+        then the merged line will include the line termination characters
+        to avoid this the read timeout can not be set to zero or this function should not be used. 
+        """
+        tracing = tracer.enabled
+        if tracing: tic = time.perf_counter_ns()
+        line = b''
+        _line = self.ser.read_until(self._eol) # _line includes the delimiter
+        self.totalCharsReceived += len(_line)
+        if _line:
+            # received text
+            if _line.endswith(self._eol):
+                # have complete line
+                if self.havePartialLine:
+                    # merge previous partial line with current line 
+                    line = self.partialLine + _line[:-self._leneol]
+                    self.havePartialLine = False
+                    self.partialLine = b''
+                else:
+                    line = _line[:-self._leneol]
+            else:
+                # have partial line
+                self.partialLine = _line # save partial line
+                self.havePartialLine = True
+                line = b''
+        if tracing: tracer.record(EV_READLINE, tic, time.perf_counter_ns(), len(_line))
+        return line.rstrip(self._eol)
+        
+    def readlines(self) -> list:
+        """ 
+        reads serial buffer and converts it into lines of text
+        
+        1. read all bytes from the serial buffer
+        2. append them to the partial line of the previous read
+        3. find the right most location of the line termination characters,
+           also when it was split across two reads (e.g. \r at the end of one read, \n in the next)
+        4. if line termination has been found 
+           4.1 split the bytes before it into lines
+           4.2 the remainder after it becomes the new partial line
+        5. if no line termination has been found keep everything as partial line
+        """
+        # if DEBUGPY_ENABLED: debugpy.debug_this_thread() # this should enable debugging of all methods QSerial methods
+        
+        lines = []
+        
+        tic = time.perf_counter_ns()
+        bytes_to_read = self.ser.in_waiting
+        if self.readChunk and bytes_to_read > self.readChunk:
+            bytes_to_read = self.readChunk                                                 # rest is read on next call
+        if bytes_to_read:
+            byte_array = self.ser.read(bytes_to_read)
+            bytes_to_read = len(byte_array)                                                # fewer when input was flushed meanwhile
+            self.totalCharsReceived += bytes_to_read
+        if not bytes_to_read:
+            return lines # is empty list
+        toc = time.perf_counter_ns()
+        STAGE_READ.add(nbytes=bytes_to_read, ns=toc-tic)
+
+        errors = 0
+        if self.lineChecksum:
+            # validate all complete lines in one batch, lines that fail are dropped
+            data = self.partialLine + byte_array
+            idx = data.rfind(self._eol)
+            if idx == -1:
+                self.partialLine = data
+                self.havePartialLine = True
+            else:
+                e = idx + self._leneol
+                self.partialLine = data[e:]
+                self.havePartialLine = len(self.partialLine) > 0
+                lines, _, errors = check_block(data[:e], self._eol, self.lineChecksum)
+                self.numChecksumErrors += errors
+            tac = time.perf_counter_ns()
+            STAGE_FRAME.add(lines=len(lines), nbytes=bytes_to_read, ns=tac-toc, errors=errors)
+            if tracer.enabled: tracer.record(EV_READLINES, tic, tac, bytes_to_read)
+            return lines
+
+        data = self.partialLine + byte_array if self.havePartialLine else byte_array
+        idx = data.rfind(self._eol) # find end of line delimiter
+        if idx == -1:
+            # no delimiter found
+            self.partialLine = data
+            self.havePartialLine = True
+        else:
+            # delimiter found, split complete lines and keep the remainder for the next read
+            lines = data[:idx].split(self._eol) # split into list of lines, remove eol delimiter
+            self.partialLine = data[idx + self._leneol:]
+            self.havePartialLine = len(self.partialLine) > 0
+        # takes about 0.1 ms
+
+        # DEBUG
+        # indices = [index for index, line in enumerate(lines) if len(line) <= 2]
+        # if len(indices) > 0:
+        #    lines[indices]
+        
+        tac = time.perf_counter_ns()
+        STAGE_FRAME.add(lines=len(lines), nbytes=bytes_to_read, ns=tac-toc)
+        if tracer.enabled: tracer.record(EV_READLINES, tic, tac, bytes_to_read)
+        return lines
+                            
+    def write(self, byte_array: bytes) -> int:
+        """ 
+        sends an array of bytes 
+        with write timeout of zero this returns the number of bytes the port accepted
+        """
+        try:
+            l = self.ser.write(byte_array)
+            self.totalCharsSent += l
+            return l
+        except:
+            self.logger.log(logging.ERROR, "[SER {}]: Failed to write with timeout {}.".format(int(QThread.currentThreadId()), self.timeout ))
+            return 0
+
+    def writeline(self, byte_array: bytes) -> int:
+        """ sends an array of bytes + eol """
+        try:
+            l = self.ser.write(byte_array + self._eol)
+            self.totalCharsSent += l
+            return l
+        except:
+            self.logger.log(logging.ERROR, "[SER {}]: Failed to write with timeout {}.".format(int(QThread.currentThreadId()), self.timeout ))
+            return 0
+
+    def writelines(self, lines: list) -> int:
+        """ sends several lines of text, append eol to each line """
+        byte_array = self._eol.join(line for line in lines)
+        try:
+            l=self.ser.write(byte_array)
+            self.totalCharsSent += l
+            return l
+        except:
+            self.logger.log(logging.ERROR, "[SER {}]: Failed to write with timeout {}.".format(int(QThread.currentThreadId()), self.timeout ))
+            return 0
+
+    @property
+    def txWaiting(self) -> int:
+        """ number of bytes in the operating system transmit buffer """
+        try:
+            return self.ser.out_waiting
+        except:
+            return 0
+
+    def avail(self) -> int:
+        """ is there data in the serial receiving buffer? """
+        if self.ser is not None:
+            return self.ser.in_waiting
+        else:
+            return -1
+    
+    def clear(self):
+        """ 
+        clear serial buffers
+        we want to clear not flush
+        """
+        if self.ser is not None:
+            self.ser.reset_input_buffer()
+            self.ser.reset_output_buffer()
+            self.totalCharsReceived = 0
+            self.totalCharsSent = 0
+            
+    # Setting and reading internal variables
+    ########################################################################################
+        
+    @property
+    def ports(self):
+        """ returns list of ports """
+        return self._ports    
+
+    @property
+    def baudrates(self):
+        """ returns list of baudrates """
+        if self.ser_open:
+            if max(self.ser.BAUDRATES) <= 115200:
+                # add higher baudrates to the list
+                return (self.ser.BAUDRATES + (230400, 250000, 460800, 500000, 921600, 1000000, 2000000))
+            return self.ser.BAUDRATES
+        else:
+            return ()
+
+    @property
+    def connected(self):
+        """ return true if connected """
+        return self.ser_open
+
+    @property
+    def port(self):
+        """ returns current port """
+        if self.ser_open: return self._port
+        else: return ""
+        
+    @port.setter
+    def port(self, val):
+        """ sets serial port """
+        if (val is None) or  (val == ""):
+            self.logger.log(logging.WARNING, "[SER {}]: No port given {}.".format(int(QThread.currentThreadId()), val))
+            return
+        else:
+            # change the port, clears the buffers
+            if self.changeport(self, val, self.baud):
+                self.logger.log(logging.DEBUG, "[SER {}]: Port:{}.".format(int(QThread.currentThreadId()), val))
+                self._port = val
+            else:
+                self.logger.log(logging.ERROR, "[SER {}]: Failed to open port {}.".format(int(QThread.currentThreadId()), val))
+
+    @property
+    def baud(self):
+        """ returns current serial baudrate """
+        if self.ser_open: return self._baud
+        else: return -1
+        
+    @baud.setter
+    def baud(self, val):
+        """ sets serial baud rate """
+        if (val is None) or (val <= 0):
+            self.logger.log(logging.WARNING, "[SER {}]: Baudrate not changed to {}.".format(int(QThread.currentThreadId()), val))
+            return
+        if self.ser_open:
+            try:
+                self.ser.baudrate = val        # set new baudrate, termios2 for rates without B constant
+            except (OSError, ValueError) as e:
+                self.logger.log(logging.ERROR, "[SER {}]: Failed to set baudrate to {}: {}.".format(int(QThread.currentThreadId()), val, e))
+                try:
+                    self.ser.baudrate = self._baud
+                except (OSError, ValueError):
+                    pass
+                return
+            self._baud = self.achievedBaud() # rate the driver set
+            if self.tuned: self.tune()     # changing the rate resets VMIN
+            if abs(self._baud - val) <= BAUD_TOLERANCE*val: 
+                self.logger.log(logging.DEBUG, "[SER {}]: Baudrate:{}, achieved {}.".format(int(QThread.currentThreadId()), val, self._baud))
+            else:
+                self.logger.log(logging.ERROR, "[SER {}]: Failed to set baudrate to {}, achieved {}.".format(int(QThread.currentThreadId()), val, self._baud))
+            # clear buffers
+            self.ser.reset_input_buffer()
+            self.ser.reset_output_buffer()
+        else:
+            self.logger.log(logging.ERROR, "[SER {}]: Failed to set baudrate, serial port not open!".format(int(QThread.currentThreadId())))
+
+    @property
+    def eol(self):
+        """ returns current line termination """
+        return self._eol
+        
+    @eol.setter
+    def eol(self, val):
+        """ sets serial ioWrapper line termination """
+        if (val is None):
+            self.logger.log(logging.WARNING, "[SER {}]: EOL not changed, need to provide string.".format(int(QThread.currentThreadId())))
+            return
+        else:
+            self._eol = val
+            # self._eol = ""
+            self.logger.log(logging.ERROR, "[SER {}]: EOL: {}".format(int(QThread.currentThreadId()), repr(val)))
+
+    @property
+    def timeout(self):
+        """ returns current serial timeout """
+        return self._timeout
+
+    def dsrReady(self) -> bool:
+        """ DSR/DTR flow control, device is ready to receive, ports without modem lines always are """
+        try:
+            return self.ser.dsr
+        except OSError:
+            return True
+
+    def setDtr(self, ready: bool):
+        """ DSR/DTR flow control, tell device whether we are ready to receive """
+        try:
+            self.ser.dtr = ready
+        except OSError:
+            pass
+
+    @property
+    def flowControl(self):
+        """ returns current flow control """
+        return self._flowControl
+
+    @flowControl.setter
+    def flowControl(self, val):
+        """ sets flow control, open port is changed in place """
+        self._flowControl = val
+        if self.ser_open:
+            try:
+                self.ser.rtscts  = val == "RTS/CTS"
+                self.ser.dsrdtr  = val == "DSR/DTR"
+                self.ser.xonxoff = val == "XON/XOFF"
+                if val == "DSR/DTR": self.setDtr(True)                                     # ready to receive
+                if self.tuned: self.tune()                                                 # reconfiguring resets VMIN
+            except (OSError, ValueError) as e:
+                self.logger.log(logging.ERROR, "[SER {}]: Failed to set flow control {}: {}.".format(int(QThread.currentThreadId()), val, e))
+
+#####################################################################################
+# Testing
+#####################################################################################
+
+if __name__ == '__main__':
+    # Round trip time of transactions over a pty with an echo peer, standard and low latency profile
+    import pty, tty
+    from PyQt5.QtCore import QCoreApplication
+    logging.basicConfig(level=logging.WARNING)
+    logger = logging.getLogger("QSerial")
+    app = QCoreApplication(sys.argv)
+
+    m, s = pty.openpty()
+    tty.setraw(m); tty.setraw(s)
+    def echo():
+        while True:
+            try:
+                os.write(m, os.read(m, 4096))
+            except OSError:
+                return                                                                     # pty closed
+    threading.Thread(target=echo, daemon=True).start()
+
+    rtt = {}
+    for lowLatency in (False, True):
+        worker = QSerial()
+        worker.on_setupReceiverRequest()
+        worker.on_changeLineTerminationRequest(b'\r\n')
+        worker.on_changeLatencyRequest(lowLatency, 0, LOW_LATENCY_VMIN)
+        worker.on_changePortRequest(os.ttyname(s), DEFAULT_BAUDRATE)
+        assert worker.PSer.ser_open
+        worker.on_startReceiverRequest()
+        worker.transactionsFinished.connect(app.quit)
+        worker.on_changeTransactionRequest("re:^ping (?P<seq>\\d+)", 1000., 1)
+        worker.on_sendTransactionRequest(b'ping {seq}', 200)
+        QTimer.singleShot(30000, app.quit)
+        app.exec_()
+        assert worker.transactions.numDone == 200, worker.transactions.summary()
+        rtt[lowLatency] = worker.transactions.latency.percentile(50)/1e6
+        worker.on_stopReceiverRequest()
+        worker.PSer.close()
+        logger.log(logging.WARNING, "{} profile, {}".format("low latency" if lowLatency else "standard", worker.transactions.summary()))
+    assert rtt[True] < rtt[False], rtt
+    logger.log(logging.WARNING, "pty echo RTT p50 standard {:.2f} ms, low latency {:.2f} ms".format(rtt[False], rtt[True]))
+
+    # Transactions without line termination, replies in raw text split at newline or in COBS packets
+    for termination, framing in ((b'', ""), (b'', "cobs")):
+        worker = QSerial()
+        worker.on_setupReceiverRequest()
+        worker.on_changeLineTerminationRequest(termination)
+        worker.on_changeFramingRequest(framing)
+        worker.on_changePortRequest(os.ttyname(s), DEFAULT_BAUDRATE)
+        assert worker.PSer.ser_open
+        worker.on_startReceiverRequest()
+        worker.transactionsFinished.connect(app.quit)
+        worker.on_changeTransactionRequest("re:^ping (?P<seq>\\d+)$", 1000., 4)
+        worker.on_sendTransactionRequest(b'ping {seq}', 200)
+        QTimer.singleShot(30000, app.quit)
+        app.exec_()
+        assert worker.transactions.numDone == 200, worker.transactions.summary()
+        worker.on_stopReceiverRequest()
+        worker.PSer.close()
+        logger.log(logging.WARNING, "{} transactions, {}".format(framing or "text", worker.transactions.summary()))
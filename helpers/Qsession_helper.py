@@ -0,0 +1,149 @@
+############################################################################################
+# QT Session Helper
+############################################################################################
+# October 2026: acquisition from several serial ports on one time axis
+# ------------------------------------------------------------------------------------------
+# Urs Utzinger
+# University of Arizona 2026
+############################################################################################
+############################################################################################
+# QSessionUI: Tools menu entries and a dockable table with per port counters.
+# The ports are opened, merged and recorded by QSession in Qsessionrecorder_helper.
+############################################################################################
+
+import logging
+
+from PyQt5.QtCore    import QObject, QTimer, QThread, pyqtSlot, Qt, QStandardPaths
+from PyQt5.QtWidgets import QDockWidget, QTableWidget, QTableWidgetItem, QHeaderView, QFileDialog, QInputDialog
+
+import numpy as np
+
+from helpers.Qsessionrecorder_helper import SESSION_INTERVAL, parse_ports, QSession
+
+# Constants
+########################################################################################
+SESSION_COLUMNS  = ("port", "baud", "kB/s", "rows/s", "rows", "lost %", "errors", "clock")
+
+############################################################################################
+# QSessionUI interaction with Graphical User Interface
+############################################################################################
+
+class QSessionUI(QObject):
+    """
+    Multi Port Session Interface for QT
+
+    The session uses line termination of the serial monitor and data separator, time column
+    and sequence column of the chart. The chart shows one trace per port.
+
+    Slots (functions available to respond to external signals)
+        on_actionStartSession()          user selected ports and recording file, start session
+        on_actionStopSession()           stop session, close ports
+        on_sessionTimer()                update per port counters
+    """
+
+    def __init__(self, parent=None, ui=None, serialUI=None, chartUI=None):
+        super(QSessionUI, self).__init__(parent)
+
+        self.logger = logging.getLogger("QSessUI")
+
+        if ui is None:
+            self.logger.log(logging.ERROR, "[{}]: Need to have access to User Interface".format(int(QThread.currentThreadId())))
+        self.ui       = ui
+        self.serialUI = serialUI
+        self.chartUI  = chartUI
+        self.session  = None
+
+        # Dockable table, one row per port
+        self.table = QTableWidget(0, len(SESSION_COLUMNS))
+        self.table.setHorizontalHeaderLabels(SESSION_COLUMNS)
+        self.table.verticalHeader().setVisible(False)
+        self.table.horizontalHeader().setSectionResizeMode(QHeaderView.Stretch)
+        self.table.setEditTriggers(QTableWidget.NoEditTriggers)
+        self.dock = QDockWidget("Session", self.ui)
+        self.dock.setObjectName("dockWidget_Session")
+        self.dock.setWidget(self.table)
+        self.ui.addDockWidget(Qt.BottomDockWidgetArea, self.dock)
+        self.dock.hide()
+
+        self.sessionTimer = QTimer(self)
+        self.sessionTimer.timeout.connect(self.on_sessionTimer)
+
+        self.logger.log(logging.INFO, "[{}]: Initialized.".format(int(QThread.currentThreadId())))
+
+    @pyqtSlot()
+    def on_actionStartSession(self):
+        """
+        Open several ports, plot one channel of each and optionally record all of them
+        """
+        if self.session is not None:
+            self.ui.statusBar().showMessage('Session is running.', 2000)
+            return
+        if self.serialUI.receiverIsRunning:
+            self.ui.statusBar().showMessage('Stop serial monitor and chart first.', 2000)
+            return
+        current = "{}@{}".format(self.serialUI.serialPort, self.serialUI.serialBaudRate) if self.serialUI.serialPort else ""
+        text, ok = QInputDialog.getText(self.ui, "Multi Port Session",
+                                        "Ports with optional baud rate, e.g. /dev/ttyUSB0@115200, /dev/ttyUSB1", text=current)
+        if not ok:
+            return
+        try:
+            ports = parse_ports(text, self.serialUI.defaultBaudRate)
+        except ValueError as e:
+            self.ui.statusBar().showMessage('Ports: {}.'.format(e), 5000)
+            return
+        if self.serialUI.serialPort in [p for p, _ in ports]:
+            self.serialUI.closePortRequest.emit()                                          # port is opened by session worker
+        stdFileName = QStandardPaths.writableLocation(QStandardPaths.DocumentsLocation) + "/session.csv"
+        fname, _ = QFileDialog.getSaveFileName(self.ui, 'Record session to (cancel for no recording)', stdFileName, "CSV files (*.csv)")
+
+        chart = self.chartUI
+        self.session = QSession(separator=chart.textDataSeparator,
+                                timeColumn=chart.timeColumn, timeUnit=chart.deviceClock.unit,
+                                timeBits=int(np.log2(chart.deviceClock.wrap)) if chart.deviceClock.wrap else 0,
+                                sequenceColumn=chart.sequenceColumn, modulo=chart.sequence.modulo)
+        self.session.dataReady.connect(chart.on_sessionDataReceived)
+        try:
+            self.session.record(fname)
+        except OSError:
+            self.ui.statusBar().showMessage('Could not open recording file.', 2000)
+        eol = self.serialUI.textLineTerminator if self.serialUI.textLineTerminator else b'\r\n'
+        self.session.open(ports, eol)
+        chart.startSession([p for p, _ in ports])
+        self.session.start()
+        self.table.setRowCount(0)
+        self.dock.show()
+        self.sessionTimer.start(SESSION_INTERVAL)
+        self.ui.statusBar().showMessage('Session with {} ports started.'.format(len(ports)), 2000)
+
+    @pyqtSlot()
+    def on_actionStopSession(self):
+        """
+        Stop receivers, finish workers and close recording
+        """
+        if self.session is None:
+            return
+        self.sessionTimer.stop()
+        self.on_sessionTimer()
+        self.session.stop()
+        self.session.close()
+        self.session.dataReady.disconnect(self.chartUI.on_sessionDataReceived)
+        self.chartUI.stopSession()
+        self.session = None
+        self.ui.statusBar().showMessage('Session stopped.', 2000)
+
+    @pyqtSlot()
+    def on_sessionTimer(self):
+        """ show per port counters """
+        if self.session is None:
+            return
+        rows = self.session.stats()
+        self.table.setRowCount(len(rows))
+        for row, stats in enumerate(rows):
+            for col, key in enumerate(SESSION_COLUMNS):
+                value = stats[key]
+                text = value if isinstance(value, str) else str(value) if isinstance(value, int) else "{:.4g}".format(value)
+                item = self.table.item(row, col)
+                if item is None:
+                    self.table.setItem(row, col, QTableWidgetItem(text))
+                else:
+                    item.setText(text)
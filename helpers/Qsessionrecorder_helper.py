@@ -0,0 +1,374 @@
+############################################################################################
+# QT Session Recorder Helper
+############################################################################################
+# October 2026: acquisition from several serial ports on one time axis
+# ------------------------------------------------------------------------------------------
+# Urs Utzinger
+# University of Arizona 2026
+############################################################################################
+############################################################################################
+# A session receives lines from several serial ports at once. Each port has its own QSerial
+# worker in its own QThread with its own framer and line buffer, a slow or stalled port does
+# not hold up the others. The lines of each port are parsed in the main thread when they
+# arrive and every row is placed on one time axis, seconds since the session was created:
+#   without time column     host time the worker read the batch, the rows of a batch are
+#                           spread evenly since the previous batch of the same port
+#   with time column        device timestamp of each row converted to host time with a
+#                           DeviceClock per port (see Codec_helper)
+#
+# The chart shows one channel of each port as its own trace. The recording has one row per
+# received row: time, port number, values. Rows are held until every port delivered later
+# rows, at most REORDER_WINDOW, and are then written and plotted in time order. Rows that
+# reach the main thread later than that, e.g. while it is blocked, are counted as late and
+# written when they arrive.
+#
+# This code has 2 sections
+# QPortSession: one port, forwards requests to its worker and parses its lines
+# QSession: opens the ports, merges their rows, records them. No widgets, used by headless.
+# The user interface QSessionUI is in Qsession_helper.
+############################################################################################
+
+import logging, time, sys, io
+
+from PyQt5.QtCore    import QObject, QTimer, QThread, QCoreApplication, pyqtSignal, pyqtSlot, Qt
+
+import numpy as np
+
+from helpers.Qserialport_helper import QSerial, DEFAULT_BAUDRATE
+from helpers.Codec_helper       import lines_to_array, SequenceCounter, DeviceClock, TIME_UNITS
+from helpers.Profiler_helper    import metrics
+
+# Constants
+########################################################################################
+SESSION_INTERVAL = 1000                                                                    # [ms] counters update
+STOP_TIMEOUT     = 2000                                                                    # [ms] wait for worker thread to finish
+REORDER_WINDOW   = 0.1                                                                     # [s] rows are held at most this long to merge them in time order
+
+STAGE_PARSE    = metrics.stage("parse")
+STAGE_SEQUENCE = metrics.stage("sequence")                                                 # lines are checked rows, errors are lost rows
+
+def parse_ports(text: str, baud: int = DEFAULT_BAUDRATE) -> list:
+    """
+    "COM3@115200, /dev/ttyUSB1" to [("COM3", 115200), ("/dev/ttyUSB1", baud)]
+    Raises ValueError
+    """
+    ports = []
+    for item in text.replace(';', ',').split(','):
+        item = item.strip()
+        if not item:
+            continue
+        port, _, rate = item.partition('@')
+        ports.append((port.strip(), int(rate) if rate.strip() else baud))
+    if not ports:
+        raise ValueError("no serial port")
+    return ports
+
+############################################################################################
+# QPortSession one port of a session
+############################################################################################
+
+class QPortSession(QObject):
+    """
+    One port of a session, lives in the main thread, its worker in its own thread
+
+    Signals (to its worker)
+        setupReceiverRequest, changeLineTerminationRequest, changePortRequest, serialStatusRequest,
+        startReceiverRequest, stopReceiverRequest, startThroughputRequest, stopThroughputRequest,
+        finishWorkerRequest
+
+    Slots (functions available to respond to external signals)
+        on_linesReceived(list, float)    parse lines and add them to the session
+        on_throughputReady(int, int)     update bytes and rows per second
+        on_serialStatusReady(str, int, bytes, float) port was opened or could not be opened
+    """
+
+    setupReceiverRequest         = pyqtSignal()
+    changeLineTerminationRequest = pyqtSignal(bytes)
+    changePortRequest            = pyqtSignal(str, int)
+    serialStatusRequest          = pyqtSignal()
+    startReceiverRequest         = pyqtSignal()
+    stopReceiverRequest          = pyqtSignal()
+    startThroughputRequest       = pyqtSignal()
+    stopThroughputRequest        = pyqtSignal()
+    finishWorkerRequest          = pyqtSignal()
+
+    def __init__(self, session, index: int, port: str, baud: int, eol: bytes, parent=None):
+        super(QPortSession, self).__init__(parent)
+
+        self.logger = logging.getLogger("QPortSe")
+
+        self.session  = session
+        self.index    = index                                                              # port number in merged data
+        self.port     = port
+        self.baud     = baud
+        self.isOpen   = False
+        self.sequence = SequenceCounter(session.modulo)
+        self.clock    = DeviceClock(session.timeUnit, session.timeBits)
+        self.lastArrival    = None                                                         # [s] perf_counter of previous batch
+        self.lastTime       = -np.inf                                                      # [s] session time of newest row
+        self.numRows        = 0
+        self.numErrors      = 0
+        self.lastNumRows    = 0
+        self.lastNumBytes   = 0
+        self.rowsPerSecond  = 0.
+        self.bytesPerSecond = 0.
+
+        # worker in its own thread, same connections as the main window makes for the single port
+        self.thread = QThread()
+        self.thread.start()
+        self.worker = QSerial()
+        self.worker.finished.connect(             self.thread.quit, Qt.DirectConnection   ) # main thread might be waiting for thread
+        self.worker.finished.connect(             self.worker.deleteLater                 )
+        self.rxQueue = self.worker.connectReceiver("lines", self.on_linesReceived)          # batches not yet merged
+        self.worker.throughputReady.connect(      self.on_throughputReady                 )
+        self.worker.serialStatusReady.connect(    self.on_serialStatusReady               )
+        self.setupReceiverRequest.connect(        self.worker.on_setupReceiverRequest     )
+        self.changeLineTerminationRequest.connect(self.worker.on_changeLineTerminationRequest)
+        self.changePortRequest.connect(           self.worker.on_changePortRequest        )
+        self.serialStatusRequest.connect(         self.worker.on_serialStatusRequest      )
+        self.startReceiverRequest.connect(        self.worker.on_startReceiverRequest     )
+        self.stopReceiverRequest.connect(         self.worker.on_stopReceiverRequest      )
+        self.startThroughputRequest.connect(      self.worker.on_startThroughputRequest   )
+        self.stopThroughputRequest.connect(       self.worker.on_stopThroughputRequest    )
+        self.finishWorkerRequest.connect(         self.worker.on_stopWorkerRequest        )
+        self.worker.moveToThread(self.thread)
+
+        self.setupReceiverRequest.emit()
+        self.changeLineTerminationRequest.emit(eol)
+        self.changePortRequest.emit(port, baud)
+        self.serialStatusRequest.emit()
+
+    @pyqtSlot(str, int, bytes, float)
+    def on_serialStatusReady(self, port: str, baud: int, eol: bytes, timeout: float):
+        self.isOpen = port != ""
+        if self.isOpen:
+            self.baud = baud
+        else:
+            self.logger.log(logging.ERROR, "[{}]: Could not open {}.".format(int(QThread.currentThreadId()), self.port))
+
+    @pyqtSlot(list, float)
+    def on_linesReceived(self, lines: list, arrival: float):
+        tic = time.perf_counter_ns()
+        data_array, num_errors = lines_to_array(lines, self.session.separator)
+        toc = time.perf_counter_ns()
+        STAGE_PARSE.queue = self.rxQueue.get()
+        STAGE_PARSE.add(lines=len(lines), samples=data_array.size, ns=toc-tic, errors=num_errors)
+        self.numErrors += num_errors
+        self.session.merge(self, data_array, arrival)
+
+    @pyqtSlot(int, int)
+    def on_throughputReady(self, numReceived: int, numSent: int):
+        self.bytesPerSecond = max(numReceived - self.lastNumBytes, 0)*1000./SESSION_INTERVAL
+        self.rowsPerSecond  = (self.numRows - self.lastNumRows)*1000./SESSION_INTERVAL
+        self.lastNumBytes   = numReceived
+        self.lastNumRows    = self.numRows
+
+    def stop(self):
+        """ finish worker and wait for its thread """
+        self.finishWorkerRequest.emit()
+        if not self.thread.wait(STOP_TIMEOUT):
+            self.logger.log(logging.WARNING, "[{}]: Worker of {} did not finish.".format(int(QThread.currentThreadId()), self.port))
+            self.thread.quit()
+
+    def stats(self) -> dict:
+        return {
+            "port":   self.port,
+            "baud":   self.baud if self.isOpen else "closed",
+            "kB/s":   self.bytesPerSecond/1000.,
+            "rows/s": self.rowsPerSecond,
+            "rows":   self.numRows,
+            "lost %": 100.*self.sequence.lossRate,
+            "errors": self.numErrors,
+            "clock":  "{:+.1f} ppm".format(self.clock.drift*1e6) if self.session.timeColumn >= 0 else "host",
+        }
+
+############################################################################################
+# QSession merges several ports
+############################################################################################
+
+class QSession(QObject):
+    """
+    Acquisition from several serial ports
+
+    open(ports, eol)                     list of (port, baud), each gets a worker thread
+    start(), stop()                      start/stop receivers of all ports
+    close()                              finish all workers, close recording
+    record(file name)                    write merged rows: time, port, values, - for stdout
+    flush(everything)                    write and plot rows that can no longer be preceded by rows of other ports
+    portSessions                         QPortSession of each port
+    numLate                              rows written after rows with a later time
+
+    Signals
+        dataReady(time, array)           time [s] of new rows, one column per port with the chart
+                                         channel of that port, nan in the columns of other ports
+    """
+
+    dataReady = pyqtSignal(object, object)
+
+    def __init__(self, parent=None, separator: bytes = b',', channel: int = 0,
+                 timeColumn: int = -1, timeUnit: float = TIME_UNITS["us"], timeBits: int = 32,
+                 sequenceColumn: int = -1, modulo: int = 0):
+        super(QSession, self).__init__(parent)
+
+        self.logger = logging.getLogger("QSessio")
+
+        self.separator      = separator
+        self.channel        = channel                                                      # value column of each port shown in chart
+        self.timeColumn     = timeColumn                                                   # device timestamp column, -1 for arrival time
+        self.timeUnit       = timeUnit
+        self.timeBits       = timeBits
+        self.sequenceColumn = sequenceColumn                                               # sequence number column, -1 for none
+        self.modulo         = modulo
+        self.timeOrigin     = time.perf_counter()
+        self.portSessions   = []
+        self.fh             = None                                                         # merged recording
+        self.numRecorded    = 0
+        self.pending        = []                                                           # (time, port index, values) not yet in time order
+        self.lastWritten    = -np.inf                                                      # [s] time of newest written row
+        self.numLate        = 0
+
+        self.flushTimer = QTimer(self)                                                     # quiet ports do not hold back the others
+        self.flushTimer.timeout.connect(self.flush)
+
+    def open(self, ports: list, eol: bytes = b'\r\n'):
+        for port, baud in ports:
+            self.portSessions.append(QPortSession(self, len(self.portSessions), port, baud, eol))
+        self.logger.log(logging.INFO, "[{}]: Opening {}.".format(int(QThread.currentThreadId()), ", ".join(p for p, _ in ports)))
+
+    def start(self):
+        for p in self.portSessions:
+            p.sequence.reset()
+            p.clock.reset()
+            p.lastArrival = None
+            p.lastTime = -np.inf
+            p.startReceiverRequest.emit()
+            p.startThroughputRequest.emit()
+        self.flushTimer.start(int(REORDER_WINDOW*500))
+
+    def stop(self):
+        for p in self.portSessions:
+            p.stopReceiverRequest.emit()
+            p.stopThroughputRequest.emit()
+
+    def close(self):
+        self.flushTimer.stop()
+        for p in self.portSessions:
+            p.stop()
+            self.logger.log(logging.INFO, "[{}]: {} {} rows, {}, {} parse errors.".format(
+                int(QThread.currentThreadId()), p.port, p.numRows, p.sequence.summary(), p.numErrors))
+        for p in self.portSessions:
+            QCoreApplication.sendPostedEvents(p)                                           # batches the stopped worker emitted
+        self.flush(everything=True)
+        if self.numLate:
+            self.logger.log(logging.WARNING, "[{}]: {} rows arrived after the reorder window.".format(int(QThread.currentThreadId()), self.numLate))
+        self.portSessions = []
+        self.record("")
+
+    def record(self, fname: str):
+        """ start writing merged rows to file, empty name stops recording """
+        if self.fh is not None and self.fh is not sys.stdout.buffer:
+            self.fh.close()
+        self.fh = None
+        if fname:
+            self.fh = sys.stdout.buffer if fname == "-" else open(fname, 'wb')
+            self.numRecorded = 0
+
+    def merge(self, portSession, data_array: np.ndarray, now: float):
+        """ place rows of one port, read at now, on the session time axis and queue them for flush """
+        num_rows, num_cols = data_array.shape
+        if num_rows == 0:
+            return
+        columns = []
+        if 0 <= self.timeColumn < num_cols:
+            t = portSession.clock.update(data_array[:, self.timeColumn], now)
+            columns.append(self.timeColumn)
+        else:
+            last = portSession.lastArrival if portSession.lastArrival is not None else now
+            t = last + (now - last)*np.arange(1, num_rows + 1)/num_rows
+        portSession.lastArrival = now
+        if 0 <= self.sequenceColumn < num_cols:
+            lost = portSession.sequence.numLost
+            portSession.sequence.check(data_array[:, self.sequenceColumn])
+            STAGE_SEQUENCE.add(lines=num_rows, errors=portSession.sequence.numLost - lost)
+            columns.append(self.sequenceColumn)
+        if columns:
+            data_array = np.delete(data_array, columns, axis=1)
+        t = t - self.timeOrigin
+        portSession.numRows += num_rows
+        portSession.lastTime = max(portSession.lastTime, t.max())
+        self.pending.append((t, portSession.index, data_array))
+        self.flush()
+
+    @pyqtSlot()
+    def flush(self, everything: bool = False):
+        """
+        Write and plot pending rows in time order
+        Rows up to the oldest newest row of all ports are complete, a port without data
+        holds back the others for at most REORDER_WINDOW
+        """
+        if not self.pending:
+            return
+        if everything:
+            watermark = np.inf
+        else:
+            watermark = max(min((p.lastTime for p in self.portSessions), default=np.inf),
+                            time.perf_counter() - self.timeOrigin - REORDER_WINDOW)
+        ready, keep = [], []
+        for t, index, data_array in self.pending:
+            mask = t <= watermark
+            if mask.all():
+                ready.append((t, index, data_array))
+            elif mask.any():
+                ready.append((t[mask], index, data_array[mask]))
+                keep.append((t[~mask], index, data_array[~mask]))
+            else:
+                keep.append((t, index, data_array))
+        self.pending = keep
+        if not ready:
+            return
+        t = np.concatenate([r[0] for r in ready])
+        order = np.argsort(t, kind='stable')                                               # rows of one port keep their order
+        t = t[order]
+        self.numLate += int(np.count_nonzero(t < self.lastWritten))
+        self.lastWritten = max(self.lastWritten, t[-1])
+        if self.fh is not None:
+            # ports can have different numbers of values, rows are formatted per port and then interleaved
+            lines = []
+            for rt, index, data_array in ready:
+                buffer = io.BytesIO()
+                np.savetxt(buffer, np.hstack([rt.reshape(-1, 1), np.full((rt.size, 1), index), data_array]), delimiter=',', fmt='%.10g')
+                lines.extend(buffer.getvalue().splitlines(keepends=True))
+            try:
+                self.fh.write(b''.join([lines[i] for i in order]))
+                if self.fh is sys.stdout.buffer:
+                    self.fh.flush()
+                self.numRecorded += t.size
+            except OSError:
+                self.logger.log(logging.ERROR, "[{}]: Could not write recording.".format(int(QThread.currentThreadId())))
+                self.record("")
+        if self.portSessions:
+            ports  = np.concatenate([np.full(rt.size, index) for rt, index, _ in ready])[order]
+            values = np.concatenate([data_array[:, self.channel] if self.channel < data_array.shape[1] else np.full(rt.size, np.nan)
+                                     for rt, _, data_array in ready])[order]
+            valid  = ~np.isnan(values)
+            if valid.any():
+                merged = np.full((int(np.count_nonzero(valid)), len(self.portSessions)), np.nan)
+                merged[np.arange(merged.shape[0]), ports[valid]] = values[valid]
+                self.dataReady.emit(t[valid], merged)
+
+    def stats(self) -> list:
+        return [p.stats() for p in self.portSessions]
+
+#####################################################################################
+# Testing
+#####################################################################################
+
+if __name__ == '__main__':
+    logging.basicConfig(level=logging.DEBUG)
+    assert parse_ports("COM3@115200, /dev/ttyUSB1", 9600) == [("COM3", 115200), ("/dev/ttyUSB1", 9600)]
+    for bad in ("", "COM3@fast"):
+        try:
+            parse_ports(bad)
+            assert False
+        except ValueError as e:
+            logging.getLogger("QSessio").log(logging.INFO, "expected error {}".format(e))
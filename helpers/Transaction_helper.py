@@ -0,0 +1,193 @@
+############################################################################################
+# Transaction Helper
+############################################################################################
+# October 2026: request/response transactions with round trip statistics
+# ------------------------------------------------------------------------------------------
+# Urs Utzinger
+# University of Arizona 2026
+############################################################################################
+############################################################################################
+# This code has no QT dependencies.
+#
+# Many devices answer each command with one reply line. A transaction is a command and
+# the reply that matches it. The reply is recognized with a regular expression:
+#
+#   OK              (prefix) reply starts with OK, replies are assigned to the oldest
+#                   outstanding command, the device is expected to answer in order
+#   re:^(ACK|NAK)   regular expression, replies assigned in order as above
+#   re:^R(?P<seq>\d+)
+#                   regular expression with a group named seq, the reply is assigned to
+#                   the command with that sequence number, the device may answer out of order
+#
+# A {seq} in the command is replaced by the sequence number of the transaction.
+#
+# Up to window transactions are in flight, further commands wait until a reply arrived
+# or a transaction timed out. The tracker does not block, the caller transmits what
+# ready() returns, feeds received lines to match() and calls expire() at nextDeadline.
+############################################################################################
+
+import logging, re, time
+from collections import deque, OrderedDict
+from math import inf
+
+from helpers.Profiler_helper import LatencyHistogram
+
+# Constants
+########################################################################################
+DEFAULT_REPLY   = "OK"                                                                     # reply prefix
+DEFAULT_TIMEOUT = 1000.                                                                    # [ms]
+DEFAULT_WINDOW  = 1                                                                        # transactions in flight
+
+logger = logging.getLogger("Transa_")
+
+############################################################################################
+# Transaction Tracker
+############################################################################################
+
+def compile_reply(reply: str):
+    """ prefix or re:regular expression to compiled bytes pattern """
+    if reply.startswith("re:"):
+        return re.compile(reply[3:].encode('utf-8'))
+    return re.compile(b'^' + re.escape(reply.encode('utf-8')))                           # NOK or echoed command is no reply
+
+class TransactionTracker():
+    """
+    Keeps track of outstanding transactions
+
+    submit(command, count)            queue command count times
+    ready(now)                        commands that can be transmitted now, in flight from now on
+    match(lines, now)                 assign replies, returns completed (seq, command, reply, rtt [s])
+    expire(now)                       returns timed out (seq, command, b'', -1.)
+    nextDeadline                      [s] perf_counter when the oldest transaction times out
+    latency                           histogram of round trip times [ns]
+    """
+
+    def __init__(self, reply: str = DEFAULT_REPLY, timeout: float = DEFAULT_TIMEOUT, window: int = DEFAULT_WINDOW):
+        self.configure(reply, timeout, window)
+
+    def configure(self, reply: str, timeout: float, window: int):
+        """ reply matching, timeout [ms] and number of transactions in flight """
+        self.pattern   = compile_reply(reply)                                              # raises re.error
+        self.bySeq     = 'seq' in self.pattern.groupindex
+        self.timeout   = timeout/1000.
+        self.window    = max(int(window), 1)
+        self.pending   = deque()                                                           # commands not yet sent
+        self.inFlight  = OrderedDict()                                                     # seq: (command, sent time), oldest first
+        self.seq       = 0
+        self.latency   = LatencyHistogram()
+        self.numDone   = 0
+        self.numTimeouts = 0
+        self.startTime = 0.
+        self.lastTime  = 0.
+
+    def submit(self, command: bytes, count: int = 1):
+        """ queue command, {seq} is replaced with sequence number when sent """
+        if not self.busy:
+            self.latency.reset()
+            self.numDone, self.numTimeouts = 0, 0
+            self.startTime = time.perf_counter()
+        self.pending.extend([command]*count)
+
+    @property
+    def busy(self) -> bool:
+        return bool(self.pending) or bool(self.inFlight)
+
+    def ready(self, now: float) -> list:
+        """ commands that fit into the window """
+        out = []
+        while self.pending and len(self.inFlight) < self.window:
+            self.seq += 1
+            command = self.pending.popleft().replace(b'{seq}', str(self.seq).encode())
+            self.inFlight[self.seq] = (command, now)
+            out.append(command)
+        return out
+
+    def match(self, lines: list, now: float) -> list:
+        """ assign reply lines to transactions in flight """
+        done = []
+        if not self.inFlight:
+            return done
+        for line in lines:
+            m = self.pattern.search(line)
+            if m is None:
+                continue
+            if self.bySeq:
+                try:
+                    seq = int(m.group('seq'))
+                except (TypeError, ValueError):
+                    continue
+                if seq not in self.inFlight:
+                    continue                                                               # late reply of expired transaction
+                command, sent = self.inFlight.pop(seq)
+            else:
+                seq, (command, sent) = self.inFlight.popitem(last=False)
+            rtt = now - sent
+            self.latency.record(int(rtt*1e9))
+            done.append((seq, command, line, rtt))
+            if not self.inFlight:
+                break
+        self.numDone += len(done)
+        if done: self.lastTime = now
+        return done
+
+    def expire(self, now: float) -> list:
+        """ remove transactions that did not receive a reply within timeout """
+        expired = []
+        while self.inFlight:
+            seq, (command, sent) = next(iter(self.inFlight.items()))
+            if now - sent < self.timeout:
+                break
+            self.inFlight.popitem(last=False)
+            expired.append((seq, command, b'', -1.))
+        self.numTimeouts += len(expired)
+        if expired: self.lastTime = now
+        return expired
+
+    @property
+    def nextDeadline(self) -> float:
+        if self.inFlight:
+            return next(iter(self.inFlight.values()))[1] + self.timeout
+        return inf
+
+    def clear(self):
+        self.pending.clear()
+        self.inFlight.clear()
+
+    def summary(self) -> str:
+        """ completed, timeouts, rate and round trip time """
+        duration = self.lastTime - self.startTime
+        rate = (self.numDone + self.numTimeouts)/duration if duration > 0 else 0.
+        return "{} replies, {} timeouts, {:.0f}/s, RTT p50 {:.2f} p99 {:.2f} max {:.2f} ms".format(
+            self.numDone, self.numTimeouts, rate,
+            self.latency.percentile(50)/1e6, self.latency.percentile(99)/1e6, self.latency.max/1e6)
+
+#####################################################################################
+# Testing
+#####################################################################################
+
+if __name__ == '__main__':
+    logging.basicConfig(level=logging.DEBUG)
+
+    t = TransactionTracker("OK", timeout=10., window=2)
+    t.submit(b'get', 3)
+    assert t.ready(0.) == [b'get', b'get'] and t.ready(0.) == []
+    done = t.match([b'noise', b'OK 1'], 0.001)
+    assert len(done) == 1 and done[0][0] == 1 and abs(done[0][3] - 0.001) < 1e-9
+    assert t.ready(0.001) == [b'get']
+    assert t.expire(0.005) == [] and t.nextDeadline == 0.01
+    assert [e[0] for e in t.expire(0.02)] == [2, 3] and not t.busy
+    logger.log(logging.INFO, "in order ok")
+
+    t = TransactionTracker("OK", timeout=10., window=1)
+    t.submit(b'set OK')
+    assert t.ready(0.) == [b'set OK']
+    assert t.match([b'NOK', b'set OK'], 0.001) == [] and t.busy                          # not anchored would match both
+    assert [d[2] for d in t.match([b'OK'], 0.002)] == [b'OK']
+    logger.log(logging.INFO, "prefix ok")
+
+    t = TransactionTracker("re:^R(?P<seq>\\d+)", timeout=10., window=4)
+    t.submit(b'read {seq}', 3)
+    assert t.ready(0.) == [b'read 1', b'read 2', b'read 3']
+    done = t.match([b'R3 x', b'R1 y', b'R7 z'], 0.002)
+    assert [d[0] for d in done] == [3, 1] and list(t.inFlight) == [2]
+    logger.log(logging.INFO, "sequence ok, {}".format(t.summary()))
@@ -0,0 +1,228 @@
+############################################################################################
+# Transmit Helper
+############################################################################################
+# October 2026: paced transmit queue with priority lanes
+# ------------------------------------------------------------------------------------------
+# Urs Utzinger
+# University of Arizona 2026
+############################################################################################
+############################################################################################
+# This code has no QT dependencies.
+#
+# TxQueue: data waiting to be transmitted, in lanes of different priority.
+#   Commands typed by the user are in the interactive lane and are transmitted
+#   ahead of bulk transfers (sent text, lines, files).
+#   Data is taken from the queue limited by a number of bytes and a number of lines,
+#   what the port did not accept is returned to the front of its lane.
+#
+# TokenBucket: limits the transmit rate in bytes/s or lines/s.
+#   Small microcontroller receive buffers overrun when a large block of data arrives
+#   at full baud rate, pacing gives the device time to process each line.
+#
+# Usage:
+#   queue  = TxQueue(eol=b'\r\n')
+#   bucket = TokenBucket(rate=100, lines=True)
+#   queue.put(b'help\r\n', LANE_INTERACTIVE)
+#   ...
+#   data, lane = queue.get(maxBytes, bucket.available(now) if bucket.lines else inf)
+#   l = port.write(data)
+#   queue.unget(data[l:], lane)
+#   bucket.consume(queue.count(data[:l]) if bucket.lines else l)
+############################################################################################
+
+import logging, time
+from collections import deque
+from math import inf
+
+# Constants
+########################################################################################
+LANE_INTERACTIVE = 0                                                                       # commands typed by user
+LANE_BULK        = 1                                                                       # text and lines sent by program
+LANE_FILE        = 2                                                                       # file transfer
+NUM_LANES        = 3
+BURST_TIME       = 0.02                                                                    # [s] token bucket holds this much transmit time
+
+logger = logging.getLogger("Transm_")
+
+############################################################################################
+# Token Bucket
+############################################################################################
+
+class TokenBucket():
+    """
+    Token bucket rate limiter
+
+    Tokens (bytes or lines) are added at rate per second up to the bucket size,
+    transmitting consumes tokens. A rate of 0 does not limit.
+    """
+
+    def __init__(self, rate: float = 0., lines: bool = False):
+        self.setRate(rate, lines)
+
+    def setRate(self, rate: float, lines: bool = False):
+        """ set tokens per second, lines selects lines/s instead of bytes/s """
+        self.rate   = max(rate, 0.)
+        self.lines  = lines
+        self.size   = max(self.rate*BURST_TIME, 1.)                                        # at least one line or byte
+        self.tokens = self.size
+        self.last   = time.perf_counter()
+
+    def available(self, now: float = None) -> float:
+        """ refill and return available tokens """
+        if self.rate <= 0.:
+            return inf
+        if now is None: now = time.perf_counter()
+        self.tokens = min(self.tokens + (now - self.last)*self.rate, self.size)
+        self.last   = now
+        return self.tokens
+
+    def consume(self, n: float):
+        """ use tokens """
+        if self.rate > 0.:
+            self.tokens -= n
+
+############################################################################################
+# Transmit Queue
+############################################################################################
+
+class TxQueue():
+    """
+    Transmit queue with priority lanes
+
+    The lowest lane number is served first. An item that was partially transmitted
+    is completed before any other item of the same lane.
+    """
+
+    def __init__(self, eol: bytes = b'\r\n'):
+        self.lanes    = [deque() for _ in range(NUM_LANES)]
+        self.numBytes = [0]*NUM_LANES                                                      # queued bytes per lane
+        self.numLines = [0]*NUM_LANES                                                      # queued lines per lane
+        self.eol      = eol
+
+    @property
+    def eol(self) -> bytes:
+        return self._eol
+
+    @eol.setter
+    def eol(self, value: bytes):
+        # without line termination lines are counted at newline
+        self._eol = value if value else b'\n'
+
+    def count(self, data: bytes) -> int:
+        """ number of lines in data """
+        return data.count(self._eol)
+
+    def put(self, data: bytes, lane: int = LANE_BULK):
+        """ append data to lane """
+        if data:
+            self.lanes[lane].append(data)
+            self.numBytes[lane] += len(data)
+            self.numLines[lane] += self.count(data)
+
+    def unget(self, data: bytes, lane: int):
+        """ return data that was not transmitted to front of its lane """
+        if data:
+            self.lanes[lane].appendleft(data)
+            self.numBytes[lane] += len(data)
+            self.numLines[lane] += self.count(data)
+
+    def get(self, maxBytes: int, maxLines: float = inf):
+        """
+        Take up to maxBytes and maxLines from the highest priority lane that has data.
+        When lines are limited data is cut after the last complete line, data without
+        line termination is not limited by lines.
+        Returns (bytes, lane), empty bytes if nothing can be transmitted.
+        """
+        for lane, items in enumerate(self.lanes):
+            if items:
+                break
+        else:
+            return b'', LANE_BULK
+        if maxBytes <= 0 or maxLines < 1:
+            return b'', lane
+        data = items.popleft()
+        if len(data) > maxBytes:
+            items.appendleft(data[maxBytes:])
+            data = data[:maxBytes]
+        if maxLines != inf:
+            # find end of the allowed number of lines
+            n, end, le = int(maxLines), 0, len(self._eol)
+            while n > 0:
+                i = data.find(self._eol, end)
+                if i < 0:
+                    break
+                end = i + le
+                n  -= 1
+            if n == 0 and end < len(data):
+                items.appendleft(data[end:])
+                data = data[:end]
+        self.numBytes[lane] -= len(data)
+        if items:
+            self.numLines[lane] = max(self.numLines[lane] - self.count(data), 0)
+        else:
+            self.numLines[lane] = 0                                                        # line termination might have been split
+        return data, lane
+
+    def clear(self, lane: int = None):
+        """ remove data of one or all lanes """
+        for i in (range(NUM_LANES) if lane is None else (lane,)):
+            self.lanes[i].clear()
+            self.numBytes[i] = 0
+            self.numLines[i] = 0
+
+    @property
+    def depth(self) -> int:
+        """ queued bytes """
+        return sum(self.numBytes)
+
+    @property
+    def lines(self) -> int:
+        """ queued lines """
+        return sum(self.numLines)
+
+    @property
+    def numItems(self) -> int:
+        return sum(len(items) for items in self.lanes)
+
+    def __bool__(self) -> bool:
+        return any(self.lanes)
+
+    def drainTime(self, bytesPerSecond: float, linesPerSecond: float = 0., extraBytes: int = 0) -> float:
+        """ [s] time to transmit queued data (and extraBytes not yet queued) at given rates """
+        t = (self.depth + extraBytes)/bytesPerSecond if bytesPerSecond > 0 else 0.
+        if linesPerSecond > 0:
+            t = max(t, self.lines/linesPerSecond)
+        return t
+
+#####################################################################################
+# Testing
+#####################################################################################
+
+if __name__ == '__main__':
+    logging.basicConfig(level=logging.DEBUG)
+
+    q = TxQueue(eol=b'\r\n')
+    q.put(b'a\r\nb\r\nc\r\n', LANE_BULK)
+    q.put(b'cmd\r\n', LANE_INTERACTIVE)
+    assert q.depth == 14 and q.lines == 4
+    data, lane = q.get(100)
+    assert data == b'cmd\r\n' and lane == LANE_INTERACTIVE
+    data, lane = q.get(100, 2)
+    assert data == b'a\r\nb\r\n' and lane == LANE_BULK and q.lines == 1
+    data, lane = q.get(2)
+    assert data == b'c\r'
+    q.unget(data[1:], lane)
+    data, lane = q.get(100)
+    assert data == b'\r' and q.depth == 1
+    data, lane = q.get(100)
+    assert data == b'\n' and not q and q.depth == 0 and q.lines == 0
+    logger.log(logging.INFO, "queue ok")
+
+    b = TokenBucket(rate=1000.)
+    t0 = b.last
+    assert abs(b.available(t0) - 20.) < 1e-9
+    b.consume(20)
+    assert abs(b.available(t0 + 0.005) - 5.) < 1e-9
+    b = TokenBucket(rate=0.)
+    assert b.available() == inf
+    logger.log(logging.INFO, "token bucket ok")
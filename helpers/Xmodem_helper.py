@@ -0,0 +1,406 @@
+############################################################################################
+# XMODEM Helper
+############################################################################################
+# October 2026: XMODEM-CRC, XMODEM-1K and YMODEM batch upload
+# ------------------------------------------------------------------------------------------
+# Urs Utzinger
+# University of Arizona 2026
+############################################################################################
+############################################################################################
+# This code has no QT dependencies.
+#
+# XmodemSender: uploads files with a block transfer protocol, e.g. to a boot loader.
+#   It does not read or write the port and never blocks. The caller feeds received bytes
+#   with feed() and transmits what poll() returns, QSerial does this on a timer so that
+#   the port remains open and the user interface responsive during the upload.
+#
+#   XMODEM-CRC   128 byte blocks with CRC-16, falls back to 8 bit checksum if the
+#                receiver starts with NAK instead of C
+#   XMODEM-1K    1024 byte blocks with CRC-16, short last block uses 128 bytes
+#   YMODEM       XMODEM-1K with a header block containing file name and size,
+#                several files in one batch
+#
+#   With window 1 every block waits for its ACK (standard). A larger window sends up
+#   to window blocks before the first ACK arrived, receivers that read from a buffered
+#   stream accept this and the upload is no longer limited by the round trip time.
+#   A NAK or timeout goes back to the oldest block that was not acknowledged.
+#
+# XmodemReceiver: receiving side, used to test the sender over a pty pair.
+############################################################################################
+############################################################################################
+# Helpful readings:
+# ------------------------------------------------------------------------------------------
+# XMODEM/YMODEM protocol reference, Chuck Forsberg
+#      http://textfiles.com/programming/ymodem.txt
+############################################################################################
+
+import logging, time
+from binascii import crc_hqx                                                               # CRC-16 CCITT, polynomial 0x1021, as used by XMODEM
+
+# Constants
+########################################################################################
+SOH, STX, EOT, ACK, NAK, CAN, SUB = 0x01, 0x02, 0x04, 0x06, 0x15, 0x18, 0x1A
+CRC_REQUEST     = ord('C')
+PROTOCOLS       = ("XMODEM-CRC", "XMODEM-1K", "YMODEM")
+MAX_RETRIES     = 10                                                                       # per block
+BLOCK_TIMEOUT   = 3.                                                                       # [s] no ACK or NAK for this long, retransmit
+START_TIMEOUT   = 60.                                                                      # [s] receiver has to request transfer within this time
+
+logger = logging.getLogger("Xmodem_")
+
+def make_block(num: int, payload: bytes, size: int, crc: bool = True) -> bytes:
+    """ header, block number, complement, payload padded to size, CRC-16 or checksum """
+    data = payload.ljust(size, bytes([SUB])) if num != 0 else payload.ljust(size, b'\x00')
+    header = bytes([SOH if size == 128 else STX, num & 0xFF, 0xFF - (num & 0xFF)])
+    if crc:
+        return header + data + crc_hqx(data, 0).to_bytes(2, 'big')
+    return header + data + bytes([sum(data) & 0xFF])
+
+def make_header(name: str, size: int) -> bytes:
+    """ YMODEM block 0, empty name ends the batch """
+    if not name:
+        return make_block(0, b'', 128)
+    info = name.encode('utf-8') + b'\x00' + str(size).encode() + b'\x00'
+    return make_block(0, info, 128 if len(info) <= 128 else 1024)
+
+############################################################################################
+# Sender
+############################################################################################
+
+class XmodemSender():
+    """
+    Non blocking XMODEM/YMODEM sender
+
+    start(now)                        wait for receiver to request the transfer
+    feed(data, now)                   process bytes from receiver
+    poll(now)                         bytes to transmit, handles timeouts
+    cancel()                          abort, receiver is notified with CAN
+    finished, success, error          result
+    sent, total                       acknowledged and total payload bytes
+    numRetries                        retransmitted blocks
+    """
+
+    def __init__(self, files: list, protocol: str = "XMODEM-CRC", window: int = 1,
+                 retries: int = MAX_RETRIES, timeout: float = BLOCK_TIMEOUT):
+        if protocol not in PROTOCOLS:
+            raise ValueError("unknown protocol {}".format(protocol))
+        self.files      = files                                                            # list of (name, bytes)
+        self.batch      = protocol == "YMODEM"
+        self.blockSize  = 128 if protocol == "XMODEM-CRC" else 1024
+        self.crc        = True
+        self.window     = max(int(window), 1)
+        self.maxRetries = retries
+        self.timeout    = timeout
+        self.total      = sum(len(data) for _, data in files)
+        self.out        = bytearray()
+        self.start(time.perf_counter())
+
+    def start(self, now: float):
+        self.state      = "start"
+        self.fileIndx   = 0
+        self.blocks     = []                                                               # (packet, payload length) of current file
+        self.base       = 0                                                                # oldest block not acknowledged
+        self.next       = 0                                                                # next block to transmit
+        self.ignore     = 0                                                                # responses to blocks sent before going back
+        self.header     = b''
+        self.sent       = 0
+        self.numRetries = 0
+        self.retries    = 0
+        self.error      = ""
+        self.lastByte   = None
+        self.deadline   = now + START_TIMEOUT
+        self.out.clear()
+
+    @property
+    def finished(self) -> bool:
+        return self.state == "done"
+
+    @property
+    def success(self) -> bool:
+        return self.state == "done" and not self.error
+
+    def _fail(self, error: str, notify: bool = True):
+        if notify:
+            self.out += bytes([CAN]*8)
+        self.error = error
+        self.state = "done"
+
+    def cancel(self):
+        if not self.finished:
+            self._fail("cancelled")
+
+    def _prepareFile(self):
+        """ split current file into blocks """
+        data = self.files[self.fileIndx][1]
+        size = self.blockSize
+        self.blocks = []
+        for i, pos in enumerate(range(0, len(data), size), start=1):
+            payload = data[pos:pos+size]
+            blockSize = 128 if (size == 1024 and len(payload) <= 128) else size
+            self.blocks.append((make_block(i, payload, blockSize, self.crc), len(payload)))
+        self.base, self.next = 0, 0
+
+    def _sendHeader(self, now: float):
+        if self.fileIndx < len(self.files):
+            name, data = self.files[self.fileIndx]
+            self.header = make_header(name, len(data))
+            self.state  = "header"
+        else:
+            self.header = make_header("", 0)
+            self.state  = "end"
+        self.out += self.header
+        self.deadline = now + self.timeout
+
+    def _retry(self, now: float):
+        """ NAK or timeout, resend """
+        self.retries    += 1
+        self.numRetries += 1
+        if self.retries > self.maxRetries:
+            self._fail("too many retries")
+            return
+        if self.state == "data":
+            self.next = self.base
+            self.ignore = 0
+        elif self.state == "eot":
+            self.out.append(EOT)
+        elif self.state in ("header", "end"):
+            self.out += self.header
+        self.deadline = now + self.timeout
+
+    def feed(self, data: bytes, now: float):
+        """ process bytes from receiver """
+        for b in data:
+            if b == CAN and self.lastByte == CAN:
+                self._fail("cancelled by receiver", notify=False)
+            self.lastByte = b
+            if self.state == "start":
+                if b == CRC_REQUEST or (b == NAK and not self.batch):
+                    self.crc = b == CRC_REQUEST
+                    if self.batch:
+                        self._sendHeader(now)
+                    else:
+                        self._prepareFile()
+                        self.state = "data"
+                        self.deadline = now + self.timeout
+            elif self.state == "header":
+                if b == ACK:
+                    self.state, self.retries = "header ack", 0
+                elif b == NAK:
+                    self._retry(now)
+            elif self.state == "header ack":
+                if b == CRC_REQUEST:
+                    self._prepareFile()
+                    self.state = "data"
+                    self.deadline = now + self.timeout
+            elif self.state == "data":
+                if self.ignore > 0 and (b == ACK or b == NAK):
+                    self.ignore -= 1                                                       # receiver rejects blocks after the one it missed
+                elif b == ACK and self.base < self.next:
+                    self.sent    += self.blocks[self.base][1]
+                    self.base    += 1
+                    self.retries  = 0
+                    self.deadline = now + self.timeout
+                elif b == NAK:
+                    outstanding = self.next - self.base - 1
+                    self._retry(now)
+                    self.ignore = max(outstanding, 0)
+            elif self.state == "eot":
+                if b == ACK:
+                    self.retries = 0
+                    if self.batch:
+                        self.fileIndx += 1
+                        self.state = "next"
+                    else:
+                        self.state = "done"
+                elif b == NAK:
+                    self.out.append(EOT)                                                   # YMODEM receivers NAK the first EOT
+                    self.deadline = now + self.timeout
+            elif self.state == "next":
+                if b == CRC_REQUEST:
+                    self._sendHeader(now)
+            elif self.state == "end":
+                if b == ACK:
+                    self.state = "done"
+                elif b == NAK:
+                    self._retry(now)
+
+    def poll(self, now: float) -> bytes:
+        """ transmit blocks that fit into the window, handle timeouts """
+        if self.state == "start":
+            if now > self.deadline:
+                self._fail("receiver did not start transfer")
+        elif self.state in ("header", "header ack", "eot", "end", "data", "next"):
+            if now > self.deadline:
+                self._retry(now)
+        if self.state == "data":
+            while self.next < len(self.blocks) and self.next < self.base + self.window:
+                self.out += self.blocks[self.next][0]
+                self.next += 1
+            if self.base >= len(self.blocks):
+                self.out.append(EOT)
+                self.state = "eot"
+                self.deadline = now + self.timeout
+        out = bytes(self.out)
+        self.out.clear()
+        return out
+
+############################################################################################
+# Receiver
+############################################################################################
+
+class XmodemReceiver():
+    """
+    XMODEM/YMODEM receiver for testing
+
+    start()                           bytes requesting the transfer
+    feed(data)                        bytes to answer with
+    files                             list of (name, bytes) received
+    errorEvery                        reject every n-th block once to test retries
+    crc                               request CRC-16 with C, otherwise 8 bit checksum with NAK
+    """
+
+    def __init__(self, batch: bool = False, errorEvery: int = 0, crc: bool = True):
+        self.batch      = batch
+        self.crc        = crc or batch                                                     # YMODEM always uses CRC-16
+        self.errorEvery = errorEvery
+        self.files      = []
+        self.buffer     = bytearray()
+        self.data       = bytearray()
+        self.expected   = 0 if batch else 1
+        self.name, self.size = "", -1
+        self.numEot     = 0
+        self.numBlocks  = 0
+        self.done       = False
+
+    def start(self) -> bytes:
+        return bytes([CRC_REQUEST if self.crc else NAK])
+
+    def _finishFile(self):
+        data = bytes(self.data[:self.size]) if self.size >= 0 else bytes(self.data).rstrip(bytes([SUB]))
+        self.files.append((self.name, data))
+        self.data = bytearray()
+
+    def feed(self, data: bytes) -> bytes:
+        self.buffer += data
+        out = bytearray()
+        while self.buffer and not self.done:
+            head = self.buffer[0]
+            if head == EOT:
+                del self.buffer[0]
+                self.numEot += 1
+                if self.batch and self.numEot == 1:
+                    out.append(NAK)
+                    continue
+                self.numEot = 0
+                self._finishFile()
+                out.append(ACK)
+                if self.batch:
+                    self.expected = 0
+                    out.append(CRC_REQUEST)
+                else:
+                    self.done = True
+                continue
+            if head not in (SOH, STX):
+                del self.buffer[0]                                                         # noise
+                continue
+            size = 128 if head == SOH else 1024
+            length = size + (5 if self.crc else 4)
+            if len(self.buffer) < length:
+                break
+            block, self.buffer = bytes(self.buffer[:length]), self.buffer[length:]
+            num, payload = block[1], block[3:3+size]
+            if self.crc:
+                ok = block[2] == 0xFF - num and crc_hqx(payload, 0) == int.from_bytes(block[-2:], 'big')
+            else:
+                ok = block[2] == 0xFF - num and sum(payload) & 0xFF == block[-1]
+            self.numBlocks += 1
+            if ok and self.errorEvery and self.numBlocks % self.errorEvery == 0:
+                ok = False                                                                 # simulated transmission error
+            if not ok:
+                out.append(NAK)
+            elif num == (self.expected - 1) & 0xFF and self.expected > 1:
+                out.append(ACK)                                                            # duplicate
+            elif num != self.expected & 0xFF:
+                out.append(NAK)
+            elif self.batch and self.expected == 0:
+                name, _, rest = payload.partition(b'\x00')
+                out.append(ACK)
+                if not name:
+                    self.done = True
+                else:
+                    self.name = name.decode('utf-8')
+                    self.size = int(rest.split(b'\x00')[0].split(b' ')[0])
+                    self.expected = 1
+                    out.append(CRC_REQUEST)
+            else:
+                self.data += payload
+                self.expected += 1
+                out.append(ACK)
+        return bytes(out)
+
+#####################################################################################
+# Testing
+#####################################################################################
+
+if __name__ == '__main__':
+    import os, pty, tty, threading
+    logging.basicConfig(level=logging.DEBUG)
+
+    files = [("a.bin", os.urandom(3000)), ("b.bin", os.urandom(129)), ("empty.bin", b'')]
+
+    # in memory with transmission errors
+    for protocol, window in (("XMODEM-CRC", 1), ("XMODEM-1K", 4), ("YMODEM", 1), ("YMODEM", 8)):
+        sender   = XmodemSender(files if protocol == "YMODEM" else files[:1], protocol, window)
+        receiver = XmodemReceiver(batch=(protocol == "YMODEM"), errorEvery=3)
+        now = 0.
+        sender.feed(receiver.start(), now)
+        while not sender.finished:
+            now += 0.001
+            sender.feed(receiver.feed(sender.poll(now)), now)
+        assert sender.success, sender.error
+        assert receiver.files == (files if protocol == "YMODEM" else [("", files[0][1])])
+        assert sender.sent == sender.total and sender.numRetries > 0
+        logger.log(logging.INFO, "{} window {} ok, {} retries".format(protocol, window, sender.numRetries))
+
+    # first block lost, retry after block timeout, CRC-16 and checksum fallback
+    for protocol, crc in (("XMODEM-CRC", True), ("XMODEM-CRC", False), ("XMODEM-1K", True)):
+        sender   = XmodemSender(files[:1], protocol)
+        receiver = XmodemReceiver(crc=crc)
+        now = 0.
+        sender.feed(receiver.start(), now)
+        lost = sender.poll(now)                                                            # never reaches the receiver
+        assert sender.crc == crc and len(lost) == sender.blockSize + (5 if crc else 4)
+        out = b''
+        while not out and now < START_TIMEOUT:
+            now += 0.01
+            out = sender.poll(now)
+        retry = now
+        assert out == lost and retry <= BLOCK_TIMEOUT + 0.01, "retry after {:.2f} s".format(retry)
+        while not sender.finished:
+            sender.feed(receiver.feed(out), now)
+            now += 0.001
+            out = sender.poll(now)
+        assert sender.success and receiver.files == [("", files[0][1])] and sender.numRetries == 1
+        logger.log(logging.INFO, "{} {} lost first block ok, retry after {:.2f} s".format(protocol, "CRC-16" if crc else "checksum", retry))
+
+    # over pty pair, receiver in thread
+    m, s = pty.openpty()
+    tty.setraw(m); tty.setraw(s)
+    receiver = XmodemReceiver(batch=True)
+    def respond():
+        os.write(m, receiver.start())
+        while not receiver.done:
+            os.write(m, receiver.feed(os.read(m, 4096)))
+    threading.Thread(target=respond, daemon=True).start()
+    sender = XmodemSender(files, "YMODEM", window=4)
+    tic = time.perf_counter()
+    os.set_blocking(s, False)
+    while not sender.finished and time.perf_counter() - tic < 10:
+        try:
+            sender.feed(os.read(s, 4096), time.perf_counter())
+        except BlockingIOError:
+            time.sleep(0.0005)
+        out = sender.poll(time.perf_counter())
+        if out: os.write(s, out)
+    assert sender.success and receiver.files == files
+    logger.log(logging.INFO, "pty ok, {:.0f} kB/s".format(sender.total/(time.perf_counter() - tic)/1000))
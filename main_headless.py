@@ -0,0 +1,393 @@
+################################################################################################
+# Serial Communication Headless
+# =============================
+# Acquires data from a serial port without user interface.
+# With several ports, e.g. -p /dev/ttyUSB0,/dev/ttyUSB1@9600, each port has its own worker
+# thread and the rows of all ports are written as time, port number, values.
+# Received lines are parsed into numbers the same way as for the chart and are streamed as
+# comma separated values to a file or to stdout.
+# Uses the QSerial worker with a QCoreApplication event loop so that no widgets, pyqtgraph
+# or ui files are loaded.
+#
+# Urs Utzinger, 2022, 2023
+# University of Arizona
+################################################################################################
+
+# QT imports
+from PyQt5.QtCore import QCoreApplication, QTimer, QThread
+
+# System
+import logging
+import argparse
+import signal
+import sys
+import time
+
+# Numerical Math
+import numpy as np
+
+# Custom imports
+from helpers.Qserialport_helper      import QSerial, DEFAULT_BAUDRATE, LOW_LATENCY_VMIN
+from helpers.Xmodem_helper           import PROTOCOLS
+from helpers.Codec_helper            import lines_to_array, packets_to_array, parse_layout, SampleStream, SequenceCounter, DeviceClock, TIME_UNITS
+from helpers.Profiler_helper         import tracer, metrics, MetricsWriter, QueueCounter
+from helpers.Qsessionrecorder_helper import QSession, parse_ports
+
+# Constants
+########################################################################################
+LINE_TERMINATIONS = {                                                                      # command line name to line termination
+    "crlf": b'\r\n',
+    "lf":   b'\n',
+    "cr":   b'\r',
+    "lfcr": b'\n\r',
+    "none": b'',
+}
+FLOW_CONTROL = {                                                                           # command line name to flow control
+    "none":    "none",
+    "rtscts":  "RTS/CTS",
+    "dsrdtr":  "DSR/DTR",
+    "xonxoff": "XON/XOFF",
+}
+SEPARATORS = {                                                                             # command line name to data separator
+    "comma":     b',',
+    "semicolon": b';',
+    "point":     b'.',
+    "space":     b' ',
+}
+RAW_SAMPLES = {                                                                            # command line name to raw sample type
+    "u8":    "u1",
+    "i16":   "<i2",
+    "i16be": ">i2",
+    "i32":   "<i4",
+    "i32be": ">i4",
+    "f32":   "<f4",
+    "f32be": ">f4",
+}
+STAGE_PARSE = metrics.stage("parse")
+STAGE_SEQUENCE = metrics.stage("sequence")                                                 # lines are checked rows, errors are lost rows
+
+###########################################################################################
+# Recorder
+###########################################################################################
+
+class Recorder():
+    """
+    Writes received data to a file
+
+    Lines are parsed into numbers and written with a leading sample number,
+    same layout as the chart buffer and the chart save function.
+    With text enabled, lines are written as they were received.
+    Without line termination the raw bytes are written, or interleaved samples when a sample stream is given.
+    COBS or SLIP framed packets are converted into int16 samples or the channels of a packet layout,
+    or written as hex with text enabled.
+    A sequence number column is checked for gaps, the data is written unchanged.
+    With a device timestamp column the leading column is host time [s] since start instead.
+    """
+
+    def __init__(self, fh, separator: bytes = b',', text: bool = False, flush: bool = False, stop=None, layout=None, stream=None,
+                 sequenceColumn: int = -1, sequence=None, timeColumn: int = -1, clock=None):
+        self.logger        = logging.getLogger("Record_")
+        self.fh            = fh                                                            # binary file handle
+        self.stop          = stop                                                          # called when output can no longer be written
+        self.separator     = separator
+        self.text          = text
+        self.layout        = layout                                                        # PacketLayout or None
+        self.stream        = stream                                                        # SampleStream or None
+        self.sequenceColumn = sequenceColumn                                               # column with sequence number, -1 for none
+        self.sequence      = sequence                                                      # SequenceCounter
+        self.timeColumn    = timeColumn                                                    # column with device timestamp, -1 for none
+        self.clock         = clock                                                         # DeviceClock
+        self.timeOrigin    = time.perf_counter()
+        self.arrival       = self.timeOrigin                                               # [s] when the worker read the current batch
+        self.flush         = flush                                                         # flush after each batch (stdout)
+        self.sample_number = 0
+        self.numLines      = 0
+        self.rxQueues      = {kind: QueueCounter() for kind in ("lines", "text", "packets")}  # replaced by worker when connecting
+
+    def on_linesReceived(self, lines: list, arrival: float):
+        """ parse lines and append them to the output, arrival is when the worker read them """
+        self.arrival = arrival
+        STAGE_PARSE.queue = self.rxQueues["lines"].get()
+        try:
+            self.writeLines(lines)
+        except OSError:
+            # e.g. reader of stdout pipe went away
+            self.logger.log(logging.ERROR, "[{}]: Could not write output.".format(int(QThread.currentThreadId())))
+            if self.stop is not None: self.stop()
+
+    def on_packetsReceived(self, packets: list, arrival: float):
+        """ convert binary packets and append them to the output """
+        self.arrival = arrival
+        STAGE_PARSE.queue = self.rxQueues["packets"].get()
+        try:
+            if self.text:
+                self.writeLines([packet.hex(' ').encode() for packet in packets])
+            else:
+                if self.layout is None:
+                    data_array, num_errors = packets_to_array(packets)
+                else:
+                    data_array, num_errors = self.layout.decode(packets)
+                STAGE_PARSE.add(lines=len(packets), samples=data_array.size, errors=num_errors)
+                self.writeArray(data_array)
+        except OSError:
+            self.logger.log(logging.ERROR, "[{}]: Could not write output.".format(int(QThread.currentThreadId())))
+            if self.stop is not None: self.stop()
+
+    def on_textReceived(self, byte_array: bytes, arrival: float):
+        """ no line termination, write raw bytes or samples """
+        self.arrival = arrival
+        STAGE_PARSE.queue = self.rxQueues["text"].get()
+        try:
+            if self.stream is not None:
+                data_array = self.stream.decode(byte_array)
+                STAGE_PARSE.add(lines=data_array.shape[0], samples=data_array.size, nbytes=len(byte_array))
+                self.writeArray(data_array)
+                return
+            self.fh.write(byte_array)
+            if self.flush:
+                self.fh.flush()
+        except OSError:
+            self.logger.log(logging.ERROR, "[{}]: Could not write output.".format(int(QThread.currentThreadId())))
+            if self.stop is not None: self.stop()
+
+    def writeLines(self, lines: list):
+        """ write lines as text or as numbers """
+        if self.text:
+            self.fh.write(b'\n'.join(lines) + b'\n')
+            self.numLines += len(lines)
+            if self.flush:
+                self.fh.flush()
+        else:
+            data_array, num_errors = lines_to_array(lines, self.separator)
+            STAGE_PARSE.add(lines=len(lines), samples=data_array.size, errors=num_errors)
+            self.writeArray(data_array)
+
+    def writeArray(self, data_array: np.ndarray):
+        """ write rows of numbers with leading sample number """
+        num_rows = data_array.shape[0]
+        if num_rows == 0:
+            return
+        if 0 <= self.sequenceColumn < data_array.shape[1]:
+            lost = self.sequence.numLost
+            self.sequence.check(data_array[:, self.sequenceColumn])
+            STAGE_SEQUENCE.add(lines=num_rows, errors=self.sequence.numLost - lost)
+        if 0 <= self.timeColumn < data_array.shape[1]:
+            sample_numbers = (self.clock.update(data_array[:, self.timeColumn], self.arrival) - self.timeOrigin).reshape(-1, 1)
+        else:
+            sample_numbers = np.arange(self.sample_number, self.sample_number + num_rows).reshape(-1, 1)
+        self.sample_number += num_rows
+        np.savetxt(self.fh, np.hstack([sample_numbers, data_array]), delimiter=',', fmt='%.10g')
+        self.numLines += num_rows
+        if self.flush:
+            self.fh.flush()
+
+###########################################################################################
+# Headless Acquisition
+###########################################################################################
+
+def main(argv=None) -> int:
+
+    parser = argparse.ArgumentParser(description="Serial acquisition without user interface.")
+    parser.add_argument("-p", "--port",      help="serial port, e.g. /dev/ttyUSB0 or COM3, several as COM3,COM4@9600")
+    parser.add_argument("-b", "--baud",      type=int, default=DEFAULT_BAUDRATE, help="baud rate")
+    parser.add_argument("--autobaud",        action="store_true", help="detect baud rate of the received text before recording, -b is kept if nothing matches")
+    parser.add_argument("--no-reconnect",    action="store_true", help="stop when the port vanishes instead of reopening it when it reappears")
+    parser.add_argument("--flow",            choices=FLOW_CONTROL.keys(), default="none", help="flow control, the device pauses when the port buffer is full")
+    parser.add_argument("--low-latency",     action="store_true", help="read as soon as bytes arrive, set ASYNC_LOW_LATENCY, FTDI latency timer and VMIN")
+    parser.add_argument("--chunk",           type=int, default=0, help="with --low-latency read at most this many bytes at a time, 0 for all available")
+    parser.add_argument("--vmin",            type=int, default=LOW_LATENCY_VMIN, help="with --low-latency wake up when this many bytes arrived, fewer are read by the receiver timer")
+    parser.add_argument("-e", "--eol",       choices=LINE_TERMINATIONS.keys(), default="crlf", help="line termination")
+    parser.add_argument("-f", "--framing",   choices=("none", "cobs", "slip"), default="none", help="binary packets instead of lines, samples are int16")
+    parser.add_argument("-c", "--checksum",  choices=("none", "xor", "crc8", "crc16"), default="none", help="drop lines failing checksum suffix, xor is NMEA *hh")
+    parser.add_argument("--layout",          default="", help="packet fields, e.g. \"ax:i2 ay:i2 crc:u1; channels=ay; checksum=crc8\" or \"<hhhB; checksum=sum8\"")
+    parser.add_argument("--samples",         choices=RAW_SAMPLES.keys(), default="", help="with -e none record interleaved raw samples of this type")
+    parser.add_argument("--channels",        type=int, default=1, help="number of interleaved channels of --samples")
+    parser.add_argument("--sequence",        type=int, default=0, help="column with a number incremented for every line or packet, counts lost rows, 0 for none")
+    parser.add_argument("--modulo",          type=int, default=0, help="sequence number wraps around at, e.g. 65536 for uint16")
+    parser.add_argument("--time",            type=int, default=0, help="column with device timestamp, written as host time instead of sample number")
+    parser.add_argument("--time-unit",       choices=TIME_UNITS.keys(), default="us", help="unit of device timestamp")
+    parser.add_argument("--time-bits",       type=int, default=32, help="device timestamp wraps around at 2**bits, 0 for no wrap around")
+    parser.add_argument("-s", "--separator", choices=SEPARATORS.keys(), default="comma", help="data separator")
+    parser.add_argument("-o", "--output",    default="-", help="output file, - for stdout")
+    parser.add_argument("-d", "--duration",  type=float, default=0., help="seconds to record, 0 until interrupted")
+    parser.add_argument("-t", "--text",      action="store_true", help="record lines as text instead of numbers")
+    parser.add_argument("-l", "--list",      action="store_true", help="list serial ports and exit")
+    parser.add_argument("-m", "--macro",     default="", help="run macro file (send, wait, waitfor, loop) while recording")
+    parser.add_argument("--poll",            default="", help="send this line every --period ms")
+    parser.add_argument("--period",          type=float, default=100., help="period of --poll in ms")
+    parser.add_argument("--request",         default="", help="send command as transactions, {seq} is replaced by sequence number, with -e none replies are split at newline, with -f each packet is a reply")
+    parser.add_argument("--reply",           default="OK", help="reply prefix or re:regular expression, group (?P<seq>...) matches sequence number")
+    parser.add_argument("--count",           type=int, default=1, help="number of transactions")
+    parser.add_argument("--window",          type=int, default=1, help="transactions in flight")
+    parser.add_argument("--timeout",         type=float, default=1000., help="transaction timeout in ms")
+    parser.add_argument("-u", "--upload",    nargs="+", default=[], help="upload files, stops after upload unless --duration is given")
+    parser.add_argument("--protocol",        choices=PROTOCOLS, default="XMODEM-1K", help="upload protocol, YMODEM for several files")
+    parser.add_argument("--blocks",          type=int, default=1, help="upload blocks sent before acknowledge")
+    parser.add_argument("--metrics",         default="", help="append pipeline metrics every second to this .csv or .json file")
+    parser.add_argument("--trace",           default="", help="save Chrome trace of the receiver pipeline to this file")
+    parser.add_argument("--log",             default="WARNING", help="logging level")
+    args = parser.parse_args(argv)
+
+    logging.basicConfig(level=args.log.upper(), stream=sys.stderr)
+    logger = logging.getLogger("Headls_")
+
+    app = QCoreApplication(sys.argv if argv is None else [sys.argv[0]] + list(argv))
+
+    # Serial worker runs in the main thread, there is no user interface to keep responsive
+    serialWorker = QSerial()
+
+    if args.list:
+        for port, name in zip(serialWorker.serialPorts, serialWorker.serialPortNames):
+            print("{}\t{}".format(port, name))
+        return 0
+
+    if not args.port:
+        parser.error("need a serial port, use --list to find available ports")
+
+    try:
+        ports = parse_ports(args.port, args.baud)
+    except ValueError as e:
+        parser.error("port: {}".format(e))
+    if len(ports) > 1:
+        return session(app, args, ports, logger)
+    port, baud = ports[0]                                                                  # e.g. COM3@9600 or COM3,
+
+    layout = None
+    if args.layout:
+        try:
+            layout = parse_layout(args.layout)
+        except ValueError as e:
+            parser.error("layout: {}".format(e))
+
+    eol = LINE_TERMINATIONS[args.eol]
+    if args.output == "-":
+        fh = sys.stdout.buffer
+    else:
+        fh = open(args.output, 'wb')
+    recorder = Recorder(fh, separator=SEPARATORS[args.separator], text=args.text, flush=(args.output == "-"),
+                        stop=serialWorker.on_stopWorkerRequest, layout=layout,
+                        stream=SampleStream(RAW_SAMPLES[args.samples], args.channels) if args.samples else None,
+                        sequenceColumn=args.sequence - 1, sequence=SequenceCounter(args.modulo),
+                        timeColumn=args.time - 1, clock=DeviceClock(TIME_UNITS[args.time_unit], args.time_bits))
+
+    # Same sequence of requests as the user interface issues
+    serialWorker.on_setupReceiverRequest()
+    serialWorker.on_changeLineTerminationRequest(eol)
+    serialWorker.on_changeFramingRequest("" if args.framing == "none" else args.framing)
+    serialWorker.on_changeLineChecksumRequest("" if args.checksum == "none" else args.checksum)
+    serialWorker.on_changeFlowControlRequest(FLOW_CONTROL[args.flow])
+    serialWorker.on_changeLatencyRequest(args.low_latency, args.chunk if args.low_latency else 0, args.vmin)
+    serialWorker.on_changePortRequest(port, baud)
+    if not serialWorker.PSer.ser_open:
+        logger.log(logging.ERROR, "[{}]: Could not open {}.".format(int(QThread.currentThreadId()), port))
+        return 1
+    if args.autobaud:
+        serialWorker.autobaudFinished.connect(lambda baud, score: print("Baud rate: {} (score {:.2f})".format(baud, score), file=sys.stderr))
+        serialWorker.on_autobaudRequest()
+    serialWorker.on_changeReconnectRequest(not args.no_reconnect)
+    serialWorker.portLost.connect(lambda port: print("Port {} lost.".format(port), file=sys.stderr))
+    serialWorker.portReconnected.connect(lambda port, latency: print("Port {} reconnected after {:.0f} ms.".format(port, latency*1000), file=sys.stderr))
+    if args.no_reconnect:
+        serialWorker.portLost.connect(serialWorker.on_stopWorkerRequest)
+    recorder.rxQueues["lines"]   = serialWorker.connectReceiver("lines",   recorder.on_linesReceived)
+    recorder.rxQueues["text"]    = serialWorker.connectReceiver("text",    recorder.on_textReceived)
+    recorder.rxQueues["packets"] = serialWorker.connectReceiver("packets", recorder.on_packetsReceived)
+    serialWorker.finished.connect(app.quit)
+
+    # Stop on ctrl-c, on duration or when the output pipe is closed
+    signal.signal(signal.SIGINT,  lambda *_: serialWorker.on_stopWorkerRequest())
+    signal.signal(signal.SIGTERM, lambda *_: serialWorker.on_stopWorkerRequest())
+    signalTimer = QTimer()
+    signalTimer.timeout.connect(lambda: None)                                              # let python handle signals
+    signalTimer.start(200)
+    if args.duration > 0:
+        QTimer.singleShot(int(args.duration*1000), serialWorker.on_stopWorkerRequest)
+
+    if args.trace:
+        tracer.start()
+    if args.metrics:
+        metricsWriter = MetricsWriter(args.metrics)
+        metricsTimer = QTimer()
+        metricsTimer.timeout.connect(lambda: metricsWriter.write(metrics.snapshot()))
+        metricsTimer.start(1000)
+    serialWorker.on_startReceiverRequest()
+    if args.poll:
+        serialWorker.on_startThroughputRequest()                                           # jitter is reported with throughput
+        serialWorker.periodicStatsReady.connect(lambda period, jitter, jitterMax, missed: logger.log(logging.INFO,
+            "[{}]: Period {:.3f} ms jitter p99 {:.3f} max {:.3f} ms, missed {}.".format(
+            int(QThread.currentThreadId()), period*1000, jitter*1000, jitterMax*1000, missed)))
+        serialWorker.on_startPeriodicRequest(args.poll.encode('utf-8'), args.period)
+    if args.request:
+        serialWorker.transactionsFinished.connect(lambda summary: print(summary, file=sys.stderr))
+        serialWorker.on_changeTransactionRequest(args.reply, args.timeout, args.window)
+        serialWorker.on_sendTransactionRequest(args.request.encode('utf-8'), args.count)
+    uploadResult = []
+    if args.upload:
+        def uploadFinished(success: bool):
+            uploadResult.append(success)
+            if args.duration <= 0: serialWorker.on_stopWorkerRequest()
+        serialWorker.fileTransferFinished.connect(uploadFinished)
+        serialWorker.on_uploadFileRequest(args.upload, args.protocol, args.blocks)
+    if args.macro:
+        with open(args.macro, 'r', encoding='utf-8') as f:
+            serialWorker.macroStateChanged.connect(
+                lambda running, message: logger.log(logging.INFO, "[{}]: Macro {}.".format(int(QThread.currentThreadId()), message)))
+            serialWorker.on_startMacroRequest(f.read())
+    logger.log(logging.INFO, "[{}]: Recording {} at {} baud.".format(int(QThread.currentThreadId()), port, serialWorker.PSer.baud))
+
+    app.exec_()
+    if fh is not sys.stdout.buffer:
+        fh.close()
+    if args.trace:
+        tracer.save_chrome(args.trace)
+    if args.metrics:
+        metricsWriter.close()
+
+    logger.log(logging.INFO, "[{}]: Recorded {} lines.".format(int(QThread.currentThreadId()), recorder.numLines))
+    if args.sequence > 0:
+        print("Sequence: {}".format(recorder.sequence.summary()), file=sys.stderr)
+    if args.time > 0:
+        print("Device clock: {}".format(recorder.clock.summary()), file=sys.stderr)
+    if args.upload and uploadResult != [True]:
+        return 1
+    return 0
+
+def session(app, args, ports: list, logger) -> int:
+    """ several ports, each with its own worker thread, merged on one time axis """
+    if args.framing != "none" or args.checksum != "none" or args.layout or args.samples or args.text:
+        logger.log(logging.WARNING, "[{}]: Several ports record parsed lines only, framing, checksum, raw and text options are ignored.".format(
+            int(QThread.currentThreadId())))
+    session = QSession(separator=SEPARATORS[args.separator],
+                       timeColumn=args.time - 1, timeUnit=TIME_UNITS[args.time_unit], timeBits=args.time_bits,
+                       sequenceColumn=args.sequence - 1, modulo=args.modulo)
+    session.record(args.output)
+
+    signal.signal(signal.SIGINT,  lambda *_: app.quit())
+    signal.signal(signal.SIGTERM, lambda *_: app.quit())
+    signalTimer = QTimer()
+    signalTimer.timeout.connect(lambda: None)                                              # let python handle signals
+    signalTimer.start(200)
+    if args.duration > 0:
+        QTimer.singleShot(int(args.duration*1000), app.quit)
+    if args.metrics:
+        metricsWriter = MetricsWriter(args.metrics)
+        metricsTimer = QTimer()
+        metricsTimer.timeout.connect(lambda: metricsWriter.write(metrics.snapshot()))
+        metricsTimer.start(1000)
+
+    session.open(ports, LINE_TERMINATIONS[args.eol])
+    session.start()
+    app.exec_()
+    session.stop()
+    stats = session.stats()
+    session.close()
+    if args.metrics:
+        metricsWriter.close()
+
+    for port in stats:
+        print("{}: {} rows, {} errors, lost {:.3f}%, clock {}".format(
+            port["port"], port["rows"], port["errors"], port["lost %"], port["clock"]), file=sys.stderr)
+    return 0 if all(port["baud"] != "closed" for port in stats) else 1
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -13,7 +13,8 @@
 # QT imports
 from PyQt5 import QtCore, QtWidgets, QtGui, uic
 from PyQt5.QtCore import QThread, QTimer
-from PyQt5.QtWidgets import QMainWindow, QLineEdit, QSlider, QMessageBox, QDialog, QVBoxLayout, QTextEdit
+from PyQt5.QtWidgets import QMainWindow, QLineEdit, QSlider, QMessageBox, QDialog, QVBoxLayout, QTextEdit, QFileDialog
+from PyQt5.QtCore import QStandardPaths
 from PyQt5.QtGui import QIcon
 
 # Markdown for documentation
@@ -25,8 +26,12 @@ import os
 from datetime import datetime
 
 # Custom imports
-from helpers.Qserial_helper     import QSerial, QSerialUI
+from helpers.Qserial_helper     import QSerialUI
+from helpers.Qserialport_helper import QSerial
 from helpers.Qgraph_helper      import QChartUI, MAX_ROWS
+from helpers.Profiler_helper    import tracer
+from helpers.Qprofiler_helper   import QMetricsUI, QLagMonitor
+from helpers.Qsession_helper    import QSessionUI
 
 # QT
 # Deal with high resolution displays
@@ -94,13 +99,21 @@ class mainWindow(QMainWindow):
 
         # Signals from Serial to Serial-UI
         # ---------------------------------
-        self.serialWorker.textReceived.connect(             self.serialUI.on_SerialReceivedText         ) # connect text display to serial receiver signal
-        self.serialWorker.linesReceived.connect(            self.serialUI.on_SerialReceivedLines         ) # connect text display to serial receiver signal
+        self.serialUI.connectDisplay()                                                                           # connect text display to serial receiver signals
         self.serialWorker.newPortListReady.connect(         self.serialUI.on_newPortListReady            ) # connect new port list to its ready signal
         self.serialWorker.newBaudListReady.connect(         self.serialUI.on_newBaudListReady            ) # connect new baud list to its ready signal
         self.serialWorker.serialStatusReady.connect(        self.serialUI.on_serialStatusReady           ) # connect display serial status to ready signal
         self.serialWorker.throughputReady.connect(          self.serialUI.on_throughputReceived          ) # connect display throughput status 
         self.serialWorker.serialWorkerStateChanged.connect( self.serialUI.on_serialWorkerStateChanged    ) # mirror serial worker state to serial UI
+        self.serialWorker.fileProgressReady.connect(        self.serialUI.on_fileProgressReady           ) # display file transfer progress
+        self.serialWorker.fileTransferFinished.connect(     self.serialUI.on_fileTransferFinished        ) # file transfer completed or stopped
+        self.serialWorker.txQueueReady.connect(             self.serialUI.on_txQueueReady                ) # display transmit queue depth
+        self.serialWorker.macroStateChanged.connect(        self.serialUI.on_macroStateChanged           ) # display macro state
+        self.serialWorker.transactionsFinished.connect(     self.serialUI.on_transactionsFinished        ) # display transaction statistics
+        self.serialWorker.periodicStatsReady.connect(       self.serialUI.on_periodicStatsReady          ) # display period and jitter
+        self.serialWorker.autobaudFinished.connect(         self.serialUI.on_autobaudFinished            ) # display detected baud rate
+        self.serialWorker.portLost.connect(                 self.serialUI.on_portLost                    ) # port vanished
+        self.serialWorker.portReconnected.connect(          self.serialUI.on_portReconnected             ) # port reopened
 
         # Signals from Serial-UI to Serial
         # ---------------------------------
@@ -108,6 +121,7 @@ class mainWindow(QMainWindow):
         self.serialUI.closePortRequest.connect(             self.serialWorker.on_closePortRequest        ) # connect close port
         self.serialUI.changeBaudRequest.connect(            self.serialWorker.on_changeBaudRateRequest   ) # connect changing baudrate
         self.serialUI.changeLineTerminationRequest.connect( self.serialWorker.on_changeLineTerminationRequest) # connect changing baudrate
+        self.serialUI.changeFramingRequest.connect(         self.serialWorker.on_changeFramingRequest    ) # connect changing binary framing
         self.serialUI.scanPortsRequest.connect(             self.serialWorker.on_scanPortsRequest        ) # connect request to scan ports
         self.serialUI.scanBaudRatesRequest.connect(         self.serialWorker.on_scanBaudRatesRequest    ) # connect request to scan baudrates
         self.serialUI.setupReceiverRequest.connect(         self.serialWorker.on_setupReceiverRequest    ) # connect start receiver
@@ -121,6 +135,21 @@ class mainWindow(QMainWindow):
         self.serialUI.startThroughputRequest.connect(       self.serialWorker.on_startThroughputRequest  ) # start throughput
         self.serialUI.stopThroughputRequest.connect(        self.serialWorker.on_stopThroughputRequest   ) # stop throughput
         self.serialUI.serialSendFileRequest.connect(        self.serialWorker.on_sendFileRequest         ) # send file to serial port
+        self.serialUI.cancelSendFileRequest.connect(        self.serialWorker.on_cancelSendFileRequest   ) # stop sending file
+        self.serialUI.changeTxRateRequest.connect(          self.serialWorker.on_changeTxRateRequest     ) # limit transmit rate
+        self.serialUI.changeTxChunkSizeRequest.connect(     self.serialWorker.on_changeTxChunkSizeRequest) # file transfer chunk size
+        self.serialUI.startMacroRequest.connect(            self.serialWorker.on_startMacroRequest       ) # run macro
+        self.serialUI.stopMacroRequest.connect(             self.serialWorker.on_stopMacroRequest        ) # stop macro
+        self.serialUI.changeTransactionRequest.connect(     self.serialWorker.on_changeTransactionRequest) # reply matching
+        self.serialUI.sendTransactionRequest.connect(       self.serialWorker.on_sendTransactionRequest  ) # send commands with replies
+        self.serialUI.startPeriodicRequest.connect(         self.serialWorker.on_startPeriodicRequest    ) # send line periodically
+        self.serialUI.stopPeriodicRequest.connect(          self.serialWorker.on_stopPeriodicRequest     ) # stop sending line periodically
+        self.serialUI.uploadFileRequest.connect(            self.serialWorker.on_uploadFileRequest       ) # XMODEM/YMODEM upload
+        self.serialUI.changeLineChecksumRequest.connect(    self.serialWorker.on_changeLineChecksumRequest) # validate checksum at end of lines
+        self.serialUI.autobaudRequest.connect(              self.serialWorker.on_autobaudRequest         ) # detect baud rate
+        self.serialUI.changeReconnectRequest.connect(       self.serialWorker.on_changeReconnectRequest  ) # reopen lost port
+        self.serialUI.changeLatencyRequest.connect(         self.serialWorker.on_changeLatencyRequest    ) # port profile
+        self.serialUI.changeFlowControlRequest.connect(     self.serialWorker.on_changeFlowControlRequest) # RTS/CTS, DSR/DTR, XON/XOFF
 
         # Prepare the Serial Worker and User Interface
         # --------------------------------------------
@@ -136,6 +165,8 @@ class mainWindow(QMainWindow):
                                                             self.serialUI.on_comboBoxDropDown_SerialPorts )
         self.ui.comboBoxDropDown_BaudRates.currentIndexChanged.connect(
                                                             self.serialUI.on_comboBoxDropDown_BaudRates   )
+        self.ui.comboBoxDropDown_BaudRates.lineEdit().returnPressed.connect(
+                                                            self.serialUI.on_comboBoxDropDown_BaudRates   ) # typed baud rate
         # User changed line termination
         self.ui.comboBoxDropDown_LineTermination.currentIndexChanged.connect( 
                                                             self.serialUI.on_comboBoxDropDown_LineTermination )
@@ -179,6 +210,20 @@ class mainWindow(QMainWindow):
 
         # Done with Plotter
         self.logger.log(logging.INFO, "[{}]: plotter initialized.".format(int(QThread.currentThreadId())))
+
+        #----------------------------------------------------------------------------------------------------------------------
+        # Pipeline Metrics
+        #----------------------------------------------------------------------------------------------------------------------
+        # Create dockable metrics panel, hidden until selected in the Tools menu
+        self.metricsUI = QMetricsUI(ui=self.ui)
+        # Measure main thread event loop lag, results are in status bar and metrics
+        self.lagMonitor = QLagMonitor(ui=self.ui)
+
+        #----------------------------------------------------------------------------------------------------------------------
+        # Multi Port Session
+        #----------------------------------------------------------------------------------------------------------------------
+        # Each port of a session has its own worker thread, dockable table is hidden until a session starts
+        self.sessionUI = QSessionUI(ui=self.ui, serialUI=self.serialUI, chartUI=self.chartUI)
         
         #----------------------------------------------------------------------------------------------------------------------
         # Menu Bar
@@ -186,6 +231,70 @@ class mainWindow(QMainWindow):
         # Connect the action_about action to the show_about_dialog slot
         self.ui.action_About.triggered.connect(self.show_about_dialog)
         self.ui.action_Help.triggered.connect(self.show_help_dialog)
+
+        # Tools menu, created here as the ui file only contains the Info menu
+        self.menuTools = self.ui.menubar.addMenu("Tools")
+        self.action_Trace = self.menuTools.addAction("Trace Pipeline")
+        self.action_Trace.setCheckable(True)
+        self.action_Trace.toggled.connect(self.on_actionTrace)
+        self.action_SaveTrace = self.menuTools.addAction("Save Trace...")
+        self.action_SaveTrace.triggered.connect(self.on_actionSaveTrace)
+        self.menuTools.addSeparator()
+        self.action_TxRate = self.menuTools.addAction("Transmit Rate...")
+        self.action_TxRate.triggered.connect(self.serialUI.on_actionTxRate)
+        self.action_TxChunkSize = self.menuTools.addAction("File Chunk Size...")
+        self.action_TxChunkSize.triggered.connect(self.serialUI.on_actionTxChunkSize)
+        self.action_RunMacro = self.menuTools.addAction("Run Macro...")
+        self.action_RunMacro.triggered.connect(self.serialUI.on_actionRunMacro)
+        self.action_StopMacro = self.menuTools.addAction("Stop Macro")
+        self.action_StopMacro.triggered.connect(self.serialUI.on_actionStopMacro)
+        self.action_Transactions = self.menuTools.addAction("Transactions...")
+        self.action_Transactions.triggered.connect(self.serialUI.on_actionTransactions)
+        self.action_Periodic = self.menuTools.addAction("Periodic Send...")
+        self.action_Periodic.triggered.connect(self.serialUI.on_actionPeriodic)
+        self.action_StopPeriodic = self.menuTools.addAction("Stop Periodic Send")
+        self.action_StopPeriodic.triggered.connect(self.serialUI.on_actionStopPeriodic)
+        self.action_Upload = self.menuTools.addAction("Upload XMODEM/YMODEM...")
+        self.action_Upload.triggered.connect(self.serialUI.on_actionUpload)
+        self.action_Autobaud = self.menuTools.addAction("Detect Baud Rate")
+        self.action_Autobaud.triggered.connect(self.serialUI.on_actionAutobaud)
+        self.action_AutoReconnect = self.menuTools.addAction("Auto Reconnect")
+        self.action_AutoReconnect.setCheckable(True)
+        self.action_AutoReconnect.setChecked(True)
+        self.action_AutoReconnect.toggled.connect(self.serialUI.on_actionAutoReconnect)
+        self.action_Latency = self.menuTools.addAction("Port Profile...")
+        self.action_Latency.triggered.connect(self.serialUI.on_actionLatency)
+        self.action_FlowControl = self.menuTools.addAction("Flow Control...")
+        self.action_FlowControl.triggered.connect(self.serialUI.on_actionFlowControl)
+        self.action_LineMonitor = self.menuTools.addAction("Line Monitor")
+        self.action_LineMonitor.setCheckable(True)
+        self.action_LineMonitor.toggled.connect(self.serialUI.on_actionLineMonitor)
+        self.action_LineChecksum = self.menuTools.addAction("Line Checksum...")
+        self.action_LineChecksum.triggered.connect(self.serialUI.on_actionLineChecksum)
+        self.action_PacketLayout = self.menuTools.addAction("Packet Layout...")
+        self.action_PacketLayout.triggered.connect(self.chartUI.on_actionPacketLayout)
+        self.action_RawSamples = self.menuTools.addAction("Raw Samples...")
+        self.action_RawSamples.triggered.connect(self.chartUI.on_actionRawSamples)
+        self.action_SequenceColumn = self.menuTools.addAction("Sequence Column...")
+        self.action_SequenceColumn.triggered.connect(self.chartUI.on_actionSequenceColumn)
+        self.action_TimeColumn = self.menuTools.addAction("Time Column...")
+        self.action_TimeColumn.triggered.connect(self.chartUI.on_actionTimeColumn)
+        self.action_StartSession = self.menuTools.addAction("Multi Port Session...")
+        self.action_StartSession.triggered.connect(self.sessionUI.on_actionStartSession)
+        self.action_StopSession = self.menuTools.addAction("Stop Session")
+        self.action_StopSession.triggered.connect(self.sessionUI.on_actionStopSession)
+        self.menuTools.addSeparator()
+        self.action_Metrics = self.metricsUI.dock.toggleViewAction()
+        self.action_Metrics.setText("Pipeline Metrics")
+        self.menuTools.addAction(self.action_Metrics)
+        self.action_MetricsLog = self.menuTools.addAction("Log Metrics...")
+        self.action_MetricsLog.setCheckable(True)
+        self.action_MetricsLog.toggled.connect(self.metricsUI.on_actionMetricsLog)
+        # Tracing can be started at launch with environment variable SERIALUI_TRACE=trace.json
+        # the trace is saved to that file when the program is closed
+        self.traceFileName = os.environ.get("SERIALUI_TRACE", "")
+        if self.traceFileName:
+            self.action_Trace.setChecked(True)
         
         #----------------------------------------------------------------------------------------------------------------------
         # Status Bar
@@ -199,6 +308,31 @@ class mainWindow(QMainWindow):
         #----------------------------------------------------------------------------------------------------------------------
         self.show() 
 
+    def on_actionTrace(self, checked: bool):
+        """ start or stop tracing of receiver and display pipeline """
+        if checked:
+            tracer.start()
+            self.ui.statusbar.showMessage('Tracing started.', 2000)
+        else:
+            tracer.stop()
+            self.ui.statusbar.showMessage('Tracing stopped, {} events recorded.'.format(tracer.numEvents), 2000)
+
+    def on_actionSaveTrace(self):
+        """ save trace in Chrome trace format """
+        stdFileName = QStandardPaths.writableLocation(QStandardPaths.DocumentsLocation) + "/trace.json"
+        fname, _ = QFileDialog.getSaveFileName(self, 'Save Trace as', stdFileName, "Chrome trace (*.json)")
+        if fname:
+            tracer.save_chrome(fname)
+            self.ui.statusbar.showMessage('Trace saved.', 2000)
+
+    def closeEvent(self, event):
+        """ save trace requested with SERIALUI_TRACE, stop session and lag watchdog """
+        self.sessionUI.on_actionStopSession()
+        if self.traceFileName and tracer.numEvents > 0:
+            tracer.save_chrome(self.traceFileName)
+        self.lagMonitor.stop()
+        event.accept()
+
     def on_resetStatusBar(self):
         now = datetime.now()
         formatted_date_time = now.strftime("%Y-%m-%d %H:%M")